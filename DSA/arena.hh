@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jade {
+
+// Bump allocator. Objects are carved out of large slabs and released all at
+// once when the arena dies. Destructors of non-trivially destructible objects
+// are recorded and run (in reverse creation order) before the slabs are freed.
+class Arena final {
+public:
+  static constexpr std::size_t kDefaultSlabSize = 4096;
+  static constexpr std::size_t kMaxSlabSize = 1 << 20;
+
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  Arena(Arena &&other) noexcept { *this = std::move(other); }
+  Arena &operator=(Arena &&other) noexcept {
+    if (this != &other) {
+      release();
+      m_slabs = std::move(other.m_slabs);
+      m_dtors = std::move(other.m_dtors);
+      m_cur = std::exchange(other.m_cur, nullptr);
+      m_end = std::exchange(other.m_end, nullptr);
+      m_allocated = std::exchange(other.m_allocated, 0);
+    }
+    return *this;
+  }
+
+  ~Arena() { release(); }
+
+  void *allocate(std::size_t size, std::size_t align) {
+    assert(align && (align & (align - 1)) == 0);
+
+    auto cur = reinterpret_cast<std::uintptr_t>(m_cur);
+    auto aligned = (cur + align - 1) & ~(std::uintptr_t(align) - 1);
+    if (!m_cur || aligned + size > reinterpret_cast<std::uintptr_t>(m_end)) {
+      newSlab(size + align);
+      cur = reinterpret_cast<std::uintptr_t>(m_cur);
+      aligned = (cur + align - 1) & ~(std::uintptr_t(align) - 1);
+    }
+
+    m_cur = reinterpret_cast<std::byte *>(aligned + size);
+    m_allocated += size;
+    return reinterpret_cast<void *>(aligned);
+  }
+
+  template <typename T, typename... Args> T *create(Args &&...args) {
+    auto *mem = allocate(sizeof(T), alignof(T));
+    auto *obj = new (mem) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      m_dtors.push_back({obj, [](void *ptr) { static_cast<T *>(ptr)->~T(); }});
+    }
+    return obj;
+  }
+
+  // Take over every allocation of other. Objects created in other stay valid
+  // and are now released together with this arena.
+  void merge(Arena &other) {
+    if (this == &other) {
+      return;
+    }
+
+    m_slabs.insert(m_slabs.end(), other.m_slabs.begin(), other.m_slabs.end());
+    m_dtors.insert(m_dtors.end(), other.m_dtors.begin(), other.m_dtors.end());
+    m_allocated += other.m_allocated;
+
+    other.m_slabs.clear();
+    other.m_dtors.clear();
+    other.m_cur = other.m_end = nullptr;
+    other.m_allocated = 0;
+  }
+
+  std::size_t bytesAllocated() const { return m_allocated; }
+  std::size_t slabsCount() const { return m_slabs.size(); }
+
+private:
+  struct Dtor {
+    void *obj;
+    void (*destroy)(void *);
+  };
+
+  void newSlab(std::size_t minSize) {
+    auto shift = std::min<std::size_t>(m_slabs.size() / 8, 8);
+    auto size = std::min(kDefaultSlabSize << shift, kMaxSlabSize);
+    size = std::max(size, minSize);
+
+    auto *slab = static_cast<std::byte *>(::operator new(size));
+    m_slabs.push_back(slab);
+    m_cur = slab;
+    m_end = slab + size;
+  }
+
+  void release() {
+    for (auto it = m_dtors.rbegin(); it != m_dtors.rend(); ++it) {
+      it->destroy(it->obj);
+    }
+    m_dtors.clear();
+
+    for (auto *slab : m_slabs) {
+      ::operator delete(slab);
+    }
+    m_slabs.clear();
+    m_cur = m_end = nullptr;
+    m_allocated = 0;
+  }
+
+private:
+  std::vector<std::byte *> m_slabs;
+  std::vector<Dtor> m_dtors;
+  std::byte *m_cur{nullptr};
+  std::byte *m_end{nullptr};
+  std::size_t m_allocated{0};
+};
+
+} // namespace jade
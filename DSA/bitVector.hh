@@ -0,0 +1,606 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define JADE_BITS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace jade {
+
+// Word kernels behind the set operations of BitVector. The AVX2 versions are
+// compiled with a target attribute and picked at runtime, so the library
+// still runs on machines without AVX2.
+namespace bitops {
+
+using Word = std::uint64_t;
+inline constexpr std::size_t kWordBits = 64;
+
+inline std::size_t popcount(Word word) { return __builtin_popcountll(word); }
+inline std::size_t countTrailingZeros(Word word) {
+  assert(word);
+  return __builtin_ctzll(word);
+}
+
+// dst op= src over n words; the result tells whether dst changed.
+struct Kernels {
+  bool (*orWords)(Word *dst, const Word *src, std::size_t n);
+  bool (*andWords)(Word *dst, const Word *src, std::size_t n);
+  bool (*andNotWords)(Word *dst, const Word *src, std::size_t n);
+  std::size_t (*countWords)(const Word *words, std::size_t n);
+};
+
+inline bool orScalar(Word *dst, const Word *src, std::size_t n) {
+  Word changed = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    changed |= src[i] & ~dst[i];
+    dst[i] |= src[i];
+  }
+  return changed;
+}
+
+inline bool andScalar(Word *dst, const Word *src, std::size_t n) {
+  Word changed = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    changed |= dst[i] & ~src[i];
+    dst[i] &= src[i];
+  }
+  return changed;
+}
+
+inline bool andNotScalar(Word *dst, const Word *src, std::size_t n) {
+  Word changed = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    changed |= dst[i] & src[i];
+    dst[i] &= ~src[i];
+  }
+  return changed;
+}
+
+inline std::size_t countScalar(const Word *words, std::size_t n) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    count += popcount(words[i]);
+  }
+  return count;
+}
+
+inline constexpr Kernels kScalarKernels = {orScalar, andScalar, andNotScalar,
+                                           countScalar};
+
+#ifdef JADE_BITS_AVX2
+namespace avx2 {
+
+__attribute__((target("avx2"))) inline __m256i load(const Word *ptr) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ptr));
+}
+
+__attribute__((target("avx2"))) inline void store(Word *ptr, __m256i val) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(ptr), val);
+}
+
+__attribute__((target("avx2"))) inline bool orWords(Word *dst,
+                                                    const Word *src,
+                                                    std::size_t n) {
+  auto changed = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto old = load(dst + i);
+    auto add = load(src + i);
+    changed = _mm256_or_si256(changed, _mm256_andnot_si256(old, add));
+    store(dst + i, _mm256_or_si256(old, add));
+  }
+  bool tail = orScalar(dst + i, src + i, n - i);
+  return tail || !_mm256_testz_si256(changed, changed);
+}
+
+__attribute__((target("avx2"))) inline bool andWords(Word *dst,
+                                                     const Word *src,
+                                                     std::size_t n) {
+  auto changed = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto old = load(dst + i);
+    auto mask = load(src + i);
+    changed = _mm256_or_si256(changed, _mm256_andnot_si256(mask, old));
+    store(dst + i, _mm256_and_si256(old, mask));
+  }
+  bool tail = andScalar(dst + i, src + i, n - i);
+  return tail || !_mm256_testz_si256(changed, changed);
+}
+
+__attribute__((target("avx2"))) inline bool andNotWords(Word *dst,
+                                                        const Word *src,
+                                                        std::size_t n) {
+  auto changed = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto old = load(dst + i);
+    auto mask = load(src + i);
+    changed = _mm256_or_si256(changed, _mm256_and_si256(old, mask));
+    store(dst + i, _mm256_andnot_si256(mask, old));
+  }
+  bool tail = andNotScalar(dst + i, src + i, n - i);
+  return tail || !_mm256_testz_si256(changed, changed);
+}
+
+// Nibble lookup popcount (Mula): per-byte counts summed with vpsadbw.
+__attribute__((target("avx2"))) inline std::size_t
+countWords(const Word *words, std::size_t n) {
+  const auto lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1,
+                       2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const auto lowMask = _mm256_set1_epi8(0x0f);
+  auto acc = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto val = load(words + i);
+    auto lo = _mm256_and_si256(val, lowMask);
+    auto hi = _mm256_and_si256(_mm256_srli_epi16(val, 4), lowMask);
+    auto bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                 _mm256_shuffle_epi8(lookup, hi));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+  }
+  Word lanes[4];
+  store(lanes, acc);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+         countScalar(words + i, n - i);
+}
+
+} // namespace avx2
+
+inline constexpr Kernels kAVX2Kernels = {avx2::orWords, avx2::andWords,
+                                         avx2::andNotWords, avx2::countWords};
+#endif
+
+// nullptr when the CPU has no AVX2
+inline const Kernels *avx2Kernels() {
+#ifdef JADE_BITS_AVX2
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported ? &kAVX2Kernels : nullptr;
+#else
+  return nullptr;
+#endif
+}
+
+inline const Kernels &kernels() {
+  static const Kernels &best =
+      avx2Kernels() ? *avx2Kernels() : kScalarKernels;
+  return best;
+}
+
+// Below this many words the scalar loop beats the indirect call.
+inline constexpr std::size_t kDispatchWords = 8;
+
+} // namespace bitops
+
+// Dense set of indices in [0, size()). Besides bit access it offers the
+// std::set style insert/erase/count, so it replaces sets of ids directly;
+// insert grows the vector when needed. Bits past size() are always zero.
+class BitVector {
+public:
+  using Word = bitops::Word;
+  static constexpr std::size_t kWordBits = bitops::kWordBits;
+
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::size_t *;
+    using reference = std::size_t;
+
+    const_iterator(const BitVector *bits, std::size_t idx)
+        : m_bits{bits}, m_idx{idx} {}
+
+    std::size_t operator*() const { return m_idx; }
+    const_iterator &operator++() {
+      m_idx = m_bits->findNext(m_idx + 1);
+      return *this;
+    }
+    bool operator==(const const_iterator &rhs) const {
+      return m_idx == rhs.m_idx;
+    }
+    bool operator!=(const const_iterator &rhs) const {
+      return m_idx != rhs.m_idx;
+    }
+
+  private:
+    const BitVector *m_bits;
+    std::size_t m_idx;
+  };
+
+  BitVector() = default;
+  explicit BitVector(std::size_t size, bool value = false) {
+    resize(size, value);
+  }
+
+  std::size_t size() const { return m_size; }
+  void resize(std::size_t size, bool value = false) {
+    auto oldSize = m_size;
+    m_words.resize(numWords(size), 0);
+    m_size = size;
+    if (value && size > oldSize) {
+      setRange(oldSize, size);
+    }
+    clearTail();
+  }
+
+  bool test(std::size_t idx) const {
+    assert(idx < m_size);
+    return (m_words[idx / kWordBits] >> (idx % kWordBits)) & 1;
+  }
+  void set(std::size_t idx) {
+    assert(idx < m_size);
+    m_words[idx / kWordBits] |= Word{1} << (idx % kWordBits);
+  }
+  void reset(std::size_t idx) {
+    assert(idx < m_size);
+    m_words[idx / kWordBits] &= ~(Word{1} << (idx % kWordBits));
+  }
+  void set() {
+    std::fill(m_words.begin(), m_words.end(), ~Word{0});
+    clearTail();
+  }
+  void reset() { std::fill(m_words.begin(), m_words.end(), 0); }
+
+  // std::set style access
+  bool insert(std::size_t idx) {
+    if (idx >= m_size) {
+      resize(std::max(idx + 1, 2 * m_size));
+    }
+    auto &word = m_words[idx / kWordBits];
+    auto mask = Word{1} << (idx % kWordBits);
+    bool inserted = !(word & mask);
+    word |= mask;
+    return inserted;
+  }
+  std::size_t erase(std::size_t idx) {
+    if (idx >= m_size || !test(idx)) {
+      return 0;
+    }
+    reset(idx);
+    return 1;
+  }
+  std::size_t count(std::size_t idx) const {
+    return idx < m_size && test(idx);
+  }
+  void clear() { reset(); }
+
+  // number of set bits
+  std::size_t count() const {
+    if (m_words.size() < bitops::kDispatchWords) {
+      return bitops::countScalar(m_words.data(), m_words.size());
+    }
+    return bitops::kernels().countWords(m_words.data(), m_words.size());
+  }
+  bool any() const {
+    return std::any_of(m_words.begin(), m_words.end(),
+                       [](Word word) { return word != 0; });
+  }
+  bool none() const { return !any(); }
+  bool empty() const { return none(); }
+
+  // In-place set operations, true when this changed. The result of a union
+  // is as long as the longer operand.
+  bool unionWith(const BitVector &other) {
+    if (other.m_size > m_size) {
+      resize(other.m_size);
+    }
+    return apply(&bitops::Kernels::orWords, bitops::orScalar, other,
+                 other.m_words.size());
+  }
+  bool intersectWith(const BitVector &other) {
+    auto common = std::min(m_words.size(), other.m_words.size());
+    bool changed = apply(&bitops::Kernels::andWords, bitops::andScalar, other,
+                         common);
+    for (auto i = common; i < m_words.size(); ++i) {
+      changed |= m_words[i] != 0;
+      m_words[i] = 0;
+    }
+    return changed;
+  }
+  bool subtract(const BitVector &other) {
+    auto common = std::min(m_words.size(), other.m_words.size());
+    return apply(&bitops::Kernels::andNotWords, bitops::andNotScalar, other,
+                 common);
+  }
+
+  BitVector &operator|=(const BitVector &other) {
+    unionWith(other);
+    return *this;
+  }
+  BitVector &operator&=(const BitVector &other) {
+    intersectWith(other);
+    return *this;
+  }
+  BitVector &operator-=(const BitVector &other) {
+    subtract(other);
+    return *this;
+  }
+
+  // Same set bits, whatever the sizes.
+  bool operator==(const BitVector &other) const {
+    auto common = std::min(m_words.size(), other.m_words.size());
+    if (!std::equal(m_words.begin(), m_words.begin() + common,
+                    other.m_words.begin())) {
+      return false;
+    }
+    auto &longer = m_words.size() > common ? m_words : other.m_words;
+    return std::all_of(longer.begin() + common, longer.end(),
+                       [](Word word) { return word == 0; });
+  }
+  bool operator!=(const BitVector &other) const { return !(*this == other); }
+
+  // First set bit at or after idx, size() when there is none.
+  std::size_t findNext(std::size_t idx) const {
+    if (idx >= m_size) {
+      return m_size;
+    }
+    auto wordIdx = idx / kWordBits;
+    auto word = m_words[wordIdx] & (~Word{0} << (idx % kWordBits));
+    while (!word) {
+      if (++wordIdx == m_words.size()) {
+        return m_size;
+      }
+      word = m_words[wordIdx];
+    }
+    return wordIdx * kWordBits + bitops::countTrailingZeros(word);
+  }
+  std::size_t findFirst() const { return findNext(0); }
+
+  // Iterates over set bits in increasing order.
+  const_iterator begin() const { return {this, findFirst()}; }
+  const_iterator end() const { return {this, m_size}; }
+
+  const Word *words() const { return m_words.data(); }
+  std::size_t numWords() const { return m_words.size(); }
+
+private:
+  static std::size_t numWords(std::size_t bits) {
+    return (bits + kWordBits - 1) / kWordBits;
+  }
+
+  void setRange(std::size_t from, std::size_t to) {
+    for (auto idx = from; idx < to; ++idx) {
+      set(idx);
+    }
+  }
+
+  void clearTail() {
+    if (m_size % kWordBits) {
+      m_words.back() &= ~(~Word{0} << (m_size % kWordBits));
+    }
+  }
+
+  using KernelFn = bool (*)(Word *, const Word *, std::size_t);
+  bool apply(KernelFn bitops::Kernels::*kernel, KernelFn scalar,
+             const BitVector &other, std::size_t n) {
+    if (n < bitops::kDispatchWords) {
+      return scalar(m_words.data(), other.m_words.data(), n);
+    }
+    return (bitops::kernels().*kernel)(m_words.data(), other.m_words.data(),
+                                       n);
+  }
+
+  std::vector<Word> m_words;
+  std::size_t m_size{0};
+};
+
+// Set of indices from a large universe with few members, kept as a sorted
+// vector of 128-bit chunks. Operations merge chunk lists word by word, empty
+// chunks are dropped.
+class SparseBitVector {
+public:
+  using Word = bitops::Word;
+  static constexpr std::size_t kChunkWords = 2;
+  static constexpr std::size_t kChunkBits = kChunkWords * bitops::kWordBits;
+
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::size_t *;
+    using reference = std::size_t;
+
+    const_iterator(const SparseBitVector *bits, std::size_t chunk,
+                   std::size_t bit)
+        : m_bits{bits}, m_chunk{chunk}, m_bit{bit} {
+      seek();
+    }
+
+    std::size_t operator*() const {
+      return m_bits->m_chunks[m_chunk].index * kChunkBits + m_bit;
+    }
+    const_iterator &operator++() {
+      ++m_bit;
+      seek();
+      return *this;
+    }
+    bool operator==(const const_iterator &rhs) const {
+      return m_chunk == rhs.m_chunk && m_bit == rhs.m_bit;
+    }
+    bool operator!=(const const_iterator &rhs) const {
+      return !(*this == rhs);
+    }
+
+  private:
+    // moves to the first set bit at or after the current position
+    void seek() {
+      auto &&chunks = m_bits->m_chunks;
+      for (; m_chunk < chunks.size(); ++m_chunk, m_bit = 0) {
+        for (; m_bit < kChunkBits; ++m_bit) {
+          auto word = chunks[m_chunk].bits[m_bit / bitops::kWordBits] >>
+                      (m_bit % bitops::kWordBits);
+          if (!word) {
+            m_bit = (m_bit / bitops::kWordBits + 1) * bitops::kWordBits - 1;
+            continue;
+          }
+          m_bit += bitops::countTrailingZeros(word);
+          return;
+        }
+      }
+      m_bit = 0;
+    }
+
+    const SparseBitVector *m_bits;
+    std::size_t m_chunk;
+    std::size_t m_bit;
+  };
+
+  bool test(std::size_t idx) const {
+    auto it = find(idx / kChunkBits);
+    return it != m_chunks.end() && it->index == idx / kChunkBits &&
+           it->test(idx % kChunkBits);
+  }
+  // true when idx was not in the set
+  bool insert(std::size_t idx) {
+    auto it = find(idx / kChunkBits);
+    if (it == m_chunks.end() || it->index != idx / kChunkBits) {
+      it = m_chunks.insert(it, Chunk{idx / kChunkBits, {0, 0}});
+    }
+    bool inserted = !it->test(idx % kChunkBits);
+    it->bits[idx % kChunkBits / bitops::kWordBits] |=
+        Word{1} << (idx % bitops::kWordBits);
+    return inserted;
+  }
+  std::size_t erase(std::size_t idx) {
+    auto it = find(idx / kChunkBits);
+    if (it == m_chunks.end() || it->index != idx / kChunkBits ||
+        !it->test(idx % kChunkBits)) {
+      return 0;
+    }
+    it->bits[idx % kChunkBits / bitops::kWordBits] &=
+        ~(Word{1} << (idx % bitops::kWordBits));
+    if (it->empty()) {
+      m_chunks.erase(it);
+    }
+    return 1;
+  }
+  void set(std::size_t idx) { insert(idx); }
+  void reset(std::size_t idx) { erase(idx); }
+  std::size_t count(std::size_t idx) const { return test(idx); }
+
+  std::size_t count() const {
+    std::size_t count = 0;
+    for (auto &&chunk : m_chunks) {
+      count += bitops::countScalar(chunk.bits, kChunkWords);
+    }
+    return count;
+  }
+  bool empty() const { return m_chunks.empty(); }
+  bool any() const { return !empty(); }
+  void clear() { m_chunks.clear(); }
+
+  bool unionWith(const SparseBitVector &other) {
+    std::vector<Chunk> merged;
+    merged.reserve(m_chunks.size() + other.m_chunks.size());
+    bool changed = false;
+    auto lhs = m_chunks.begin();
+    auto rhs = other.m_chunks.begin();
+    while (lhs != m_chunks.end() || rhs != other.m_chunks.end()) {
+      if (rhs == other.m_chunks.end() ||
+          (lhs != m_chunks.end() && lhs->index < rhs->index)) {
+        merged.push_back(*lhs++);
+      } else if (lhs == m_chunks.end() || rhs->index < lhs->index) {
+        merged.push_back(*rhs++);
+        changed = true;
+      } else {
+        merged.push_back(*lhs++);
+        changed |= bitops::orScalar(merged.back().bits, rhs++->bits,
+                                    kChunkWords);
+      }
+    }
+    m_chunks = std::move(merged);
+    return changed;
+  }
+  bool intersectWith(const SparseBitVector &other) {
+    return filter(other, bitops::andScalar, false);
+  }
+  bool subtract(const SparseBitVector &other) {
+    return filter(other, bitops::andNotScalar, true);
+  }
+
+  SparseBitVector &operator|=(const SparseBitVector &other) {
+    unionWith(other);
+    return *this;
+  }
+  SparseBitVector &operator&=(const SparseBitVector &other) {
+    intersectWith(other);
+    return *this;
+  }
+  SparseBitVector &operator-=(const SparseBitVector &other) {
+    subtract(other);
+    return *this;
+  }
+
+  bool operator==(const SparseBitVector &other) const {
+    return m_chunks == other.m_chunks;
+  }
+  bool operator!=(const SparseBitVector &other) const {
+    return !(*this == other);
+  }
+
+  const_iterator begin() const { return {this, 0, 0}; }
+  const_iterator end() const { return {this, m_chunks.size(), 0}; }
+
+private:
+  struct Chunk {
+    std::size_t index;
+    Word bits[kChunkWords];
+
+    bool test(std::size_t bit) const {
+      return (bits[bit / bitops::kWordBits] >> (bit % bitops::kWordBits)) & 1;
+    }
+    bool empty() const { return !(bits[0] | bits[1]); }
+    bool operator==(const Chunk &rhs) const {
+      return index == rhs.index && bits[0] == rhs.bits[0] &&
+             bits[1] == rhs.bits[1];
+    }
+  };
+
+  std::vector<Chunk>::iterator find(std::size_t index) {
+    return std::lower_bound(
+        m_chunks.begin(), m_chunks.end(), index,
+        [](const Chunk &chunk, std::size_t idx) { return chunk.index < idx; });
+  }
+  std::vector<Chunk>::const_iterator find(std::size_t index) const {
+    return const_cast<SparseBitVector *>(this)->find(index);
+  }
+
+  // Applies op against the matching chunk of other. Chunks other lacks are
+  // kept when keepUnmatched (difference) and dropped otherwise (intersection).
+  using KernelFn = bool (*)(Word *, const Word *, std::size_t);
+  bool filter(const SparseBitVector &other, KernelFn op, bool keepUnmatched) {
+    bool changed = false;
+    auto rhs = other.m_chunks.begin();
+    auto out = m_chunks.begin();
+    for (auto lhs = m_chunks.begin(); lhs != m_chunks.end(); ++lhs) {
+      while (rhs != other.m_chunks.end() && rhs->index < lhs->index) {
+        ++rhs;
+      }
+      if (rhs != other.m_chunks.end() && rhs->index == lhs->index) {
+        changed |= op(lhs->bits, rhs->bits, kChunkWords);
+      } else if (!keepUnmatched) {
+        changed = true;
+        continue;
+      }
+      if (!lhs->empty()) {
+        *out++ = *lhs;
+      }
+    }
+    m_chunks.erase(out, m_chunks.end());
+    return changed;
+  }
+
+  std::vector<Chunk> m_chunks;
+};
+
+} // namespace jade
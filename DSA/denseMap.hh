@@ -0,0 +1,310 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jade {
+
+// Hashing of DenseMap keys. One key value is reserved to mark free buckets
+// and can not be inserted.
+template <typename KeyTy, typename = void> struct DenseMapInfo;
+
+template <typename T> struct DenseMapInfo<T *> {
+  static T *emptyKey() {
+    return reinterpret_cast<T *>(std::numeric_limits<std::uintptr_t>::max());
+  }
+  static std::size_t hash(const T *ptr) {
+    auto val = reinterpret_cast<std::uintptr_t>(ptr);
+    // low bits are zero for aligned pointers
+    return (val >> 4) ^ (val >> 9);
+  }
+};
+
+template <typename T>
+struct DenseMapInfo<T, std::enable_if_t<std::is_integral_v<T>>> {
+  static T emptyKey() { return std::numeric_limits<T>::max(); }
+  static std::size_t hash(T val) {
+    // ids are often consecutive: spread them over the table
+    auto h = static_cast<std::uint64_t>(val) * 0x9e3779b97f4a7c15ULL;
+    return static_cast<std::size_t>(h ^ (h >> 32));
+  }
+};
+
+// Open-addressing hash map with linear probing: keys and values sit in one
+// array of buckets, so a lookup touches a couple of cache lines and an
+// insert allocates only when the table grows. Erase shifts the following
+// entries back instead of leaving tombstones, so probe sequences never get
+// longer than the load allows.
+//
+// Values must be default constructible. Any insertion or erase invalidates
+// iterators and references into the map.
+template <typename KeyTy, typename ValueTy,
+          typename InfoTy = DenseMapInfo<KeyTy>>
+class DenseMap {
+public:
+  using key_type = KeyTy;
+  using mapped_type = ValueTy;
+  using value_type = std::pair<KeyTy, ValueTy>;
+
+private:
+  template <bool IsConst> class Iterator {
+    using BucketTy = std::conditional_t<IsConst, const DenseMap::value_type,
+                                        DenseMap::value_type>;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = BucketTy;
+    using difference_type = std::ptrdiff_t;
+    using pointer = BucketTy *;
+    using reference = BucketTy &;
+
+    Iterator() = default;
+    Iterator(BucketTy *pos, BucketTy *end) : m_pos{pos}, m_end{end} {
+      skip();
+    }
+    // iterator -> const_iterator
+    template <bool WasConst, typename = std::enable_if_t<IsConst && !WasConst>>
+    Iterator(const Iterator<WasConst> &other)
+        : m_pos{other.m_pos}, m_end{other.m_end} {}
+
+    reference operator*() const { return *m_pos; }
+    pointer operator->() const { return m_pos; }
+
+    Iterator &operator++() {
+      ++m_pos;
+      skip();
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto tmp = *this;
+      operator++();
+      return tmp;
+    }
+    bool operator==(const Iterator &rhs) const { return m_pos == rhs.m_pos; }
+    bool operator!=(const Iterator &rhs) const { return m_pos != rhs.m_pos; }
+
+  private:
+    friend DenseMap;
+    template <bool> friend class Iterator;
+
+    void skip() {
+      while (m_pos != m_end && isEmpty(m_pos->first)) {
+        ++m_pos;
+      }
+    }
+
+    BucketTy *m_pos{nullptr};
+    BucketTy *m_end{nullptr};
+  };
+
+public:
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  DenseMap() = default;
+  explicit DenseMap(std::size_t count) { reserve(count); }
+
+  std::size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  std::size_t capacity() const { return m_buckets.size(); }
+
+  iterator begin() { return makeIterator(m_buckets.data()); }
+  iterator end() { return makeIterator(bucketsEnd()); }
+  const_iterator begin() const { return makeIterator(m_buckets.data()); }
+  const_iterator end() const { return makeIterator(bucketsEnd()); }
+
+  // Makes room for count entries without rehashing.
+  void reserve(std::size_t count) {
+    auto numBuckets = minBuckets(count);
+    if (numBuckets > m_buckets.size()) {
+      rehash(numBuckets);
+    }
+  }
+
+  iterator find(const KeyTy &key) {
+    auto idx = lookup(key);
+    return makeIterator(idx == kNotFound ? bucketsEnd() : &m_buckets[idx]);
+  }
+  const_iterator find(const KeyTy &key) const {
+    auto idx = lookup(key);
+    return makeIterator(idx == kNotFound ? bucketsEnd() : &m_buckets[idx]);
+  }
+  std::size_t count(const KeyTy &key) const { return contains(key); }
+  bool contains(const KeyTy &key) const { return lookup(key) != kNotFound; }
+
+  ValueTy &at(const KeyTy &key) {
+    auto idx = lookup(key);
+    assert(idx != kNotFound && "key is not in the map");
+    return m_buckets[idx].second;
+  }
+  const ValueTy &at(const KeyTy &key) const {
+    auto idx = lookup(key);
+    assert(idx != kNotFound && "key is not in the map");
+    return m_buckets[idx].second;
+  }
+  // The value of key, or a default one when the key is absent.
+  ValueTy lookupOr(const KeyTy &key, ValueTy dflt = ValueTy{}) const {
+    auto idx = lookup(key);
+    return idx == kNotFound ? dflt : m_buckets[idx].second;
+  }
+
+  ValueTy &operator[](const KeyTy &key) {
+    return try_emplace(key).first->second;
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const KeyTy &key, Args &&...args) {
+    assert(!isEmpty(key) && "the empty key can not be inserted");
+    grow(m_size + 1);
+    auto idx = probe(key);
+    auto &bucket = m_buckets[idx];
+    if (!isEmpty(bucket.first)) {
+      return {makeIterator(&bucket), false};
+    }
+    bucket.first = key;
+    bucket.second = ValueTy(std::forward<Args>(args)...);
+    ++m_size;
+    return {makeIterator(&bucket), true};
+  }
+  std::pair<iterator, bool> insert(const value_type &kv) {
+    return try_emplace(kv.first, kv.second);
+  }
+  std::pair<iterator, bool> insert(value_type &&kv) {
+    return try_emplace(kv.first, std::move(kv.second));
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(const KeyTy &key, Args &&...args) {
+    return try_emplace(key, std::forward<Args>(args)...);
+  }
+
+  std::size_t erase(const KeyTy &key) {
+    auto idx = lookup(key);
+    if (idx == kNotFound) {
+      return 0;
+    }
+    eraseAt(idx);
+    return 1;
+  }
+  void erase(iterator it) { eraseAt(it.m_pos - m_buckets.data()); }
+
+  // Drops the entries and keeps the buckets.
+  void clear() {
+    if (m_size == 0) {
+      return;
+    }
+    for (auto &bucket : m_buckets) {
+      if (!isEmpty(bucket.first)) {
+        bucket = emptyBucket();
+      }
+    }
+    m_size = 0;
+  }
+
+  bool operator==(const DenseMap &rhs) const {
+    if (m_size != rhs.m_size) {
+      return false;
+    }
+    for (auto &&[key, val] : *this) {
+      auto idx = rhs.lookup(key);
+      if (idx == kNotFound || !(rhs.m_buckets[idx].second == val)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool operator!=(const DenseMap &rhs) const { return !(*this == rhs); }
+
+private:
+  static constexpr std::size_t kNotFound = ~std::size_t{0};
+  static constexpr std::size_t kMinBuckets = 8;
+
+  static bool isEmpty(const KeyTy &key) { return key == InfoTy::emptyKey(); }
+  static value_type emptyBucket() { return {InfoTy::emptyKey(), ValueTy{}}; }
+
+  // the table is kept at most 3/4 full
+  static std::size_t minBuckets(std::size_t count) {
+    std::size_t numBuckets = kMinBuckets;
+    while (4 * count > 3 * numBuckets) {
+      numBuckets *= 2;
+    }
+    return numBuckets;
+  }
+
+  value_type *bucketsEnd() { return m_buckets.data() + m_buckets.size(); }
+  const value_type *bucketsEnd() const {
+    return m_buckets.data() + m_buckets.size();
+  }
+  iterator makeIterator(value_type *pos) { return {pos, bucketsEnd()}; }
+  const_iterator makeIterator(const value_type *pos) const {
+    return {pos, bucketsEnd()};
+  }
+
+  std::size_t home(const KeyTy &key) const {
+    return InfoTy::hash(key) & (m_buckets.size() - 1);
+  }
+
+  // Bucket holding key or the free bucket ending its probe sequence.
+  std::size_t probe(const KeyTy &key) const {
+    auto mask = m_buckets.size() - 1;
+    auto idx = home(key);
+    while (!isEmpty(m_buckets[idx].first) && !(m_buckets[idx].first == key)) {
+      idx = (idx + 1) & mask;
+    }
+    return idx;
+  }
+
+  std::size_t lookup(const KeyTy &key) const {
+    if (m_size == 0) {
+      return kNotFound;
+    }
+    auto idx = probe(key);
+    return isEmpty(m_buckets[idx].first) ? kNotFound : idx;
+  }
+
+  void grow(std::size_t count) {
+    if (4 * count > 3 * m_buckets.size()) {
+      rehash(std::max(minBuckets(count), 2 * m_buckets.size()));
+    }
+  }
+
+  void rehash(std::size_t numBuckets) {
+    auto old = std::move(m_buckets);
+    m_buckets.clear();
+    m_buckets.resize(numBuckets, emptyBucket());
+    for (auto &bucket : old) {
+      if (!isEmpty(bucket.first)) {
+        m_buckets[probe(bucket.first)] = std::move(bucket);
+      }
+    }
+  }
+
+  // Backward shift: entries after the hole that may live in it move up, so
+  // no probe sequence passes over a free bucket.
+  void eraseAt(std::size_t hole) {
+    auto mask = m_buckets.size() - 1;
+    auto idx = (hole + 1) & mask;
+    while (!isEmpty(m_buckets[idx].first)) {
+      auto want = home(m_buckets[idx].first);
+      // distance from the home bucket, the hole is farther from it
+      if (((idx - want) & mask) >= ((idx - hole) & mask)) {
+        m_buckets[hole] = std::move(m_buckets[idx]);
+        hole = idx;
+      }
+      idx = (idx + 1) & mask;
+    }
+    m_buckets[hole] = emptyBucket();
+    --m_size;
+  }
+
+  std::vector<value_type> m_buckets;
+  std::size_t m_size{0};
+};
+
+} // namespace jade
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
-#include <set>
+#include <iterator>
+#include <utility>
 #include <vector>
 
 namespace jade {
@@ -47,6 +49,34 @@ struct GraphTraits {
     using EdgesItTy = typename Traits::EdgesItTy;          \
 
 
+// Visited marks indexed by GraphTraits::id. Grows on demand, so walks that
+// start from a node without the graph at hand work too.
+class VisitedSet {
+public:
+    explicit VisitedSet(std::size_t size = 0) : m_bits(size) {}
+
+    // true when id was not visited before
+    bool insert(std::size_t id) {
+        if (id >= m_bits.size()) {
+            m_bits.resize(std::max(id + 1, 2 * m_bits.size()));
+        }
+        if (m_bits[id]) {
+            return false;
+        }
+        m_bits[id] = true;
+        return true;
+    }
+
+    bool contains(std::size_t id) const {
+        return id < m_bits.size() && m_bits[id];
+    }
+
+private:
+    std::vector<bool> m_bits;
+};
+
+// Preorder walk with an explicit stack of (node, next edge), so the depth of
+// the graph is not bounded by the call stack.
 template<typename GraphTy>
 class DFSIterator {
 public:
@@ -54,21 +84,28 @@ public:
 
     DFSIterator() = default;
 
-    DFSIterator(value_type node) {
+    DFSIterator(value_type node, std::size_t sizeHint = 0)
+        : m_visited(sizeHint) {
         m_stack.push_back(VE(node, Traits::outEdgeBegin(node)));
-        m_visited.insert(node);
+        m_visited.insert(Traits::id(node));
     }
 
-    static DFSIterator begin(GraphTy& G) { return DFSIterator{Traits::entry(G)}; }
+    static DFSIterator begin(GraphTy& G) {
+        return DFSIterator{Traits::entry(G), Traits::nodesCount(G)};
+    }
     static DFSIterator end(GraphTy& G) { return DFSIterator{}; }
 
     // Accessors
     reference operator*() { return m_stack.back().first; }
-    pointer operator->() { return &*this; }
+    pointer operator->() { return &m_stack.back().first; }
 
-    // Comparison operators
+    // Comparison operators: iterators of one walk are equal when they made
+    // the same number of steps, every finished walk equals end().
     bool operator==(const DFSIterator &x) const {
-        return m_stack == x.m_stack;
+        if (m_stack.empty() || x.m_stack.empty()) {
+            return m_stack.empty() == x.m_stack.empty();
+        }
+        return m_steps == x.m_steps;
     }
     bool operator!=(const DFSIterator &x) const { return !(*this == x); }
 
@@ -82,17 +119,16 @@ private:
 
     void step() {
         while(!m_stack.empty()) {
-            NodeTy currentNode = m_stack.back().first;
-            EdgesItTy EdgeIt = m_stack.back().second;
+            auto& [currentNode, edgeIt] = m_stack.back();
 
-            while(EdgeIt != Traits::outEdgeEnd(currentNode)) {
-                NodeTy nextNode = *EdgeIt;
-                if(m_visited.find(nextNode) == m_visited.end()) {
+            while(edgeIt != Traits::outEdgeEnd(currentNode)) {
+                NodeTy nextNode = *edgeIt;
+                ++edgeIt;
+                if(m_visited.insert(Traits::id(nextNode))) {
                     m_stack.push_back(VE(nextNode, Traits::outEdgeBegin(nextNode)));
-                    m_visited.insert(nextNode);
+                    ++m_steps;
                     return;
                 }
-                ++EdgeIt;
             }
 
             m_stack.pop_back();
@@ -102,7 +138,8 @@ private:
 private:
     using VE = std::pair<NodeTy, EdgesItTy>;
     std::vector<VE> m_stack;
-    std::set<NodeTy> m_visited;
+    VisitedSet m_visited;
+    std::size_t m_steps{0};
 };
 
 template<typename GraphTy>
@@ -111,13 +148,12 @@ public:
     ITER_GRAPH_TRAITS(GraphTy)
     PostOrderIterator() = default;
 
-    PostOrderIterator(value_type node) {
-        std::set<NodeTy> m_visited;
-        walk(m_visited, node);
+    PostOrderIterator(value_type node, std::size_t sizeHint = 0) {
+        walk(node, sizeHint);
     }
 
     static PostOrderIterator begin(GraphTy& G) {
-        return PostOrderIterator{Traits::entry(G)};
+        return PostOrderIterator{Traits::entry(G), Traits::nodesCount(G)};
     }
     static PostOrderIterator end(GraphTy& G) {
         auto it = PostOrderIterator{};
@@ -155,16 +191,30 @@ private:
     std::vector<NodeTy> m_order;
     std::size_t m_counter{0};
 
-    void walk(std::set<NodeTy>& visited, reference node) {
-        visited.insert(node);
-        for(auto it = Traits::outEdgeBegin(node); it != Traits::outEdgeEnd(node); ++it) {
-            NodeTy nextNode = *it;
-            if(visited.find(nextNode) == visited.end()) {
-                walk(visited, nextNode);
+    // A node is emitted when its last edge is done, the same order as the
+    // recursive walk.
+    void walk(NodeTy root, std::size_t sizeHint) {
+        using VE = std::pair<NodeTy, EdgesItTy>;
+        VisitedSet visited{sizeHint};
+        std::vector<VE> stack;
+
+        m_order.reserve(sizeHint);
+        visited.insert(Traits::id(root));
+        stack.push_back(VE(root, Traits::outEdgeBegin(root)));
+        while(!stack.empty()) {
+            auto& [node, edgeIt] = stack.back();
+            if(edgeIt == Traits::outEdgeEnd(node)) {
+                m_order.push_back(node);
+                stack.pop_back();
+                continue;
             }
-        }
 
-        m_order.push_back(node);
+            NodeTy nextNode = *edgeIt;
+            ++edgeIt;
+            if(visited.insert(Traits::id(nextNode))) {
+                stack.push_back(VE(nextNode, Traits::outEdgeBegin(nextNode)));
+            }
+        }
     }
 };
 
@@ -181,7 +231,10 @@ public:
     }
 
     static RPOIterator begin(GraphTy& G) {
-        return RPOIterator{Traits::entry(G)};
+        auto rpo = RPOIterator{};
+        rpo.m_po = PostOrderIterator<GraphTy>::collect(G);
+        rpo.m_counter = rpo.m_po.size();
+        return rpo;
     }
     static RPOIterator end(GraphTy& G) {
         auto rpo = RPOIterator();
@@ -190,7 +243,7 @@ public:
 
     // Accessors
     reference operator*() { return m_po[m_counter - 1]; }
-    pointer operator->() { return &*this; }
+    pointer operator->() { return &m_po[m_counter - 1]; }
 
     // Comparison operators
     bool operator==(const RPOIterator &x) const {
@@ -1,10 +1,9 @@
 #pragma once
 
-#include "IR.hh"
 #include <cassert>
+#include <cstddef>
 #include <iterator>
 #include <memory>
-#include <stdexcept>
 #include <type_traits>
 #include <utility>
 
@@ -13,57 +12,100 @@ namespace jade {
 class IListNode {
   IListNode *m_next{nullptr};
   IListNode *m_prev{nullptr};
+  bool m_sentinel{false};
+
+  friend struct IListBase;
+  friend struct IListHead;
+  template <typename NodeTy> friend class IListIterator;
+  template <typename NodeTy> friend class IListView;
+  template <typename NodeTy, typename Traits> friend class IList;
 
 public:
-  IListNode *getNext() { return m_next; }
-  IListNode *getPrev() { return m_prev; }
+  // Neighbours in the list, nullptr past either end.
+  IListNode *getNext() {
+    return m_next && !m_next->m_sentinel ? m_next : nullptr;
+  }
+  IListNode *getPrev() {
+    return m_prev && !m_prev->m_sentinel ? m_prev : nullptr;
+  }
 
   void setNext(IListNode *next) { m_next = next; }
   void setPrev(IListNode *prev) { m_prev = prev; }
+
+  bool isSentinel() const { return m_sentinel; }
 };
 
-struct IListBase {
-  void removeBase(IListNode *marker) {
-    auto *prev = marker->getPrev();
-    auto *next = marker->getNext();
+// Sentinel of a circular list: its next is the first node and its prev the
+// last one, an empty list links the head to itself. Views of the list (see
+// IListView) share the head, so they always see the current nodes.
+struct IListHead final : IListNode {
+  static constexpr std::size_t kUnknownSize = ~std::size_t{0};
 
-    if (next) {
-      next->setPrev(prev);
-    }
-    if (prev) {
-      prev->setNext(next);
+  IListHead() { reset(); }
+  IListHead(const IListHead &) : IListHead() {}
+  IListHead &operator=(const IListHead &) = delete;
+
+  void reset() {
+    m_sentinel = true;
+    m_next = m_prev = this;
+    size = 0;
+  }
+  bool empty() const { return m_next == this; }
+  std::size_t getSize() {
+    if (size == kUnknownSize) {
+      size = 0;
+      for (auto *node = m_next; node != this; node = node->m_next) {
+        ++size;
+      }
     }
+    return size;
+  }
+
+  // recomputed on demand after a splice of a range of unknown length
+  std::size_t size{0};
+};
 
-    marker->setNext(nullptr);
-    marker->setPrev(nullptr);
+struct IListBase {
+  static void removeBase(IListNode *marker) {
+    auto *prev = marker->m_prev;
+    auto *next = marker->m_next;
+    next->m_prev = prev;
+    prev->m_next = next;
+
+    marker->m_next = nullptr;
+    marker->m_prev = nullptr;
   }
 
-  void insertBeforeBase(IListNode *inserter, IListNode *elem) {
+  static void insertBeforeBase(IListNode *inserter, IListNode *elem) {
     assert(inserter);
     assert(elem);
 
-    auto *prev = inserter->getPrev();
-    if (prev) {
-      prev->setNext(elem);
-    }
-    inserter->setPrev(elem);
+    auto *prev = inserter->m_prev;
+    prev->m_next = elem;
+    inserter->m_prev = elem;
 
-    elem->setNext(inserter);
-    elem->setPrev(prev);
+    elem->m_next = inserter;
+    elem->m_prev = prev;
   }
 
-  void insertAfterBase(IListNode *inserter, IListNode *elem) {
-    assert(inserter);
-    assert(elem);
-
-    auto *next = inserter->getNext();
-    if (next) {
-      next->setPrev(elem);
+  // Moves [first, last) before pos, the nodes stay as they are.
+  static void transferBase(IListNode *pos, IListNode *first,
+                           IListNode *last) {
+    if (first == last || pos == last) {
+      return;
     }
-    inserter->setNext(elem);
-
-    elem->setNext(next);
-    elem->setPrev(inserter);
+    auto *final = last->m_prev;
+
+    // cut [first, final] out
+    first->m_prev->m_next = last;
+    last->m_prev = first->m_prev;
+
+    // and link it before pos
+    auto *prev = pos->m_prev;
+    prev->m_next = first;
+    first->m_prev = prev;
+    final->m_next = pos;
+    pos->m_prev = final;
   }
 };
 
@@ -75,34 +117,40 @@ public:
   using pointer = value_type *;
   using reference = value_type &;
 
-  explicit IListIterator(pointer ptr) : m_ptr{ptr} {}
+  IListIterator() = default;
+  explicit IListIterator(std::nullptr_t) {}
+  explicit IListIterator(pointer ptr) : m_node{ptr} {}
+  explicit IListIterator(IListNode *node) : m_node{node} {}
 
-  NodeTy *getPtr() { return m_ptr; }
+  // nullptr at end()
+  NodeTy *getPtr() const {
+    return m_node && !m_node->m_sentinel ? static_cast<pointer>(m_node)
+                                         : nullptr;
+  }
+  IListNode *getNode() const { return m_node; }
 
   // Accessors
-  reference operator*() const { return *m_ptr; }
-  pointer operator->() const noexcept { return m_ptr; }
-  IListIterator getNext() {
-    return IListIterator(static_cast<NodeTy *>(m_ptr->getNext()));
-  }
+  reference operator*() const { return *static_cast<pointer>(m_node); }
+  pointer operator->() const noexcept { return static_cast<pointer>(m_node); }
+  IListIterator getNext() { return IListIterator(m_node->m_next); }
 
   // Comparison operators
   bool operator==(const IListIterator &rhs) const noexcept {
-    return m_ptr == rhs.m_ptr;
+    return m_node == rhs.m_node;
   }
 
   bool operator!=(const IListIterator &rhs) const noexcept {
-    return m_ptr != rhs.m_ptr;
+    return m_node != rhs.m_node;
   }
 
   // Increment and decrement operators
   IListIterator &operator++() {
-    m_ptr = static_cast<pointer>(m_ptr->getNext());
+    m_node = m_node->m_next;
     return *this;
   }
 
   IListIterator &operator--() {
-    m_ptr = static_cast<pointer>(m_ptr->getPrev());
+    m_node = m_node->m_prev;
     return *this;
   }
 
@@ -119,106 +167,191 @@ public:
   }
 
 private:
-  pointer m_ptr{nullptr};
+  IListNode *m_node{nullptr};
+};
+
+// Non-owning view of an IList, made by IList::borrow(). It shares the head of
+// the list, so it always sees the current nodes, and copies are views of the
+// same list. A default view is empty.
+template <typename NodeTy> class IListView {
+public:
+  using iterator = IListIterator<NodeTy>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using value_type = typename iterator::value_type;
+  using pointer = typename iterator::pointer;
+
+  IListView() = default;
+  explicit IListView(IListHead *head) : m_head{head} {}
+
+  iterator begin() const { return m_head ? iterator{m_head->m_next} : end(); }
+  iterator end() const { return iterator{static_cast<IListNode *>(m_head)}; }
+  reverse_iterator rbegin() const { return reverse_iterator{end()}; }
+  reverse_iterator rend() const { return reverse_iterator{begin()}; }
+
+  std::size_t size() const { return m_head ? m_head->getSize() : 0; }
+  pointer getFirst() const { return begin().getPtr(); }
+  pointer getLast() const { return m_head ? (--end()).getPtr() : nullptr; }
+  bool empty() const { return !m_head || m_head->empty(); }
+
+private:
+  IListHead *m_head{nullptr};
 };
 
 template <typename NodeTy, bool Owner> struct IListAllocTraits {};
 
 template <typename NodeTy> struct IListAllocTraits<NodeTy, true> {
+  static constexpr bool owner = true;
   static void deallocate(NodeTy *node) { delete node; }
 };
 
 template <typename NodeTy> using IListOwner = IListAllocTraits<NodeTy, true>;
 
 template <typename NodeTy> struct IListAllocTraits<NodeTy, false> {
+  static constexpr bool owner = false;
   static void deallocate(NodeTy *node) {}
 };
 
 template <typename NodeTy>
 using IListBorrower = IListAllocTraits<NodeTy, false>;
 
+// Nodes live in an Arena: the list never frees them one by one, the arena
+// releases all of them at once.
+template <typename NodeTy>
+using IListArenaOwner = IListAllocTraits<NodeTy, false>;
+
 // TODO: IList parametrized with iterator to implement traversal algorithms on
 // general interface
 template <typename NodeTy> struct IListDefaultTraits : IListOwner<NodeTy> {};
 
+// Circular doubly linked list threaded through the nodes, with a sentinel
+// head: inserting and removing never special-case the ends, end() can be
+// decremented and whole ranges move between lists in O(1).
 template <typename NodeTy, typename Traits = IListDefaultTraits<NodeTy>>
 class IList : public IListBase {
 
 public:
   using iterator = IListIterator<NodeTy>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
   using value_type = typename iterator::value_type;
   using pointer = typename iterator::pointer;
 
 private:
-  // TODO: if not only IListBorrower? How to dispatch other traits?
-  using borrowed = IList<NodeTy, IListBorrower<NodeTy>>;
-
   // friend to IList with other traits(partial sp. not supported)
   template <typename OtherNodeTy, typename OtherTraits> friend class IList;
 
 public:
-  borrowed borrow() {
-    borrowed ret;
-    ret.m_last = m_last;
-    ret.m_start = m_start;
-
-    return ret;
-  }
-
-  ~IList() {
-    iterator it = begin();
-    while (it != end()) {
-      iterator next = it.getNext();
-      Traits::deallocate(it.getPtr());
-      it = next;
+  // A view sharing the head of this list.
+  IListView<NodeTy> borrow() { return IListView<NodeTy>{m_head}; }
+
+  IList() = default;
+  // Not copyable: a copy would share the nodes of the source, and an owning
+  // one would free them twice. Views are made explicitly with borrow().
+  IList(const IList &) = delete;
+  IList &operator=(const IList &) = delete;
+
+  IList(IList &&other) noexcept { take(other); }
+  IList &operator=(IList &&other) noexcept {
+    if (this != &other) {
+      release();
+      take(other);
     }
+    return *this;
   }
 
-  iterator begin() const { return iterator{m_start}; }
+  ~IList() { release(); }
 
-  iterator end() const { return iterator{nullptr}; }
+  iterator begin() const { return iterator{m_head->m_next}; }
+  iterator end() const { return iterator{static_cast<IListNode *>(m_head)}; }
+  reverse_iterator rbegin() const { return reverse_iterator{end()}; }
+  reverse_iterator rend() const { return reverse_iterator{begin()}; }
 
   void push_back(pointer node) { insertBefore(end(), node); }
+  void push_front(pointer node) { insertBefore(begin(), node); }
 
-  // TODO: add proxy elem at the start to avoid boilerplate checks
+  // A null iterator stands for end().
   iterator insertBefore(iterator I, pointer node) {
-    if ((I == begin()) && (I == end())) {
-      m_start = m_last = node;
-      return iterator{node};
+    insertBeforeBase(position(I), node);
+    if (m_head->size != IListHead::kUnknownSize) {
+      ++m_head->size;
     }
+    return iterator{node};
+  }
+
+  iterator insertAfter(iterator I, pointer node) {
+    return insertBefore(++iterator{position(I)}, node);
+  }
 
-    if (I == begin()) {
-      m_start = node;
+  void remove(pointer node) {
+    removeBase(node);
+    if (m_head->size != IListHead::kUnknownSize) {
+      --m_head->size;
     }
+  }
 
-    if (I == end()) {
-      insertAfterBase(m_last, node);
-      m_last = node;
-      return iterator{node};
+  // Moves [first, last) of other before pos without touching the nodes.
+  // Pass the length of the range when it is known to keep both sizes cached.
+  template <typename OtherTraits>
+  void splice(iterator pos, IList<NodeTy, OtherTraits> &other, iterator first,
+              iterator last, std::size_t count = IListHead::kUnknownSize) {
+    if (first == last) {
+      return;
+    }
+    transferBase(position(pos), first.getNode(), position(last));
+    if (m_head == other.m_head) {
+      return;
     }
+    if (count == IListHead::kUnknownSize) {
+      m_head->size = other.m_head->size = IListHead::kUnknownSize;
+      return;
+    }
+    if (m_head->size != IListHead::kUnknownSize) {
+      m_head->size += count;
+    }
+    if (other.m_head->size != IListHead::kUnknownSize) {
+      other.m_head->size -= count;
+    }
+  }
 
-    insertBeforeBase(I.getPtr(), node);
-    return iterator{node};
+  // Moves all nodes of other before pos.
+  template <typename OtherTraits>
+  void splice(iterator pos, IList<NodeTy, OtherTraits> &other) {
+    splice(pos, other, other.begin(), other.end(), other.size());
   }
 
-  iterator insertAfter(iterator I, pointer node) { insertBefore(++I, node); }
+  std::size_t size() const { return m_head->getSize(); }
 
-  void remove(pointer node) {
-    if (node == m_last) {
-      m_last = static_cast<pointer>(node->getPrev());
-    }
-    if (node == m_start) {
-      m_start = static_cast<pointer>(node->getNext());
+  pointer getFirst() const { return begin().getPtr(); }
+  pointer getLast() const { return (--end()).getPtr(); }
+  bool empty() const { return m_head->empty(); }
+
+private:
+  IListNode *position(iterator I) const {
+    return I.getNode() ? I.getNode() : m_head;
+  }
+
+  void take(IList &other) {
+    m_head->reset();
+    if (!other.empty()) {
+      transferBase(m_head, other.m_head->m_next, other.m_head);
     }
-    removeBase(node);
+    m_head->size = other.m_head->size;
+    other.m_head->reset();
   }
 
-  pointer getLast() const { return m_last; }
-  bool empty() const { return begin() == end(); }
+  void release() {
+    if constexpr (Traits::owner) {
+      iterator it = begin();
+      while (it != end()) {
+        iterator next = it.getNext();
+        Traits::deallocate(it.getPtr());
+        it = next;
+      }
+    }
+  }
 
-private:
-  pointer m_last{nullptr};
-  pointer m_start{nullptr};
+  IListHead m_ownHead;
+  // always m_ownHead, reachable from const members for the size cache
+  IListHead *m_head{&m_ownHead};
 };
 
 } // namespace jade
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace jade {
+
+// Set of pointers for the common case of a handful of elements: up to N of
+// them sit unordered in an inline array and are found by a linear scan.
+// Past that the set becomes an open-addressing hash table with linear
+// probing. Iteration order is unspecified.
+template <typename PtrTy, std::size_t N> class SmallPtrSet {
+  static_assert(std::is_pointer_v<PtrTy>, "SmallPtrSet holds pointers");
+
+  // free slot of the table
+  static constexpr std::uintptr_t kEmpty = 0;
+  // erased slot of the table: probing goes on past it
+  static constexpr std::uintptr_t kTombstone = ~std::uintptr_t{0};
+
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = PtrTy;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const PtrTy *;
+    using reference = PtrTy;
+
+    const_iterator(const std::uintptr_t *pos, const std::uintptr_t *end)
+        : m_pos{pos}, m_end{end} {
+      skip();
+    }
+
+    PtrTy operator*() const { return reinterpret_cast<PtrTy>(*m_pos); }
+    const_iterator &operator++() {
+      ++m_pos;
+      skip();
+      return *this;
+    }
+    const_iterator operator++(int) {
+      auto tmp = *this;
+      operator++();
+      return tmp;
+    }
+    bool operator==(const const_iterator &rhs) const {
+      return m_pos == rhs.m_pos;
+    }
+    bool operator!=(const const_iterator &rhs) const {
+      return m_pos != rhs.m_pos;
+    }
+
+  private:
+    void skip() {
+      while (m_pos != m_end && (*m_pos == kEmpty || *m_pos == kTombstone)) {
+        ++m_pos;
+      }
+    }
+
+    const std::uintptr_t *m_pos;
+    const std::uintptr_t *m_end;
+  };
+  using iterator = const_iterator;
+
+  SmallPtrSet() = default;
+  SmallPtrSet(std::initializer_list<PtrTy> init) {
+    for (auto ptr : init) {
+      insert(ptr);
+    }
+  }
+
+  std::size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  bool isSmall() const { return m_table.empty(); }
+
+  // true when ptr was not in the set yet
+  bool insert(PtrTy ptr) {
+    auto key = toKey(ptr);
+    if (isSmall()) {
+      if (findSmall(key) != m_size) {
+        return false;
+      }
+      if (m_size < N) {
+        m_inline[m_size++] = key;
+        return true;
+      }
+      rehash(4 * N);
+    }
+    // keep the table at most 3/4 full, tombstones included
+    if (4 * (m_size + m_tombstones + 1) > 3 * m_table.size()) {
+      rehash(4 * m_size > m_table.size() ? 2 * m_table.size()
+                                           : m_table.size());
+    }
+    auto slot = probe(key);
+    if (m_table[slot] == key) {
+      return false;
+    }
+    if (m_table[slot] == kTombstone) {
+      --m_tombstones;
+    }
+    m_table[slot] = key;
+    ++m_size;
+    return true;
+  }
+
+  std::size_t erase(PtrTy ptr) {
+    auto key = toKey(ptr);
+    if (isSmall()) {
+      auto idx = findSmall(key);
+      if (idx == m_size) {
+        return 0;
+      }
+      m_inline[idx] = m_inline[--m_size];
+      return 1;
+    }
+    auto slot = probe(key);
+    if (m_table[slot] != key) {
+      return 0;
+    }
+    m_table[slot] = kTombstone;
+    ++m_tombstones;
+    --m_size;
+    return 1;
+  }
+
+  std::size_t count(PtrTy ptr) const { return contains(ptr); }
+  bool contains(PtrTy ptr) const {
+    auto key = toKey(ptr);
+    if (isSmall()) {
+      return findSmall(key) != m_size;
+    }
+    return m_table[probe(key)] == key;
+  }
+
+  void clear() {
+    m_table.clear();
+    m_size = 0;
+    m_tombstones = 0;
+  }
+
+  const_iterator begin() const {
+    return isSmall() ? const_iterator{m_inline, m_inline + m_size}
+                     : const_iterator{m_table.data(),
+                                      m_table.data() + m_table.size()};
+  }
+  const_iterator end() const {
+    return isSmall() ? const_iterator{m_inline + m_size, m_inline + m_size}
+                     : const_iterator{m_table.data() + m_table.size(),
+                                      m_table.data() + m_table.size()};
+  }
+
+  // Same elements, whatever the order.
+  bool operator==(const SmallPtrSet &rhs) const {
+    if (m_size != rhs.m_size) {
+      return false;
+    }
+    for (auto ptr : *this) {
+      if (!rhs.contains(ptr)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool operator!=(const SmallPtrSet &rhs) const { return !(*this == rhs); }
+
+private:
+  static std::uintptr_t toKey(PtrTy ptr) {
+    auto key = reinterpret_cast<std::uintptr_t>(ptr);
+    assert(key != kEmpty && key != kTombstone && "reserved pointer value");
+    return key;
+  }
+
+  static std::size_t hash(std::uintptr_t key) {
+    // low bits are zero for aligned pointers
+    return (key >> 4) ^ (key >> 9);
+  }
+
+  std::size_t findSmall(std::uintptr_t key) const {
+    std::size_t idx = 0;
+    while (idx < m_size && m_inline[idx] != key) {
+      ++idx;
+    }
+    return idx;
+  }
+
+  // Slot holding key, or the slot where it would go: the first tombstone on
+  // the way or the empty slot ending the probe sequence.
+  std::size_t probe(std::uintptr_t key) const {
+    auto mask = m_table.size() - 1;
+    auto slot = hash(key) & mask;
+    auto found = m_table.size();
+    while (m_table[slot] != kEmpty) {
+      if (m_table[slot] == key) {
+        return slot;
+      }
+      if (m_table[slot] == kTombstone && found == m_table.size()) {
+        found = slot;
+      }
+      slot = (slot + 1) & mask;
+    }
+    return found != m_table.size() ? found : slot;
+  }
+
+  // Moves the elements to a table of numSlots (a power of two) slots.
+  void rehash(std::size_t numSlots) {
+    std::vector<std::uintptr_t> old;
+    if (isSmall()) {
+      old.assign(m_inline, m_inline + m_size);
+    } else {
+      old.swap(m_table);
+    }
+    std::size_t slots = 1;
+    while (slots < numSlots) {
+      slots <<= 1;
+    }
+    m_table.assign(slots, kEmpty);
+    m_tombstones = 0;
+    for (auto key : old) {
+      if (key != kEmpty && key != kTombstone) {
+        m_table[probe(key)] = key;
+      }
+    }
+  }
+
+  std::uintptr_t m_inline[N]{};
+  // empty while the set is small
+  std::vector<std::uintptr_t> m_table;
+  std::size_t m_size{0};
+  std::size_t m_tombstones{0};
+};
+
+} // namespace jade
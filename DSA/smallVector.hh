@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace jade {
+
+// Vector keeping up to N elements inline and going to the heap only past
+// that. Elements are moved with their move constructor when the storage
+// changes, so it holds types that are only move constructible (e.g. Use).
+template <typename T, std::size_t N> class SmallVector {
+  static_assert(N > 0, "use std::vector without inline storage");
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T &;
+  using const_reference = const T &;
+  using pointer = T *;
+  using const_pointer = const T *;
+  using iterator = T *;
+  using const_iterator = const T *;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  SmallVector() = default;
+  explicit SmallVector(size_type count) { resize(count); }
+  SmallVector(size_type count, const T &value) { assign(count, value); }
+  SmallVector(std::initializer_list<T> init) {
+    append(init.begin(), init.end());
+  }
+  template <typename It,
+            typename = typename std::iterator_traits<It>::iterator_category>
+  SmallVector(It first, It last) {
+    append(first, last);
+  }
+
+  SmallVector(const SmallVector &other) { append(other.begin(), other.end()); }
+  SmallVector(SmallVector &&other) noexcept { take(other); }
+
+  SmallVector &operator=(const SmallVector &other) {
+    if (this != &other) {
+      clear();
+      append(other.begin(), other.end());
+    }
+    return *this;
+  }
+  SmallVector &operator=(SmallVector &&other) noexcept {
+    if (this != &other) {
+      clear();
+      release();
+      take(other);
+    }
+    return *this;
+  }
+  SmallVector &operator=(std::initializer_list<T> init) {
+    clear();
+    append(init.begin(), init.end());
+    return *this;
+  }
+
+  ~SmallVector() {
+    clear();
+    release();
+  }
+
+  size_type size() const { return m_size; }
+  size_type capacity() const { return m_capacity; }
+  bool empty() const { return m_size == 0; }
+  // Elements are still in the inline buffer.
+  bool isSmall() const { return m_data == inlineData(); }
+
+  T *data() { return m_data; }
+  const T *data() const { return m_data; }
+
+  iterator begin() { return m_data; }
+  iterator end() { return m_data + m_size; }
+  const_iterator begin() const { return m_data; }
+  const_iterator end() const { return m_data + m_size; }
+  reverse_iterator rbegin() { return reverse_iterator{end()}; }
+  reverse_iterator rend() { return reverse_iterator{begin()}; }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator{end()};
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator{begin()};
+  }
+
+  T &operator[](size_type idx) {
+    assert(idx < m_size);
+    return m_data[idx];
+  }
+  const T &operator[](size_type idx) const {
+    assert(idx < m_size);
+    return m_data[idx];
+  }
+  T &front() { return (*this)[0]; }
+  const T &front() const { return (*this)[0]; }
+  T &back() { return (*this)[m_size - 1]; }
+  const T &back() const { return (*this)[m_size - 1]; }
+
+  void reserve(size_type capacity) {
+    if (capacity > m_capacity) {
+      grow(capacity);
+    }
+  }
+
+  template <typename... Args> T &emplace_back(Args &&...args) {
+    if (m_size == m_capacity) {
+      grow(m_capacity * 2);
+    }
+    auto *elem = new (m_data + m_size) T(std::forward<Args>(args)...);
+    ++m_size;
+    return *elem;
+  }
+  void push_back(const T &value) {
+    // value may live in this vector: copy it before growing
+    if (m_size == m_capacity) {
+      T copy = value;
+      emplace_back(std::move(copy));
+      return;
+    }
+    emplace_back(value);
+  }
+  void push_back(T &&value) {
+    if (m_size == m_capacity) {
+      T tmp = std::move(value);
+      emplace_back(std::move(tmp));
+      return;
+    }
+    emplace_back(std::move(value));
+  }
+  void pop_back() {
+    assert(!empty());
+    --m_size;
+    m_data[m_size].~T();
+  }
+
+  template <typename It> void append(It first, It last) {
+    if constexpr (std::is_base_of_v<
+                      std::forward_iterator_tag,
+                      typename std::iterator_traits<It>::iterator_category>) {
+      reserve(m_size + std::distance(first, last));
+    }
+    for (; first != last; ++first) {
+      emplace_back(*first);
+    }
+  }
+  void assign(size_type count, const T &value) {
+    clear();
+    reserve(count);
+    for (size_type i = 0; i < count; ++i) {
+      emplace_back(value);
+    }
+  }
+
+  void resize(size_type size) {
+    shrink(size);
+    reserve(size);
+    while (m_size < size) {
+      emplace_back();
+    }
+  }
+  void resize(size_type size, const T &value) {
+    shrink(size);
+    reserve(size);
+    while (m_size < size) {
+      emplace_back(value);
+    }
+  }
+
+  iterator insert(const_iterator pos, T value) {
+    auto idx = pos - begin();
+    assert(idx <= static_cast<difference_type>(m_size));
+    emplace_back(std::move(value));
+    std::rotate(begin() + idx, end() - 1, end());
+    return begin() + idx;
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  iterator erase(const_iterator first, const_iterator last) {
+    auto *dst = begin() + (first - begin());
+    auto *tail = std::move(begin() + (last - begin()), end(), dst);
+    shrink(tail - begin());
+    return dst;
+  }
+
+  void clear() { shrink(0); }
+
+  bool operator==(const SmallVector &rhs) const {
+    return std::equal(begin(), end(), rhs.begin(), rhs.end());
+  }
+  bool operator!=(const SmallVector &rhs) const { return !(*this == rhs); }
+
+private:
+  T *inlineData() { return reinterpret_cast<T *>(m_inline); }
+  const T *inlineData() const { return reinterpret_cast<const T *>(m_inline); }
+
+  void shrink(size_type size) {
+    while (m_size > size) {
+      pop_back();
+    }
+  }
+
+  void grow(size_type capacity) {
+    capacity = std::max(capacity, m_capacity + 1);
+    auto *data = static_cast<T *>(::operator new(capacity * sizeof(T)));
+    for (size_type i = 0; i < m_size; ++i) {
+      new (data + i) T(std::move(m_data[i]));
+      m_data[i].~T();
+    }
+    release();
+    m_data = data;
+    m_capacity = capacity;
+  }
+
+  // Frees the heap buffer, elements must be gone already.
+  void release() {
+    if (!isSmall()) {
+      ::operator delete(m_data);
+      m_data = inlineData();
+      m_capacity = N;
+    }
+  }
+
+  void take(SmallVector &other) {
+    if (!other.isSmall()) {
+      m_data = std::exchange(other.m_data, other.inlineData());
+      m_size = std::exchange(other.m_size, 0);
+      m_capacity = std::exchange(other.m_capacity, N);
+      return;
+    }
+    for (size_type i = 0; i < other.m_size; ++i) {
+      new (m_data + i) T(std::move(other.m_data[i]));
+    }
+    m_size = other.m_size;
+    other.clear();
+  }
+
+  T *m_data{inlineData()};
+  size_type m_size{0};
+  size_type m_capacity{N};
+  alignas(T) std::byte m_inline[N * sizeof(T)];
+};
+
+} // namespace jade
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace jade {
+
+// Fixed set of workers draining a FIFO of tasks. Tasks may submit more tasks,
+// wait() returns once the queue is empty and no task is running.
+class ThreadPool final {
+public:
+  using Task = std::function<void()>;
+
+  // 0 threads means one per hardware thread
+  explicit ThreadPool(std::size_t numThreads = 0) {
+    if (numThreads == 0) {
+      numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_workers.reserve(numThreads);
+    for (std::size_t i = 0; i < numThreads; ++i) {
+      m_workers.emplace_back([this] { work(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard lock{m_mutex};
+      m_stop = true;
+    }
+    m_ready.notify_all();
+    for (auto &&worker : m_workers) {
+      worker.join();
+    }
+  }
+
+  std::size_t size() const { return m_workers.size(); }
+
+  void submit(Task task) {
+    {
+      std::lock_guard lock{m_mutex};
+      m_tasks.push_back(std::move(task));
+      ++m_pending;
+    }
+    m_ready.notify_one();
+  }
+
+  void wait() {
+    std::unique_lock lock{m_mutex};
+    m_idle.wait(lock, [this] { return m_pending == 0; });
+  }
+
+private:
+  void work() {
+    for (;;) {
+      Task task;
+      {
+        std::unique_lock lock{m_mutex};
+        m_ready.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+        if (m_tasks.empty()) {
+          return;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+      }
+
+      task();
+
+      std::lock_guard lock{m_mutex};
+      if (--m_pending == 0) {
+        m_idle.notify_all();
+      }
+    }
+  }
+
+  std::vector<std::thread> m_workers;
+  std::deque<Task> m_tasks;
+  // queued plus running tasks
+  std::size_t m_pending{0};
+  bool m_stop{false};
+
+  std::mutex m_mutex;
+  std::condition_variable m_ready;
+  std::condition_variable m_idle;
+};
+
+} // namespace jade
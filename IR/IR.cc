@@ -1,5 +1,7 @@
 #include "IR.hh"
+#include "function.hh"
 #include "opcodes.hh"
+#include "printer.hh"
 #include <algorithm>
 #include <array>
 #include <cassert>
@@ -8,23 +10,63 @@
 
 namespace jade {
 
+Arena &BasicBlock::getArena() {
+  assert(m_function && "block is not attached to a function");
+  return m_function->getArena();
+}
+
+void BasicBlock::invalidateCFG() {
+  if (m_function) {
+    m_function->invalidateCFG();
+  }
+}
+
+void BasicBlock::edgeChanged(BasicBlock *succ, bool inserted) {
+  invalidateCFG();
+  auto *listener = m_function ? m_function->getCFGListener() : nullptr;
+  if (!listener) {
+    return;
+  }
+  if (inserted) {
+    listener->edgeInserted(this, succ);
+  } else {
+    listener->edgeDeleted(this, succ);
+  }
+}
+
 void BasicBlock::insert(Instruction *instr) {
+  assert(m_function && "block is not attached to a function");
   instr->setParent(this);
-  instr->setId(m_iid);
-  ++m_iid;
+  instr->setId(m_function->newValueId());
   m_instrs.insertBefore(m_inserter, instr);
 }
 
+void BasicBlock::splice(iterator pos, BasicBlock *from, iterator first,
+                        iterator last) {
+  assert(m_function && "block is not attached to a function");
+  auto renumber = from->m_function != m_function;
+  std::size_t count = 0;
+  for (auto it = first; it != last; ++it, ++count) {
+    it->setParent(this);
+    if (renumber) {
+      it->setId(m_function->newValueId());
+    }
+    if (it->getOpcode() == Opcode::PHI) {
+      auto *phi = static_cast<PhiInstr *>(&*it);
+      auto &phis = from->m_phis;
+      phis.erase(std::find(phis.begin(), phis.end(), phi));
+      addPhi(phi);
+    }
+  }
+  m_instrs.splice(pos, from->m_instrs, first, last, count);
+}
+
 void replaceUsers(Instruction *oldInst, Instruction *newInst) {
-  std::for_each(oldInst->usersBegin(), oldInst->usersEnd(),
-                [oldInst, newInst](Instruction *user) {
-                  newInst->addUser(user);
-                  user->replaceInput(oldInst, newInst);
-                });
+  oldInst->replaceUsers(newInst);
 }
 
 void BasicBlock::replace(Instruction *oldInst, Instruction *newInst) {
-  auto bb = oldInst->getParent();
+  newInst->setParent(this);
   m_instrs.insertBefore(iterator{oldInst}, newInst);
 
   forget(oldInst);
@@ -33,27 +75,27 @@ void BasicBlock::replace(Instruction *oldInst, Instruction *newInst) {
   m_instrs.remove(oldInst);
 }
 
-void BasicBlock::forget(Instruction *instr) {
-  std::for_each(instr->begin(), instr->end(), [instr](Instruction *input) {
-    auto useOld =
-        std::find(input->m_users.begin(), input->m_users.end(), instr);
-    input->m_users.erase(useOld);
-  });
-}
+void BasicBlock::forget(Instruction *instr) { instr->dropInputs(); }
 
 void BasicBlock::remove(Instruction *instr) {
   forget(instr);
-  std::for_each(
-      instr->usersBegin(), instr->usersEnd(),
-      [this, instr](Instruction *user) { user->replaceInput(instr, nullptr); });
+  instr->replaceUsers(nullptr);
   m_instrs.remove(instr);
 }
 
-void BasicBlock::dump(std::ostream &stream) {
-  for (auto instrIt = begin(), endIt = end(); instrIt != endIt; ++instrIt) {
-    auto instr = &*instrIt;
-    instr->dump(stream);
-  }
+void BasicBlock::dump(std::ostream &stream) const {
+  PrintBuffer buf{stream};
+  IRPrinter{buf}.print(*this);
+}
+
+void Instruction::dump(std::ostream &stream) const {
+  PrintBuffer buf{stream};
+  IRPrinter{buf}.print(*this);
+}
+
+void Instruction::dumpRef(std::ostream &stream) const {
+  PrintBuffer buf{stream};
+  IRPrinter{buf}.printRef(*this);
 }
 
 void BasicBlock::inverseCondition() {
@@ -64,6 +106,7 @@ void BasicBlock::inverseCondition() {
   assert(opcode == Opcode::IF);
 
   std::swap(m_succs[0], m_succs[1]);
+  invalidateCFG();
 
   auto ifInstr = static_cast<IfInstr *>(lastInstr);
   auto tmp = ifInstr->getFalseBB();
@@ -71,20 +114,20 @@ void BasicBlock::inverseCondition() {
   ifInstr->setTrueBB(tmp);
 }
 
-std::optional<std::int64_t> loadIntegerConst(Instruction *instr) {
+std::optional<std::int64_t> loadIntegerConst(const Instruction *instr) {
   if (instr->getOpcode() != Opcode::CONST) {
     return std::nullopt;
   }
 
   switch (instr->getType()) {
   case Type::Tag::I64:
-    return std::optional(static_cast<ConstI64 *>(instr)->getValue());
+    return std::optional(static_cast<const ConstI64 *>(instr)->getValue());
   case Type::Tag::I32:
-    return std::optional(static_cast<ConstI32 *>(instr)->getValue());
+    return std::optional(static_cast<const ConstI32 *>(instr)->getValue());
   case Type::Tag::I16:
-    return std::optional(static_cast<ConstI16 *>(instr)->getValue());
+    return std::optional(static_cast<const ConstI16 *>(instr)->getValue());
   case Type::Tag::I8:
-    return std::optional(static_cast<ConstI8 *>(instr)->getValue());
+    return std::optional(static_cast<const ConstI8 *>(instr)->getValue());
   default:
     return std::nullopt;
   }
@@ -92,19 +135,20 @@ std::optional<std::int64_t> loadIntegerConst(Instruction *instr) {
   assert(0);
 }
 
-std::unique_ptr<Instruction> createIntegerConstant(std::int64_t val,
-                                                   Type type) {
+Instruction *createIntegerConstant(BasicBlock *bb, std::int64_t val,
+                                   Type type) {
   switch (type.getType()) {
   case Type::Tag::I64:
-    return std::make_unique<ConstI64>(val);
+    return bb->create<ConstI64>(val);
   case Type::Tag::I32:
-    return std::make_unique<ConstI32>(val);
+    return bb->create<ConstI32>(val);
   case Type::Tag::I16:
-    return std::make_unique<ConstI16>(val);
+    return bb->create<ConstI16>(val);
   case Type::Tag::I8:
-    return std::make_unique<ConstI8>(val);
+    return bb->create<ConstI8>(val);
   default:
     assert(0);
+    return nullptr;
   }
 }
 
@@ -16,8 +16,10 @@
 #include <utility>
 #include <vector>
 
+#include "arena.hh"
 #include "ilist.hh"
 #include "opcodes.hh"
+#include "smallVector.hh"
 
 namespace jade {
 
@@ -34,18 +36,16 @@ public:
     None,
   };
 
-  Type() : m_tag{Tag::None} {}
-  Type(Tag tag) : m_tag(tag) {}
+  constexpr Type() : m_tag{Tag::None} {}
+  constexpr Type(Tag tag) : m_tag(tag) {}
 
   template <Tag tag> static Type create() { return Type{tag}; }
 
-  Tag getType() const { return m_tag; }
-  std::string_view getName() const {
-    static std::unordered_map<Tag, std::string_view> map = {
-        {Tag::I1, "i1"},   {Tag::I8, "i8"},   {Tag::I16, "i16"},
-        {Tag::I32, "i32"}, {Tag::I64, "i64"}, {Tag::None, "none"}};
-
-    return map[m_tag];
+  constexpr Tag getType() const { return m_tag; }
+  constexpr std::string_view getName() const {
+    constexpr std::string_view names[] = {"i8",  "i16", "i32",
+                                          "i64", "i1",  "none"};
+    return names[m_tag];
   }
 
 private:
@@ -61,6 +61,7 @@ public:
 
   Type::Tag getType() const { return m_type.getType(); }
   std::string getName() const { return m_name; }
+  std::string_view getNameView() const { return m_name; }
   void setName(std::string &&name) { m_name = std::move(name); }
   virtual bool is_vreg() const { return false; }
 
@@ -94,14 +95,19 @@ public:
   auto predecessors() { return Range(m_preds.begin(), m_preds.end()); }
   auto phis() { return Range(m_phis.begin(), m_phis.end()); }
 
-  auto collectSuccessors() const { return m_succs; }
-  auto collectPredecessors() const { return m_preds; }
+  std::vector<BasicBlock *> collectSuccessors() const {
+    return {m_succs.begin(), m_succs.end()};
+  }
+  std::vector<BasicBlock *> collectPredecessors() const {
+    return {m_preds.begin(), m_preds.end()};
+  }
 
   void removeSuccessor(BasicBlock *bb) {
     auto it = std::find_if(m_succs.begin(), m_succs.end(),
                            [bb](BasicBlock *elem) { return bb == elem; });
     m_succs.erase(it);
     bb->removePredecessor(this);
+    edgeChanged(bb, false);
   }
 
   auto terminator() const { return m_instrs.getLast(); }
@@ -118,11 +124,17 @@ public:
   void addSuccessor(BasicBlock *succs) {
     succs->addPredecessor(this);
     m_succs.push_back(succs);
+    edgeChanged(succs, true);
   }
   void addPhi(PhiInstr *instr) { m_phis.push_back(instr); }
 
   void setId(std::size_t id) { m_id = id; }
-  std::size_t getId() { return m_id; }
+  std::size_t getId() const { return m_id; }
+
+  Function *getFunction() const { return m_function; }
+  void setFunction(Function *fn) { m_function = fn; }
+  // Arena of the parent function: every instruction of the block lives there.
+  Arena &getArena();
 
   bool empty() {
     if (m_instrs.empty()) {
@@ -131,7 +143,7 @@ public:
     return false;
   }
 
-  void dump(std::ostream &stream);
+  void dump(std::ostream &stream) const;
   void inverseCondition();
 
   void removeInstr(Instruction *instr) { m_instrs.remove(instr); }
@@ -147,8 +159,19 @@ public:
 
   template <typename T, typename... Args> T *create(Args &&...args);
   void insert(Instruction *instr);
+  // Moves [first, last) of from before pos. The instructions are relinked in
+  // O(1), only their parent (and ids when from is in another function) are
+  // updated. Successor edges stay as they are.
+  void splice(iterator pos, BasicBlock *from, iterator first, iterator last);
+  void splice(iterator pos, BasicBlock *from, Instruction *first) {
+    splice(pos, from, first ? iterator{first} : from->end(), from->end());
+  }
 
 private:
+  // bumps the CFG epoch of the parent function
+  void invalidateCFG();
+  // and tells its CFG listener about the edge
+  void edgeChanged(BasicBlock *succ, bool inserted);
   void addPredecessor(BasicBlock *pred) { m_preds.push_back(pred); }
   void removePredecessor(BasicBlock *bb) {
     auto it = std::find_if(m_preds.begin(), m_preds.end(),
@@ -157,15 +180,168 @@ private:
   }
 
 private:
-  IList<Instruction> m_instrs;
-  std::vector<BasicBlock *> m_preds;
-  std::vector<BasicBlock *> m_succs;
-  std::vector<PhiInstr *> m_phis;
+  IList<Instruction, IListArenaOwner<Instruction>> m_instrs;
+  // a block ends in goto or if: two successors at most
+  SmallVector<BasicBlock *, 2> m_succs;
+  SmallVector<BasicBlock *, 4> m_preds;
+  SmallVector<PhiInstr *, 2> m_phis;
   Function *m_function{nullptr};
 
   iterator m_inserter{nullptr};
   std::size_t m_id{0};
-  std::size_t m_iid{0}; // counter for instr id
+};
+
+// Operand slot of an instruction. Every non-null use is linked into the
+// use-list of the value it refers to, so dropping a use and rewriting all
+// uses of a value do not need to search anything.
+class Use final {
+public:
+  Use(Instruction *user) : m_user{user} {}
+  Use(Instruction *user, Instruction *val) : m_user{user} { set(val); }
+
+  Use(const Use &) = delete;
+  Use &operator=(const Use &) = delete;
+  Use &operator=(Use &&) = delete;
+
+  // Operand storage may be reallocated: the moved use takes the place of
+  // other in the use-list.
+  Use(Use &&other) noexcept
+      : m_val{other.m_val}, m_user{other.m_user}, m_next{other.m_next},
+        m_prev{other.m_prev} {
+    if (m_prev) {
+      *m_prev = this;
+    }
+    if (m_next) {
+      m_next->m_prev = &m_next;
+    }
+    other.m_val = nullptr;
+    other.m_next = nullptr;
+    other.m_prev = nullptr;
+  }
+
+  ~Use() { unlink(); }
+
+  Instruction *get() const { return m_val; }
+  Instruction *getUser() const { return m_user; }
+  Use *getNext() const { return m_next; }
+
+  inline void set(Instruction *val);
+
+private:
+  inline void link();
+  inline void unlink();
+
+  Instruction *m_val{nullptr};
+  Instruction *m_user{nullptr};
+  Use *m_next{nullptr};
+  // address of the pointer to this use: either the head of the use-list or
+  // m_next of the previous use
+  Use **m_prev{nullptr};
+};
+
+// Iterates over operand values of an instruction. The uses of an
+// instruction are contiguous, so the iterator is random access.
+class OperandIterator {
+public:
+  using iterator_category = std::random_access_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = Instruction *;
+  using pointer = value_type *;
+  using reference = value_type;
+
+  OperandIterator() = default;
+  explicit OperandIterator(const Use *use) : m_use{use} {}
+
+  Instruction *operator*() const { return m_use->get(); }
+  Instruction *operator[](difference_type n) const { return m_use[n].get(); }
+
+  bool operator==(const OperandIterator &rhs) const {
+    return m_use == rhs.m_use;
+  }
+  bool operator!=(const OperandIterator &rhs) const {
+    return m_use != rhs.m_use;
+  }
+  bool operator<(const OperandIterator &rhs) const {
+    return m_use < rhs.m_use;
+  }
+  bool operator>(const OperandIterator &rhs) const { return rhs < *this; }
+  bool operator<=(const OperandIterator &rhs) const { return !(rhs < *this); }
+  bool operator>=(const OperandIterator &rhs) const { return !(*this < rhs); }
+  difference_type operator-(const OperandIterator &rhs) const {
+    return m_use - rhs.m_use;
+  }
+
+  OperandIterator &operator++() {
+    ++m_use;
+    return *this;
+  }
+  OperandIterator operator++(int) {
+    auto tmp = *this;
+    ++m_use;
+    return tmp;
+  }
+  OperandIterator &operator--() {
+    --m_use;
+    return *this;
+  }
+  OperandIterator operator--(int) {
+    auto tmp = *this;
+    --m_use;
+    return tmp;
+  }
+
+  OperandIterator &operator+=(difference_type n) {
+    m_use += n;
+    return *this;
+  }
+  OperandIterator &operator-=(difference_type n) {
+    m_use -= n;
+    return *this;
+  }
+  OperandIterator operator+(difference_type n) const {
+    return OperandIterator{m_use + n};
+  }
+  friend OperandIterator operator+(difference_type n, OperandIterator it) {
+    return it + n;
+  }
+  OperandIterator operator-(difference_type n) const {
+    return OperandIterator{m_use - n};
+  }
+
+private:
+  const Use *m_use{nullptr};
+};
+
+// Iterates over the use-list of a value, yielding the users.
+class UserIterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = Instruction *;
+  using pointer = value_type *;
+  using reference = value_type;
+
+  UserIterator() = default;
+  explicit UserIterator(Use *use) : m_use{use} {}
+
+  Instruction *operator*() const { return m_use->getUser(); }
+  Use *getUse() const { return m_use; }
+
+  bool operator==(const UserIterator &rhs) const { return m_use == rhs.m_use; }
+  bool operator!=(const UserIterator &rhs) const { return m_use != rhs.m_use; }
+
+  UserIterator &operator++() {
+    m_use = m_use->getNext();
+    return *this;
+  }
+  UserIterator operator++(int) {
+    auto tmp = *this;
+    m_use = m_use->getNext();
+    return tmp;
+  }
+
+private:
+  Use *m_use{nullptr};
 };
 
 class Instruction : public Value, public IListNode {
@@ -175,68 +351,126 @@ public:
   Instruction(Type type, BasicBlock *bb) : Value{type}, m_bb(bb) {}
   Instruction(std::string &&name, Type type, BasicBlock *bb)
       : Value{std::move(name), type}, m_bb(bb) {}
-  virtual ~Instruction() = default;
+  // A dying value drops every use that still refers to it.
+  virtual ~Instruction() { replaceUsers(nullptr); }
 
   BasicBlock *getParent() const { return m_bb; }
   Opcode getOpcode() const { return m_op; }
 
+  // Dense function-wide number, see Function::renumber.
   void setId(std::size_t id) { m_id = id; }
-  std::size_t getId() { return m_id; }
+  std::size_t getId() const { return m_id; }
 
   void setParent(BasicBlock *bb) { m_bb = bb; }
-  virtual void dump(std::ostream &stream) = 0;
-  virtual Instruction *copy() const = 0;
-
-  Instruction *input(std::size_t idx) { return m_inputs[idx]; }
-  auto begin() const { return m_inputs.begin(); }
-  auto end() const { return m_inputs.end(); }
-  auto begin() { return m_inputs.begin(); }
-  auto end() { return m_inputs.end(); }
+  void dump(std::ostream &stream) const;
+  virtual Instruction *copy(Arena &arena) const = 0;
+
+  Instruction *input(std::size_t idx) const { return m_inputs[idx].get(); }
+  void setInput(std::size_t idx, Instruction *val) { m_inputs[idx].set(val); }
+  std::size_t numInputs() const { return m_inputs.size(); }
+
+  auto begin() const { return OperandIterator{m_inputs.data()}; }
+  auto end() const {
+    return OperandIterator{m_inputs.data() + m_inputs.size()};
+  }
+  auto operands() { return Range(m_inputs.begin(), m_inputs.end()); }
+
   Instruction *next() { return static_cast<Instruction *>(this->getNext()); }
   Instruction *prev() { return static_cast<Instruction *>(this->getPrev()); }
 
   void replaceInput(Instruction *oldInstr, Instruction *newInstr) {
-    std::replace(m_inputs.begin(), m_inputs.end(), oldInstr, newInstr);
+    for (auto &use : m_inputs) {
+      if (use.get() == oldInstr) {
+        use.set(newInstr);
+      }
+    }
   }
-
-  void addUser(Instruction *instr) { m_users.push_back(instr); }
-  auto users() const { return m_users; }
-  void removeUser(Instruction *instr) {
-    auto pos = std::find(m_users.begin(), m_users.end(), instr);
-    m_users.erase(pos);
+  // Drop every operand of the instruction.
+  void dropInputs() {
+    for (auto &use : m_inputs) {
+      use.set(nullptr);
+    }
+  }
+  // Make every use of this instruction refer to val instead.
+  void replaceUsers(Instruction *val) {
+    while (m_useList) {
+      m_useList->set(val);
+    }
   }
-  auto usersBegin() const { return m_users.begin(); }
-  auto usersEnd() const { return m_users.end(); }
 
-  auto usersBegin() { return m_users.begin(); }
-  auto usersEnd() { return m_users.end(); }
+  auto users() const {
+    return Range(UserIterator{m_useList}, UserIterator{});
+  }
+  auto usersBegin() const { return UserIterator{m_useList}; }
+  auto usersEnd() const { return UserIterator{}; }
 
-  std::size_t numUsers() const { return m_users.size(); }
+  bool hasUsers() const { return m_useList != nullptr; }
+  std::size_t numUsers() const { return m_numUsers; }
   void dumpUsers(std::ostream &stream) const {
-    for (auto &&elem : m_users) {
-      elem->dumpRef(stream);
+    for (auto *user : users()) {
+      user->dumpRef(stream);
       stream << " ";
     }
-    stream << std::endl;
+    stream << '\n';
   }
 
-  void dumpRef(std::ostream &stream) { stream << this->getName(); }
-  bool isTerm() const {
-    return m_op == Opcode::GOTO || m_op == Opcode::IF || m_op == Opcode::RET;
-  }
+  void dumpRef(std::ostream &stream) const;
+  bool isTerm() const { return isTerminator(m_op); }
+  bool isCommutative() const { return jade::isCommutative(m_op); }
+  bool hasSideEffects() const { return jade::hasSideEffects(m_op); }
 
 protected:
+  void addInput(Instruction *val) { m_inputs.emplace_back(this, val); }
+
   Opcode m_op;
-  std::vector<Instruction *> m_inputs;
-  std::vector<Instruction *> m_users;
+  // inline room for the operands of unary and binary instructions
+  SmallVector<Use, 2> m_inputs;
 
 private:
   friend BasicBlock;
+  friend Use;
 
+  Use *m_useList{nullptr};
+  std::size_t m_numUsers{0};
   BasicBlock *m_bb{nullptr};
-  std::size_t m_id;
+  std::size_t m_id{0};
 };
 
+void Use::set(Instruction *val) {
+  if (m_val == val) {
+    return;
+  }
+  unlink();
+  m_val = val;
+  link();
+}
+
+void Use::link() {
+  if (!m_val) {
+    return;
+  }
+  m_next = m_val->m_useList;
+  if (m_next) {
+    m_next->m_prev = &m_next;
+  }
+  m_prev = &m_val->m_useList;
+  m_val->m_useList = this;
+  ++m_val->m_numUsers;
+}
+
+void Use::unlink() {
+  if (!m_prev) {
+    return;
+  }
+  *m_prev = m_next;
+  if (m_next) {
+    m_next->m_prev = m_prev;
+  }
+  --m_val->m_numUsers;
+  m_next = nullptr;
+  m_prev = nullptr;
+}
+
 class ParamInstr : public Instruction {
 public:
   ParamInstr(Type type) : Instruction{type} { m_op = Opcode::PARAM; }
@@ -244,14 +478,10 @@ public:
     setName(std::move(name));
   }
 
-  Instruction *copy() const override {
-    return new ParamInstr(getType(), getName());
+  Instruction *copy(Arena &arena) const override {
+    return arena.create<ParamInstr>(getType(), getName());
   }
 
-  void dump(std::ostream &stream) override {
-    stream << OpcodeToStr(m_op) << " " << getName();
-    stream << std::endl;
-  }
 };
 
 class IfInstr final : public Instruction {
@@ -260,8 +490,7 @@ public:
 
   IfInstr(Instruction *cond, BasicBlock *false_, BasicBlock *true_)
       : IfInstr() {
-    m_inputs.push_back(cond);
-    cond->addUser(this);
+    addInput(cond);
     m_false_bb = false_;
     m_true_bb = true_;
   }
@@ -272,20 +501,12 @@ public:
     setName(std::move(name));
   }
 
-  Instruction *copy() const override {
-    return new IfInstr(m_inputs[0], m_false_bb, m_true_bb, getName());
-  }
-
-  void dump(std::ostream &stream) override {
-    dumpRef(stream);
-    stream << ": " << OpcodeToStr(m_op) << " ";
-    m_inputs[0]->dumpRef(stream);
-    stream << " T:" << m_true_bb->getName() << " ";
-    stream << "F:" << m_false_bb->getName() << " ";
-    stream << std::endl;
+  Instruction *copy(Arena &arena) const override {
+    return arena.create<IfInstr>(input(0), m_false_bb, m_true_bb,
+                                 getName());
   }
 
-  Value *getCondition() { return m_inputs[0]; }
+  Value *getCondition() { return input(0); }
   BasicBlock *getFalseBB() const { return m_false_bb; }
   BasicBlock *getTrueBB() const { return m_true_bb; }
 
@@ -306,18 +527,13 @@ public:
     setName(std::move(name));
   }
 
-  Instruction *copy() const override { return new GotoInstr(m_bb, getName()); }
+  Instruction *copy(Arena &arena) const override {
+    return arena.create<GotoInstr>(m_bb, getName());
+  }
 
   BasicBlock *getBB() const { return m_bb; }
   void setBB(BasicBlock *bb) { m_bb = bb; }
 
-  void dump(std::ostream &stream) override {
-    dumpRef(stream);
-    stream << ": " << OpcodeToStr(m_op) << " ";
-    stream << m_bb->getName();
-    stream << std::endl;
-  }
-
 private:
   BasicBlock *m_bb{nullptr};
 };
@@ -327,25 +543,22 @@ public:
   RetInstr() { m_op = Opcode::RET; }
   RetInstr(Instruction *v) : RetInstr() {
     m_type = v->getType();
-    m_inputs.push_back(v);
-    v->addUser(this);
+    addInput(v);
   }
   RetInstr(Instruction *v, std::string &&name) : RetInstr(v) {
     setName(std::move(name));
   }
 
-  Instruction *copy() const override {
-    return new RetInstr(m_inputs[0], getName());
-  }
-
-  void dump(std::ostream &stream) override {
-    dumpRef(stream);
-    stream << ": " << OpcodeToStr(m_op) << " ";
-    m_inputs[0]->dumpRef(stream);
-    stream << " " << std::endl;
+  Instruction *copy(Arena &arena) const override {
+    if (numInputs() == 0) {
+      auto *ret = arena.create<RetInstr>();
+      ret->setName(getName());
+      return ret;
+    }
+    return arena.create<RetInstr>(input(0), getName());
   }
 
-  Instruction *getVal() const { return m_inputs[0]; }
+  Instruction *getVal() const { return input(0); }
 
   bool is_vreg() const override { return true; }
 };
@@ -357,49 +570,76 @@ public:
     setName(std::move(name));
   }
 
+  // Incoming values are regular operands, blocks are kept aside with the
+  // same index.
+  class OptionIterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::pair<BasicBlock *, Instruction *>;
+    using pointer = value_type *;
+    using reference = value_type;
+
+    OptionIterator(const PhiInstr *phi, std::size_t idx)
+        : m_phi{phi}, m_idx{idx} {}
+
+    value_type operator*() const { return m_phi->getOption(m_idx); }
+
+    bool operator==(const OptionIterator &rhs) const {
+      return m_idx == rhs.m_idx;
+    }
+    bool operator!=(const OptionIterator &rhs) const {
+      return m_idx != rhs.m_idx;
+    }
+
+    OptionIterator &operator++() {
+      ++m_idx;
+      return *this;
+    }
+
+  private:
+    const PhiInstr *m_phi;
+    std::size_t m_idx;
+  };
+
   void addOption(Instruction *instr, BasicBlock *bb) {
     assert(getType() == instr->getType());
-    m_args.push_back(std::make_pair(bb, instr));
+    addInput(instr);
+    m_blocks.push_back(bb);
+  }
+
+  std::pair<BasicBlock *, Instruction *> getOption(std::size_t idx) const {
+    return std::make_pair(m_blocks[idx], input(idx));
   }
+  std::size_t numOptions() const { return m_blocks.size(); }
 
-  std::pair<BasicBlock *, Instruction *> getOption(std::size_t idx) {
-    return m_args[idx];
+  BasicBlock *getIncomingBlock(std::size_t idx) const { return m_blocks[idx]; }
+  void setIncomingBlock(std::size_t idx, BasicBlock *bb) {
+    m_blocks[idx] = bb;
   }
 
-  auto begin() { return m_args.begin(); }
-  auto end() { return m_args.end(); }
+  auto begin() const { return OptionIterator{this, 0}; }
+  auto end() const { return OptionIterator{this, m_blocks.size()}; }
 
-  Instruction *copy() const override {
-    auto *phi = new PhiInstr(m_type, getName());
-    for (auto arg : m_args) {
-      phi->addOption(arg.second, arg.first);
+  Instruction *copy(Arena &arena) const override {
+    auto *phi = arena.create<PhiInstr>(m_type, getName());
+    for (auto &&[bb, instr] : *this) {
+      phi->addOption(instr, bb);
     }
 
     return phi;
   }
 
-  void dump(std::ostream &stream) override {
-    dumpRef(stream);
-    stream << ": " << OpcodeToStr(m_op) << " ";
-    for (auto &&[bb, instr] : m_args) {
-      stream << bb->getName() << " ";
-      instr->dumpRef(stream);
-      stream << ", ";
-    }
-    stream << std::endl;
-  }
-
   bool is_vreg() const override { return true; }
 
 private:
-  std::vector<std::pair<BasicBlock *, Instruction *>> m_args;
+  SmallVector<BasicBlock *, 2> m_blocks;
 };
 
 class UnaryOp final : public Instruction {
 public:
   UnaryOp(Instruction *val, Opcode kind) {
-    m_inputs.push_back(val);
-    val->addUser(this);
+    addInput(val);
     m_type = val->getType();
     m_op = kind;
   }
@@ -409,15 +649,8 @@ public:
     setName(std::move(name));
   }
 
-  Instruction *copy() const override {
-    return new UnaryOp(m_inputs[0], m_op, getName());
-  }
-
-  void dump(std::ostream &stream) override {
-    dumpRef(stream);
-    stream << ": " << OpcodeToStr(m_op) << " ";
-    m_inputs[0]->dumpRef(stream);
-    stream << " " << std::endl;
+  Instruction *copy(Arena &arena) const override {
+    return arena.create<UnaryOp>(input(0), m_op, getName());
   }
 
   bool is_vreg() const override { return true; }
@@ -427,10 +660,8 @@ class BinaryInstr : public Instruction {
 public:
   BinaryInstr(Instruction *lhs, Instruction *rhs) {
     assert(lhs->getType() == rhs->getType());
-    m_inputs.push_back(lhs);
-    m_inputs.push_back(rhs);
-    lhs->addUser(this);
-    rhs->addUser(this);
+    addInput(lhs);
+    addInput(rhs);
   }
 
   BinaryInstr(Instruction *lhs, Instruction *rhs, std::string &&name) {
@@ -442,15 +673,6 @@ public:
 
 class CmpInstr final : public BinaryInstr {
 public:
-  void dump(std::ostream &stream) override {
-    dumpRef(stream);
-    stream << ": " << OpcodeToStr(m_op) << " ";
-    m_inputs[0]->dumpRef(stream);
-    stream << " " << std::endl;
-    m_inputs[1]->dumpRef(stream);
-    stream << " " << std::endl;
-  }
-
   CmpInstr(Instruction *lhs, Instruction *rhs, Opcode kind)
       : BinaryInstr(lhs, rhs) {
     m_type = Type::create<Type::I1>();
@@ -462,8 +684,9 @@ public:
     setName(std::move(name));
   }
 
-  Instruction *copy() const override {
-    return new CmpInstr(m_inputs[0], m_inputs[1], m_op, getName());
+  Instruction *copy(Arena &arena) const override {
+    return arena.create<CmpInstr>(input(0), input(1), m_op,
+                                  getName());
   }
 
   bool is_vreg() const override { return true; }
@@ -482,17 +705,9 @@ public:
     setName(std::move(name));
   }
 
-  void dump(std::ostream &stream) override {
-    dumpRef(stream);
-    stream << ": " << OpcodeToStr(m_op) << " ";
-    m_inputs[0]->dumpRef(stream);
-    stream << " ";
-    m_inputs[1]->dumpRef(stream);
-    stream << " " << std::endl;
-  }
-
-  Instruction *copy() const override {
-    return new BinaryOp(m_inputs[0], m_inputs[1], m_op, getName());
+  Instruction *copy(Arena &arena) const override {
+    return arena.create<BinaryOp>(input(0), input(1), m_op,
+                                  getName());
   }
 
   bool is_vreg() const override { return true; }
@@ -505,8 +720,7 @@ public:
   CastInstr(Instruction *val, Type type) : CastInstr() {
     m_cast = type;
     m_type = m_cast;
-    m_inputs.push_back(val);
-    val->addUser(this);
+    addInput(val);
   }
 
   CastInstr(Instruction *val, Type type, std::string &&name)
@@ -514,13 +728,8 @@ public:
     setName(std::move(name));
   }
 
-  void dump(std::ostream &stream) override {
-    // TODO
-  }
-
-  Instruction *copy() const override {
-    // todo
-    return nullptr;
+  Instruction *copy(Arena &arena) const override {
+    return arena.create<CastInstr>(input(0), m_cast, getName());
   }
 
   bool is_vreg() const override { return true; }
@@ -540,27 +749,17 @@ public:
     setName(std::move(name));
   }
 
-  auto argsBegin() { return m_inputs.begin(); }
-  auto argsEnd() { return m_inputs.end(); }
-
-  void addArg(Instruction *instr) {
-    m_inputs.push_back(instr);
-    instr->addUser(this);
-  }
+  auto argsBegin() const { return begin(); }
+  auto argsEnd() const { return end(); }
 
-  Instruction *copy() const override {
-    // todo
-    return nullptr;
-  }
+  void addArg(Instruction *instr) { addInput(instr); }
 
-  void dump(std::ostream &stream) override {
-    dumpRef(stream);
-    stream << ": " << OpcodeToStr(m_op) << " ";
-    for (auto *input : m_inputs) {
-      input->dumpRef(stream);
-      stream << " ";
+  Instruction *copy(Arena &arena) const override {
+    auto *call = arena.create<CallInstr>(m_callee, m_type, getName());
+    for (auto *arg : *this) {
+      call->addArg(arg);
     }
-    stream << std::endl;
+    return call;
   }
 
   Function *getCallee() const { return m_callee; }
@@ -584,16 +783,8 @@ template <class T> class Constant : public Instruction {};
       setName(std::move(name));                                                \
     }                                                                          \
                                                                                \
-    Instruction *copy() const override {                                       \
-      return new Constant<cty>(m_val, getName());                              \
-    }                                                                          \
-                                                                               \
-    void dump(std::ostream &stream) override {                                 \
-      dumpRef(stream);                                                         \
-      stream << ": " << OpcodeToStr(m_op) << " ";                              \
-      stream << Type(Type::jadety).getName() << " ";                           \
-      stream << m_val << " ";                                                  \
-      stream << std::endl;                                                     \
+    Instruction *copy(Arena &arena) const override {                           \
+      return arena.create<Constant<cty>>(m_val, getName());                    \
     }                                                                          \
                                                                                \
     cty getValue() const { return m_val; }                                     \
@@ -613,12 +804,9 @@ CONSTANT(std::int8_t, I8);
 CONSTANT(bool, I1);
 
 template <typename T, typename... Args> T *BasicBlock::create(Args &&...args) {
-  auto *elem = new T(args...);
-  elem->setParent(this);
-  elem->setId(m_iid);
-  ++m_iid;
+  auto *elem = getArena().create<T>(std::forward<Args>(args)...);
+  insert(elem);
 
-  m_instrs.insertBefore(m_inserter, elem);
   if constexpr (std::is_same_v<T, IfInstr>) {
     addSuccessor(elem->getFalseBB());
     addSuccessor(elem->getTrueBB());
@@ -632,7 +820,7 @@ template <typename T, typename... Args> T *BasicBlock::create(Args &&...args) {
 }
 
 void replaceUsers(Instruction *oldInst, Instruction *newInst);
-std::optional<std::int64_t> loadIntegerConst(Instruction *instr);
-std::unique_ptr<Instruction> createIntegerConstant(std::int64_t val, Type type);
+std::optional<std::int64_t> loadIntegerConst(const Instruction *instr);
+Instruction *createIntegerConstant(BasicBlock *bb, std::int64_t val, Type type);
 
 } // namespace jade
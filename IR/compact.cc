@@ -0,0 +1,153 @@
+#include "compact.hh"
+#include "IR.hh"
+#include "function.hh"
+#include "opcodes.hh"
+#include <cassert>
+
+namespace jade {
+
+CompactFunction::CompactFunction(Function &fn) {
+  buildBlocks(fn);
+  buildInstrs();
+  buildEdges();
+}
+
+void CompactFunction::buildBlocks(Function &fn) {
+  auto graph = fn.getBasicBlocks();
+  m_blockHandles.assign(fn.numBlocks(), kNoHandle);
+  m_instrHandles.assign(fn.numValues(), kNoHandle);
+  for (auto &&bb : graph.nodes()) {
+    assert(bb.getId() < m_blockHandles.size());
+    m_blockHandles[bb.getId()] = m_blockViews.size();
+    m_blockIds.push_back(bb.getId());
+    m_blockViews.push_back(&bb);
+  }
+
+  m_blockBegin.reserve(m_blockViews.size() + 1);
+  for (auto *bb : m_blockViews) {
+    m_blockBegin.push_back(m_instrViews.size());
+    for (auto &&instr : *bb) {
+      assert(instr.getId() < m_instrHandles.size());
+      m_instrHandles[instr.getId()] = m_instrViews.size();
+      m_instrViews.push_back(&instr);
+    }
+  }
+  m_blockBegin.push_back(m_instrViews.size());
+}
+
+void CompactFunction::buildInstrs() {
+  auto count = m_instrViews.size();
+  m_ids.reserve(count);
+  m_opcodes.reserve(count);
+  m_types.reserve(count);
+  m_parents.reserve(count);
+  m_aux.reserve(count);
+  m_operandBegin.reserve(count + 1);
+  m_blockOperandBegin.reserve(count + 1);
+
+  auto blockHandle = [this](BasicBlock *bb) {
+    return bb ? getHandle(bb) : kNoHandle;
+  };
+
+  Handle bb = 0;
+  for (Handle i = 0; i < count; ++i) {
+    while (i >= m_blockBegin[bb + 1]) {
+      ++bb;
+    }
+
+    auto *instr = m_instrViews[i];
+    auto opcode = instr->getOpcode();
+    m_ids.push_back(instr->getId());
+    m_opcodes.push_back(static_cast<std::uint8_t>(opcode));
+    m_types.push_back(static_cast<std::uint8_t>(instr->getType()));
+    m_parents.push_back(bb);
+
+    m_operandBegin.push_back(m_operands.size());
+    for (auto *input : *instr) {
+      m_operands.push_back(input ? getHandle(input) : kNoHandle);
+    }
+
+    m_blockOperandBegin.push_back(m_blockOperands.size());
+    std::uint32_t aux = 0;
+    switch (opcode) {
+    case Opcode::IF: {
+      auto *ifInstr = static_cast<IfInstr *>(instr);
+      m_blockOperands.push_back(blockHandle(ifInstr->getTrueBB()));
+      m_blockOperands.push_back(blockHandle(ifInstr->getFalseBB()));
+      break;
+    }
+    case Opcode::GOTO: {
+      auto *gotoInstr = static_cast<GotoInstr *>(instr);
+      m_blockOperands.push_back(blockHandle(gotoInstr->getBB()));
+      break;
+    }
+    case Opcode::PHI: {
+      auto *phi = static_cast<PhiInstr *>(instr);
+      for (std::size_t idx = 0; idx < phi->numOptions(); ++idx) {
+        m_blockOperands.push_back(blockHandle(phi->getIncomingBlock(idx)));
+      }
+      break;
+    }
+    case Opcode::CONST: {
+      aux = m_imms.size();
+      if (instr->getType() == Type::I1) {
+        m_imms.push_back(static_cast<ConstI1 *>(instr)->getValue());
+      } else {
+        m_imms.push_back(loadIntegerConst(instr).value());
+      }
+      break;
+    }
+    case Opcode::CALL: {
+      aux = m_callees.size();
+      m_callees.push_back(static_cast<CallInstr *>(instr)->getCallee());
+      break;
+    }
+    default:
+      break;
+    }
+    m_aux.push_back(aux);
+  }
+
+  m_operandBegin.push_back(m_operands.size());
+  m_blockOperandBegin.push_back(m_blockOperands.size());
+}
+
+void CompactFunction::buildEdges() {
+  m_succBegin.reserve(numBlocks() + 1);
+  m_predBegin.reserve(numBlocks() + 1);
+
+  for (auto *bb : m_blockViews) {
+    m_succBegin.push_back(m_succs.size());
+    for (auto *succ : bb->successors()) {
+      m_succs.push_back(getHandle(succ));
+    }
+
+    m_predBegin.push_back(m_preds.size());
+    for (auto *pred : bb->predecessors()) {
+      m_preds.push_back(getHandle(pred));
+    }
+  }
+
+  m_succBegin.push_back(m_succs.size());
+  m_predBegin.push_back(m_preds.size());
+}
+
+template <typename T> static std::size_t sizeOf(const std::vector<T> &vec) {
+  return vec.size() * sizeof(T);
+}
+
+std::size_t CompactFunction::tableBytes() const {
+  return sizeOf(m_ids) + sizeOf(m_opcodes) + sizeOf(m_types) +
+         sizeOf(m_parents) + sizeOf(m_aux) + sizeOf(m_operandBegin) +
+         sizeOf(m_operands) + sizeOf(m_blockOperandBegin) +
+         sizeOf(m_blockOperands) + sizeOf(m_imms) + sizeOf(m_callees) +
+         sizeOf(m_blockIds) + sizeOf(m_blockBegin) + sizeOf(m_succBegin) +
+         sizeOf(m_succs) + sizeOf(m_predBegin) + sizeOf(m_preds);
+}
+
+std::size_t CompactFunction::bytes() const {
+  return tableBytes() + sizeOf(m_instrViews) + sizeOf(m_blockViews) +
+         sizeOf(m_instrHandles) + sizeOf(m_blockHandles);
+}
+
+} // namespace jade
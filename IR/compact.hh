@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "IR.hh"
+#include "function.hh"
+#include "opcodes.hh"
+
+namespace jade {
+
+class CompactFunction;
+
+// 32-bit index of an instruction or a block inside a CompactFunction.
+using Handle = std::uint32_t;
+inline constexpr Handle kNoHandle = std::numeric_limits<Handle>::max();
+
+template <typename T> class HandleSpan {
+public:
+  HandleSpan(const T *begin, const T *end) : m_begin{begin}, m_end{end} {}
+
+  const T *begin() const { return m_begin; }
+  const T *end() const { return m_end; }
+  std::size_t size() const { return m_end - m_begin; }
+  T operator[](std::size_t idx) const { return m_begin[idx]; }
+
+private:
+  const T *m_begin;
+  const T *m_end;
+};
+
+// Thin view of one row of the instruction table. Hot properties are loaded
+// from the dense tables, everything else goes through the Instruction.
+class InstrRef {
+public:
+  InstrRef(const CompactFunction *fn, Handle handle)
+      : m_fn{fn}, m_handle{handle} {}
+
+  Handle handle() const { return m_handle; }
+
+  inline std::size_t getId() const;
+  inline Opcode getOpcode() const;
+  inline Type::Tag getType() const;
+  inline Handle getParent() const;
+  inline std::size_t numInputs() const;
+  inline InstrRef input(std::size_t idx) const;
+
+  inline Instruction *get() const;
+  Instruction *operator->() const { return get(); }
+
+  bool operator==(const InstrRef &rhs) const {
+    return m_fn == rhs.m_fn && m_handle == rhs.m_handle;
+  }
+  bool operator!=(const InstrRef &rhs) const { return !(*this == rhs); }
+
+private:
+  const CompactFunction *m_fn;
+  Handle m_handle;
+};
+
+// Structure-of-arrays snapshot of a Function. Instructions are numbered in
+// layout order and referenced by 32-bit handles, operands of all
+// instructions sit in one contiguous pool. Scans that run more than once over
+// an unchanged function, as Liveness::buildProblem, read the tables instead
+// of chasing the instruction lists. The snapshot is not updated by IR edits:
+// build a new one after the function changes.
+class CompactFunction final {
+public:
+  explicit CompactFunction(Function &fn);
+
+  std::size_t numInstrs() const { return m_opcodes.size(); }
+  std::size_t numBlocks() const { return m_blockViews.size(); }
+  // bounds of the function's value and block ids, see Function::numValues
+  std::size_t numValues() const { return m_instrHandles.size(); }
+  std::size_t numBlockIds() const { return m_blockHandles.size(); }
+
+  InstrRef instr(Handle handle) const { return InstrRef{this, handle}; }
+  Handle getHandle(const Instruction *instr) const {
+    auto id = instr->getId();
+    return id < m_instrHandles.size() ? m_instrHandles[id] : kNoHandle;
+  }
+  Handle getHandle(const BasicBlock *bb) const {
+    auto id = bb->getId();
+    return id < m_blockHandles.size() ? m_blockHandles[id] : kNoHandle;
+  }
+
+  // instruction table
+  std::size_t getId(Handle i) const { return m_ids[i]; }
+  Opcode getOpcode(Handle i) const {
+    return static_cast<Opcode>(m_opcodes[i]);
+  }
+  Type::Tag getType(Handle i) const {
+    return static_cast<Type::Tag>(m_types[i]);
+  }
+  Handle getParent(Handle i) const { return m_parents[i]; }
+  HandleSpan<Handle> operands(Handle i) const {
+    return {m_operands.data() + m_operandBegin[i],
+            m_operands.data() + m_operandBegin[i + 1]};
+  }
+  // successors of IF/GOTO and incoming blocks of PHI
+  HandleSpan<Handle> blockOperands(Handle i) const {
+    return {m_blockOperands.data() + m_blockOperandBegin[i],
+            m_blockOperands.data() + m_blockOperandBegin[i + 1]};
+  }
+  std::int64_t getImmediate(Handle i) const {
+    assert(getOpcode(i) == Opcode::CONST);
+    return m_imms[m_aux[i]];
+  }
+  Function *getCallee(Handle i) const {
+    assert(getOpcode(i) == Opcode::CALL);
+    return m_callees[m_aux[i]];
+  }
+  Instruction *view(Handle i) const { return m_instrViews[i]; }
+
+  // block table, instructions of a block are [blockBegin, blockEnd)
+  std::size_t getBlockId(Handle bb) const { return m_blockIds[bb]; }
+  Handle blockBegin(Handle bb) const { return m_blockBegin[bb]; }
+  Handle blockEnd(Handle bb) const { return m_blockBegin[bb + 1]; }
+  HandleSpan<Handle> successors(Handle bb) const {
+    return {m_succs.data() + m_succBegin[bb],
+            m_succs.data() + m_succBegin[bb + 1]};
+  }
+  HandleSpan<Handle> predecessors(Handle bb) const {
+    return {m_preds.data() + m_predBegin[bb],
+            m_preds.data() + m_predBegin[bb + 1]};
+  }
+  BasicBlock *blockView(Handle bb) const { return m_blockViews[bb]; }
+
+  // Memory held by the snapshot, including the views and handle tables. The
+  // snapshot lives next to the Function, so this is extra memory on top of
+  // the function's arena, not a replacement for it.
+  std::size_t bytes() const;
+  // Memory of the instruction and block tables alone, what a scan over the
+  // snapshot touches.
+  std::size_t tableBytes() const;
+
+private:
+  void buildBlocks(Function &fn);
+  void buildInstrs();
+  void buildEdges();
+
+  // instructions
+  std::vector<std::uint32_t> m_ids;
+  std::vector<std::uint8_t> m_opcodes;
+  std::vector<std::uint8_t> m_types;
+  std::vector<Handle> m_parents;
+  std::vector<std::uint32_t> m_aux;
+  std::vector<std::uint32_t> m_operandBegin;
+  std::vector<Handle> m_operands;
+  std::vector<std::uint32_t> m_blockOperandBegin;
+  std::vector<Handle> m_blockOperands;
+  std::vector<std::int64_t> m_imms;
+  std::vector<Function *> m_callees;
+
+  // blocks
+  std::vector<std::uint32_t> m_blockIds;
+  std::vector<Handle> m_blockBegin;
+  std::vector<std::uint32_t> m_succBegin;
+  std::vector<Handle> m_succs;
+  std::vector<std::uint32_t> m_predBegin;
+  std::vector<Handle> m_preds;
+
+  // views back into the pointer-based IR
+  std::vector<Instruction *> m_instrViews;
+  std::vector<BasicBlock *> m_blockViews;
+  // handles by value and block id, kNoHandle in the holes
+  std::vector<Handle> m_instrHandles;
+  std::vector<Handle> m_blockHandles;
+};
+
+std::size_t InstrRef::getId() const { return m_fn->getId(m_handle); }
+Opcode InstrRef::getOpcode() const { return m_fn->getOpcode(m_handle); }
+Type::Tag InstrRef::getType() const { return m_fn->getType(m_handle); }
+Handle InstrRef::getParent() const { return m_fn->getParent(m_handle); }
+std::size_t InstrRef::numInputs() const {
+  return m_fn->operands(m_handle).size();
+}
+InstrRef InstrRef::input(std::size_t idx) const {
+  return InstrRef{m_fn, m_fn->operands(m_handle)[idx]};
+}
+Instruction *InstrRef::get() const { return m_fn->view(m_handle); }
+
+} // namespace jade
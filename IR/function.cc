@@ -1,16 +1,38 @@
 #include "function.hh"
 #include "IR.hh"
 #include "opcodes.hh"
+#include "printer.hh"
+#include "valueMap.hh"
 #include <memory>
 
 namespace jade {
 
+Function::Function(Function &&other) noexcept
+    : m_arena{std::move(other.m_arena)}, m_bbs{std::move(other.m_bbs)},
+      m_numValues{std::exchange(other.m_numValues, 0)},
+      m_cfgEpoch{other.m_cfgEpoch},
+      m_name{std::move(other.m_name)},
+      m_materializer{std::exchange(other.m_materializer, nullptr)},
+      m_materialized{other.m_materialized} {
+  for (auto bb = m_bbs.begin(); bb != m_bbs.end(); ++bb) {
+    bb->setFunction(this);
+  }
+}
+
 void Function::insert(BasicBlock *bb) {
   std::size_t id = 0;
   if (!m_bbs.empty()) {
     id = m_bbs.getLast()->getId() + 1;
   }
   bb->setId(id);
+  // instructions coming from another function get ids of this one
+  if (bb->getFunction() && bb->getFunction() != this) {
+    for (auto &&instr : *bb) {
+      instr.setId(newValueId());
+    }
+  }
+  bb->setFunction(this);
+  invalidateCFG();
 
   std::stringstream name;
   name << "bb" << id;
@@ -19,25 +41,92 @@ void Function::insert(BasicBlock *bb) {
   m_bbs.push_back(bb);
 }
 
+void Function::clear() {
+  m_bbs = BasicBlocks{};
+  m_arena = Arena{};
+  m_numValues = 0;
+  invalidateCFG();
+  m_postOrder.clear();
+  m_rpo.clear();
+}
+
+void Function::computeOrders() {
+  m_postOrder.clear();
+  if (!m_bbs.empty()) {
+    auto graph = getBasicBlocks();
+    m_postOrder = PostOrderIterator<BasicBlocksGraph>::collect(graph);
+  }
+  m_rpo.assign(m_postOrder.rbegin(), m_postOrder.rend());
+  m_ordersEpoch = m_cfgEpoch;
+}
+
+const std::vector<BasicBlock *> &Function::postOrder() {
+  if (m_ordersEpoch != m_cfgEpoch) {
+    computeOrders();
+  }
+  return m_postOrder;
+}
+
+const std::vector<BasicBlock *> &Function::rpo() {
+  if (m_ordersEpoch != m_cfgEpoch) {
+    computeOrders();
+  }
+  return m_rpo;
+}
+
+bool Function::collectCallees(std::vector<Function *> &callees) {
+  std::lock_guard lock{m_lock};
+  if (!m_materialized) {
+    return m_materializer && m_materializer->collectCallees(*this, callees);
+  }
+
+  for (auto &&bb : m_bbs) {
+    for (auto &&instr : bb) {
+      if (instr.getOpcode() == Opcode::CALL) {
+        callees.push_back(static_cast<const CallInstr &>(instr).getCallee());
+      }
+    }
+  }
+  return true;
+}
+
+void Function::dump(std::ostream &stream) const {
+  PrintBuffer buf{stream, PrintBuffer::kBulkReserve};
+  IRPrinter{buf}.print(*this);
+}
+
+void Function::renumber() {
+  std::size_t bbId = 0;
+  std::size_t valueId = 0;
+  for (auto bb = m_bbs.begin(); bb != m_bbs.end(); ++bb) {
+    bb->setId(bbId++);
+    for (auto &&instr : *bb) {
+      instr.setId(valueId++);
+    }
+  }
+  m_numValues = valueId;
+}
+
 std::unique_ptr<Function> Function::copy() const {
-  auto ret = std::make_unique<Function>();
+  std::lock_guard lock{m_lock};
+  assert(m_materialized && "copy of a function that is not materialized");
+  auto ret = std::make_unique<Function>(m_name);
 
   // map: old -> new
-  std::unordered_map<Instruction *, Instruction *> instrMapping;
-  std::unordered_map<BasicBlock *, BasicBlock *> bbsMapping;
+  auto instrMapping = ValueMap<Instruction *>(m_numValues);
+  auto bbsMapping = BlockMap<BasicBlock *>(numBlocks());
 
   // shallow copy
   for (auto bb = m_bbs.begin(); bb != m_bbs.end(); ++bb) {
-    auto *newBB = new BasicBlock{};
+    auto *newBB = ret->create<BasicBlock>();
 
     for (auto instr = bb->begin(); instr != bb->end(); ++instr) {
-      auto *newInstr = instr->copy();
+      auto *newInstr = instr->copy(ret->getArena());
       newBB->insert(newInstr);
       instrMapping[&*instr] = newInstr;
     }
 
     bbsMapping[&*bb] = newBB;
-    ret->insert(newBB);
   }
 
   // replace users/inputs.
@@ -54,9 +143,9 @@ std::unique_ptr<Function> Function::copy() const {
 
       if (newInstr->getOpcode() == Opcode::PHI) {
         auto *phiInstr = static_cast<PhiInstr *>(&*newInstr);
-        for (auto opt : *phiInstr) {
-          opt.first = bbsMapping[opt.first];
-          opt.second = instrMapping[opt.second];
+        for (std::size_t i = 0; i < phiInstr->numOptions(); ++i) {
+          phiInstr->setIncomingBlock(
+              i, bbsMapping[phiInstr->getIncomingBlock(i)]);
         }
 
         phiInstr->getParent()->addPhi(phiInstr);
@@ -71,9 +160,10 @@ std::unique_ptr<Function> Function::copy() const {
         ifInstr->getParent()->addSuccessor(ifInstr->getFalseBB());
       }
 
-      for (auto input = newInstr->begin(); input != newInstr->end(); ++input) {
-        *input = instrMapping[*input];
-        (*input)->addUser(&*newInstr);
+      for (auto &use : newInstr->operands()) {
+        if (use.get()) {
+          use.set(instrMapping[use.get()]);
+        }
       }
     }
   }
@@ -1,20 +1,24 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <sstream>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "IR.hh"
+#include "arena.hh"
 #include "graph.hh"
 #include "ilist.hh"
 
 namespace jade {
 
-using BasicBlocks = IList<BasicBlock>;
-using BasicBlocksRef = IList<BasicBlock, IListBorrower<BasicBlock>>;
+using BasicBlocks = IList<BasicBlock, IListArenaOwner<BasicBlock>>;
+using BasicBlocksRef = IListView<BasicBlock>;
 
 class BasicBlocksGraph {
 private:
@@ -60,40 +64,141 @@ template <> struct GraphTraits<BasicBlocksGraph> {
   static EdgesItTy inEdgeEnd(NodeTy node) { return node->predecessors().end(); }
 };
 
+class Function;
+
+// Supplies the body of a function that is kept out of memory until it is
+// needed (see LazyModule).
+class Materializer {
+public:
+  virtual ~Materializer() = default;
+
+  virtual bool materialize(Function &fn) = 0;
+  virtual void dematerialize(Function &fn) = 0;
+  // Callees of the CALL sites of fn, read without materializing it.
+  virtual bool collectCallees(const Function &fn,
+                              std::vector<Function *> &callees) = 0;
+};
+
+// Told about every edge added to or removed from the CFG of a function,
+// right after the edit (see DomTreeListener).
+class CFGListener {
+public:
+  virtual ~CFGListener() = default;
+
+  virtual void edgeInserted(BasicBlock *from, BasicBlock *to) = 0;
+  virtual void edgeDeleted(BasicBlock *from, BasicBlock *to) = 0;
+};
+
 class Function {
 public:
   using iterator = IListIterator<BasicBlock>;
 
+  Function() = default;
+  explicit Function(std::string name) : m_name{std::move(name)} {}
+  Function(Function &&other) noexcept;
+  Function &operator=(Function &&other) = delete;
+
   template <typename T, typename... Args> T *create(Args &&...args);
   void insert(BasicBlock *bb);
-  void remove(BasicBlock *bb) { m_bbs.remove(bb); }
+  void remove(BasicBlock *bb) {
+    m_bbs.remove(bb);
+    invalidateCFG();
+  }
   std::unique_ptr<Function> copy() const;
 
   auto getBasicBlocks() { return BasicBlocksGraph(m_bbs.borrow()); }
-  void dump(std::ostream &stream) {
-    for (auto bb = m_bbs.begin(); bb != m_bbs.end(); ++bb) {
-      stream << bb->getName() << ": " << std::endl;
-      bb->dump(stream);
-      stream << std::endl;
+
+  // Values are numbered densely across the whole function: ids index
+  // ValueMap/BlockMap side tables. Ids stay unique under edits but leave
+  // holes, renumber() makes them dense again in layout order.
+  std::size_t newValueId() { return m_numValues++; }
+  std::size_t numValues() const { return m_numValues; }
+  std::size_t numBlocks() const {
+    return m_bbs.empty() ? 0 : m_bbs.getLast()->getId() + 1;
+  }
+  void renumber();
+
+  // Bumped by every change of the block list or of an edge: anything derived
+  // from the CFG stays valid while the epoch is the same.
+  std::uint64_t getCFGEpoch() const { return m_cfgEpoch; }
+  void invalidateCFG() { ++m_cfgEpoch; }
+  // One listener at most, it is not carried over by a move.
+  void setCFGListener(CFGListener *listener) { m_cfgListener = listener; }
+  CFGListener *getCFGListener() const { return m_cfgListener; }
+  // Block orders from the entry, computed on the first request after an
+  // edit. Callers that change the CFG while walking one must copy it.
+  const std::vector<BasicBlock *> &postOrder();
+  const std::vector<BasicBlock *> &rpo();
+
+  // Backing storage of every block and instruction of the function.
+  Arena &getArena() { return m_arena; }
+  const Arena &getArena() const { return m_arena; }
+  // Drop the whole body at once.
+  void clear();
+
+  const std::string &getName() const { return m_name; }
+  void setName(std::string name) { m_name = std::move(name); }
+
+  // A lazily loaded function has no body until it is materialized: anything
+  // that walks a function it did not build (passes, Inline) materializes it
+  // first. A cold function can give its memory back with dematerialize.
+  // Materializing and copying are safe from many threads at once, so callers
+  // compiled in parallel can share a callee.
+  void setMaterializer(Materializer *materializer, bool materialized) {
+    m_materializer = materializer;
+    m_materialized = materialized;
+  }
+  bool isMaterialized() const { return m_materialized; }
+  bool materialize() {
+    std::lock_guard lock{m_lock};
+    if (!m_materialized && m_materializer) {
+      m_materialized = m_materializer->materialize(*this);
+    }
+    return m_materialized;
+  }
+  // Appends the callee of every CALL to callees, in layout order. A function
+  // that is not materialized stays so: its materializer reads the callees.
+  bool collectCallees(std::vector<Function *> &callees);
+  void dematerialize() {
+    std::lock_guard lock{m_lock};
+    if (m_materialized && m_materializer) {
+      m_materializer->dematerialize(*this);
+      m_materialized = false;
     }
   }
 
+  auto begin() const { return m_bbs.begin(); }
+  auto end() const { return m_bbs.end(); }
+
+  void dump(std::ostream &stream) const;
+
 private:
+  // Declared first: blocks are destroyed by the arena after the list is gone.
+  Arena m_arena;
   BasicBlocks m_bbs;
+  std::size_t m_numValues{0};
+
+  void computeOrders();
+  std::uint64_t m_cfgEpoch{1};
+  // epoch the orders were computed at, 0 when never
+  std::uint64_t m_ordersEpoch{0};
+  CFGListener *m_cfgListener{nullptr};
+  std::vector<BasicBlock *> m_postOrder;
+  std::vector<BasicBlock *> m_rpo;
+
+  std::string m_name;
+  Materializer *m_materializer{nullptr};
+  bool m_materialized{true};
+  // copy() links uses into this function for a while
+  mutable std::mutex m_lock;
 };
 
 template <typename T, typename... Args> T *Function::create(Args &&...args) {
   assert(0);
 }
 
-template <> inline BasicBlock *Function::create<BasicBlock>(BasicBlock &bb) {
-  auto *copy = new BasicBlock{bb};
-  insert(copy);
-  return copy;
-}
-
 template <> inline BasicBlock *Function::create<BasicBlock>() {
-  auto *bb = new BasicBlock{};
+  auto *bb = m_arena.create<BasicBlock>();
   insert(bb);
   return bb;
 }
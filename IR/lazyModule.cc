@@ -0,0 +1,130 @@
+#include "lazyModule.hh"
+#include "function.hh"
+#include "serialize.hh"
+#include <algorithm>
+
+namespace jade {
+
+std::unique_ptr<LazyModule> LazyModule::open(const std::string &path,
+                                             DecodeError *error) {
+  auto file = MappedFile::open(path);
+  if (!file) {
+    if (error) {
+      *error = DecodeError{0, "cannot open " + path};
+    }
+    return nullptr;
+  }
+
+  auto module = std::unique_ptr<LazyModule>(new LazyModule);
+  module->m_file = std::move(file);
+  if (!module->init(module->m_file->view(), error)) {
+    return nullptr;
+  }
+  return module;
+}
+
+std::unique_ptr<LazyModule> LazyModule::load(std::string_view data,
+                                             DecodeError *error) {
+  auto module = std::unique_ptr<LazyModule>(new LazyModule);
+  if (!module->init(data, error)) {
+    return nullptr;
+  }
+  return module;
+}
+
+bool LazyModule::init(std::string_view data, DecodeError *error) {
+  std::vector<ModuleEntry> index;
+  if (!readModuleIndex(data, index, error)) {
+    return false;
+  }
+
+  m_entries.resize(index.size());
+  m_functions.reserve(index.size());
+  for (std::size_t idx = 0; idx < index.size(); ++idx) {
+    auto &entry = m_entries[idx];
+    entry.fn = std::make_unique<Function>(std::string{index[idx].name});
+    entry.fn->setMaterializer(this, false);
+    entry.record = index[idx].record;
+
+    m_functions.push_back(entry.fn.get());
+    m_ids[entry.fn.get()] = idx + 1;
+    m_byName.emplace(entry.fn->getName(), idx);
+  }
+  return true;
+}
+
+Function *LazyModule::getFunction(std::string_view name) {
+  auto it = m_byName.find(name);
+  return it == m_byName.end() ? nullptr : m_entries[it->second].fn.get();
+}
+
+bool LazyModule::materialize(Function &fn) {
+  std::lock_guard lock{m_mutex};
+  auto &entry = m_entries[indexOf(fn)];
+  entry.lastUse = ++m_clock;
+  if (!readRecord(entry.record, fn, &m_functions, &m_error)) {
+    fn.clear();
+    return false;
+  }
+  return true;
+}
+
+void LazyModule::dematerialize(Function &fn) {
+  std::lock_guard lock{m_mutex};
+  auto &entry = m_entries[indexOf(fn)];
+  // the body may have been changed by passes: keep the current one
+  entry.encoded.clear();
+  writeRecord(fn, entry.encoded, &m_ids);
+  entry.record = entry.encoded;
+  fn.clear();
+}
+
+bool LazyModule::collectCallees(const Function &fn,
+                                std::vector<Function *> &callees) {
+  std::lock_guard lock{m_mutex};
+  auto &entry = m_entries[indexOf(fn)];
+  return readRecordCallees(entry.record, &m_functions, callees, &m_error);
+}
+
+void LazyModule::trim(std::size_t budget) {
+  auto used = materializedBytes();
+  if (used <= budget) {
+    return;
+  }
+
+  std::vector<Entry *> live;
+  for (auto &&entry : m_entries) {
+    if (entry.fn->isMaterialized()) {
+      live.push_back(&entry);
+    }
+  }
+  std::sort(live.begin(), live.end(), [](Entry *lhs, Entry *rhs) {
+    return lhs->lastUse < rhs->lastUse;
+  });
+
+  for (auto *entry : live) {
+    if (used <= budget) {
+      break;
+    }
+    used -= entry->fn->getArena().bytesAllocated();
+    entry->fn->dematerialize();
+  }
+}
+
+std::size_t LazyModule::materializedBytes() const {
+  std::size_t bytes = 0;
+  for (auto &&entry : m_entries) {
+    if (entry.fn->isMaterialized()) {
+      bytes += entry.fn->getArena().bytesAllocated();
+    }
+  }
+  return bytes;
+}
+
+std::size_t LazyModule::numMaterialized() const {
+  return std::count_if(m_entries.begin(), m_entries.end(), [](auto &&entry) {
+    return entry.fn->isMaterialized();
+  });
+}
+
+} // namespace jade
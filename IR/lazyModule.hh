@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "function.hh"
+#include "mappedFile.hh"
+#include "serialize.hh"
+
+namespace jade {
+
+// Functions of a module file (see writeModule) loaded on demand. Opening a
+// module only reads its index: every function starts as an empty shell and
+// its blocks and instructions are decoded from the mapped record on the
+// first materialize(). Calls between functions point at the shells, so a
+// callee is decoded only when somebody walks it.
+//
+// Under memory pressure trim() dematerializes the least recently
+// materialized functions: their current body is encoded again into a private
+// buffer and the arena is released.
+class LazyModule final : public Materializer {
+public:
+  LazyModule(const LazyModule &) = delete;
+  LazyModule &operator=(const LazyModule &) = delete;
+
+  static std::unique_ptr<LazyModule> open(const std::string &path,
+                                          DecodeError *error = nullptr);
+  // data must outlive the module
+  static std::unique_ptr<LazyModule> load(std::string_view data,
+                                          DecodeError *error = nullptr);
+
+  std::size_t size() const { return m_entries.size(); }
+  // Accessors return the shell, materialize() it to get the body.
+  Function *getFunction(std::size_t idx) { return m_entries[idx].fn.get(); }
+  Function *getFunction(std::string_view name);
+
+  bool materialize(Function &fn) override;
+  void dematerialize(Function &fn) override;
+  bool collectCallees(const Function &fn,
+                      std::vector<Function *> &callees) override;
+
+  // Dematerialize functions, oldest first, until the bodies in memory take at
+  // most budget bytes of arena storage.
+  void trim(std::size_t budget);
+  std::size_t materializedBytes() const;
+  std::size_t numMaterialized() const;
+
+  const DecodeError &getError() const { return m_error; }
+
+private:
+  LazyModule() = default;
+  bool init(std::string_view data, DecodeError *error);
+
+  struct Entry {
+    std::unique_ptr<Function> fn;
+    // points into the mapping, or into encoded once dematerialized
+    std::string_view record;
+    std::string encoded;
+    std::uint64_t lastUse{0};
+  };
+
+  std::size_t indexOf(const Function &fn) const {
+    return m_ids.at(&fn) - 1;
+  }
+
+  std::optional<MappedFile> m_file;
+  std::vector<Entry> m_entries;
+  // callee table of the records and its inverse (1-based ids)
+  std::vector<Function *> m_functions;
+  CalleeIds m_ids;
+  std::unordered_map<std::string_view, std::size_t> m_byName;
+  std::uint64_t m_clock{0};
+  DecodeError m_error;
+  // functions are materialized from the workers of a parallel compilation
+  std::mutex m_mutex;
+};
+
+} // namespace jade
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace jade {
+
+// Read-only memory mapping of a whole file.
+class MappedFile final {
+public:
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&other) noexcept
+      : m_data{std::exchange(other.m_data, nullptr)},
+        m_size{std::exchange(other.m_size, 0)} {}
+  MappedFile &operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+      unmap();
+      m_data = std::exchange(other.m_data, nullptr);
+      m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+  }
+
+  ~MappedFile() { unmap(); }
+
+  static std::optional<MappedFile> open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return std::nullopt;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      return std::nullopt;
+    }
+
+    auto size = static_cast<std::size_t>(st.st_size);
+    void *data = nullptr;
+    // mmap does not accept empty mappings
+    if (size) {
+      data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        ::close(fd);
+        return std::nullopt;
+      }
+      ::madvise(data, size, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+
+    return MappedFile{static_cast<const char *>(data), size};
+  }
+
+  const char *data() const { return m_data; }
+  std::size_t size() const { return m_size; }
+  std::string_view view() const { return {m_data, m_size}; }
+
+private:
+  MappedFile(const char *data, std::size_t size)
+      : m_data{data}, m_size{size} {}
+
+  void unmap() {
+    if (m_data) {
+      ::munmap(const_cast<char *>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+  }
+
+  const char *m_data{nullptr};
+  std::size_t m_size{0};
+};
+
+} // namespace jade
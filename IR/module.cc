@@ -0,0 +1,25 @@
+#include "module.hh"
+#include "function.hh"
+
+namespace jade {
+
+Function *Module::create(std::string name) {
+  return add(std::make_unique<Function>(std::move(name)));
+}
+
+Function *Module::add(std::unique_ptr<Function> fn) {
+  if (m_byName.count(fn->getName())) {
+    return nullptr;
+  }
+  auto *ptr = fn.get();
+  m_fns.push_back(std::move(fn));
+  m_byName.emplace(ptr->getName(), ptr);
+  return ptr;
+}
+
+Function *Module::getFunction(std::string_view name) const {
+  auto it = m_byName.find(name);
+  return it == m_byName.end() ? nullptr : it->second;
+}
+
+} // namespace jade
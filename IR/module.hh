@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "function.hh"
+
+namespace jade {
+
+// Owner of the functions of a program. Calls between them are plain
+// CallInstr -> Function* links, so functions must stay in the module for as
+// long as any of them is alive. Names are unique and fixed once a function
+// is added.
+class Module final {
+public:
+  using iterator = std::vector<std::unique_ptr<Function>>::const_iterator;
+
+  Module() = default;
+  Module(const Module &) = delete;
+  Module &operator=(const Module &) = delete;
+
+  // Returns nullptr when the name is taken.
+  Function *create(std::string name);
+  Function *add(std::unique_ptr<Function> fn);
+
+  Function *getFunction(std::string_view name) const;
+  Function *getFunction(std::size_t idx) const { return m_fns[idx].get(); }
+  std::size_t size() const { return m_fns.size(); }
+
+  iterator begin() const { return m_fns.begin(); }
+  iterator end() const { return m_fns.end(); }
+
+private:
+  std::vector<std::unique_ptr<Function>> m_fns;
+  std::unordered_map<std::string_view, Function *> m_byName;
+};
+
+} // namespace jade
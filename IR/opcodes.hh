@@ -1,64 +1,98 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string_view>
-#include <unordered_map>
 
 namespace jade {
 
-enum Opcode {
-  // cf
-  IF = 0,
-  GOTO,
-  RET,
-  PHI,
-  // cmp
-  LE,
-  EQ,
-  // logic
-  AND,
-  // arithm
-  ADD,
-  MUL,
-  SUB,
-  DIV,
-  NEG,
-  // checks
-  ZeroCheck,
-  BoundsCheck,
-  // other
-  ASHR,
-  SHL,
-  CAST,
-  CONST,
-  CALL,
-  PARAM,
+// How the result type of an instruction is derived.
+enum class ResultRule : std::uint8_t {
+  None,     // produces no value
+  Operand,  // type of the first operand
+  Bool,     // always i1
+  Explicit, // given at construction
 };
 
-inline std::string_view OpcodeToStr(Opcode opc) {
-  static std::unordered_map<Opcode, std::string_view> map = {
-      {Opcode::IF, "IF"},
-      {Opcode::GOTO, "GOTO"},
-      {Opcode::PHI, "PHI"},
-      {Opcode::LE, "LE"},
-      {Opcode::EQ, "EQ"},
-      {Opcode::ADD, "ADD"},
-      {Opcode::MUL, "MUL"},
-      {Opcode::SUB, "SUB"},
-      {Opcode::CAST, "CAST"},
-      {Opcode::CONST, "CONST"},
-      {Opcode::RET, "RET"},
-      {Opcode::AND, "AND"},
-      {Opcode::DIV, "DIV"},
-      {Opcode::NEG, "NEG"},
-      {Opcode::ASHR, "ASHR"},
-      {Opcode::SHL, "SHL"},
-      {Opcode::CALL, "CALL"},
-      {Opcode::PARAM, "PARAM"},
-      {Opcode::ZeroCheck, "ZeroCheck"},
-      {Opcode::BoundsCheck, "BoundsCheck"},
-  };
+// Number of value operands of instructions with a variable operand count.
+inline constexpr std::int8_t kVariadic = -1;
 
-  return map[opc];
+// X(opcode, arity, commutative, side effects, terminator, result, foldable)
+// The order of the rows defines the numeric values of Opcode.
+#define JADE_OPCODES(X)                                                        \
+  /* cf */                                                                     \
+  X(IF, 1, false, true, true, None, false)                                     \
+  X(GOTO, 0, false, true, true, None, false)                                   \
+  X(RET, kVariadic, false, true, true, Operand, false)                         \
+  X(PHI, kVariadic, false, false, false, Explicit, false)                      \
+  /* cmp */                                                                    \
+  X(LE, 2, false, false, false, Bool, false)                                   \
+  X(EQ, 2, true, false, false, Bool, false)                                    \
+  /* logic */                                                                  \
+  X(AND, 2, true, false, false, Operand, true)                                 \
+  /* arithm */                                                                 \
+  X(ADD, 2, true, false, false, Operand, true)                                 \
+  X(MUL, 2, true, false, false, Operand, true)                                 \
+  X(SUB, 2, false, false, false, Operand, true)                                \
+  X(DIV, 2, false, false, false, Operand, true)                                \
+  X(NEG, 1, false, false, false, Operand, true)                                \
+  /* checks */                                                                 \
+  X(ZeroCheck, 1, false, true, false, Operand, false)                          \
+  X(BoundsCheck, 2, false, true, false, Operand, false)                        \
+  /* other */                                                                  \
+  X(ASHR, 2, false, false, false, Operand, false)                              \
+  X(SHL, 2, false, false, false, Operand, false)                               \
+  X(CAST, 1, false, false, false, Explicit, false)                             \
+  X(CONST, 0, false, false, false, Explicit, false)                            \
+  X(CALL, kVariadic, false, true, false, Explicit, false)                      \
+  X(PARAM, 0, false, false, false, Explicit, false)
+
+enum Opcode : std::uint8_t {
+#define JADE_OPCODE_ENUM(opc, ...) opc,
+  JADE_OPCODES(JADE_OPCODE_ENUM)
+#undef JADE_OPCODE_ENUM
+};
+
+struct OpcodeInfo {
+  std::string_view name;
+  std::int8_t arity;
+  bool commutative;
+  bool sideEffects;
+  bool terminator;
+  ResultRule result;
+  bool foldable;
+};
+
+inline constexpr std::array kOpcodeInfo = {
+#define JADE_OPCODE_INFO(opc, arity, comm, side, term, res, fold)              \
+  OpcodeInfo{#opc, arity, comm, side, term, ResultRule::res, fold},
+    JADE_OPCODES(JADE_OPCODE_INFO)
+#undef JADE_OPCODE_INFO
+};
+
+inline constexpr std::size_t kNumOpcodes = kOpcodeInfo.size();
+
+constexpr const OpcodeInfo &getOpcodeInfo(Opcode opc) {
+  return kOpcodeInfo[opc];
+}
+
+constexpr std::string_view OpcodeToStr(Opcode opc) {
+  return getOpcodeInfo(opc).name;
+}
+constexpr bool isTerminator(Opcode opc) {
+  return getOpcodeInfo(opc).terminator;
 }
+constexpr bool isCommutative(Opcode opc) {
+  return getOpcodeInfo(opc).commutative;
+}
+constexpr bool hasSideEffects(Opcode opc) {
+  return getOpcodeInfo(opc).sideEffects;
+}
+constexpr bool isFoldable(Opcode opc) { return getOpcodeInfo(opc).foldable; }
+
+static_assert(OpcodeToStr(Opcode::IF) == "IF");
+static_assert(OpcodeToStr(Opcode::PARAM) == "PARAM");
+static_assert(kNumOpcodes == Opcode::PARAM + 1);
 
 } // namespace jade
@@ -0,0 +1,612 @@
+#include "parser.hh"
+#include "IR.hh"
+#include "function.hh"
+#include "mappedFile.hh"
+#include "module.hh"
+#include "opcodes.hh"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <optional>
+
+namespace jade {
+
+namespace {
+
+constexpr std::uint32_t kNoSlot = NameTable::kNone;
+
+bool isSeparator(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == ',';
+}
+
+// Cut the next token off the front of str.
+std::string_view nextToken(std::string_view &str) {
+  std::size_t begin = 0;
+  while (begin < str.size() && isSeparator(str[begin])) {
+    ++begin;
+  }
+  std::size_t end = begin;
+  while (end < str.size() && !isSeparator(str[end])) {
+    ++end;
+  }
+
+  auto token = str.substr(begin, end - begin);
+  str.remove_prefix(end);
+  return token;
+}
+
+// Opcode names are told apart by their first, second and last characters
+// and their length. A multiplicative hash of those is collision-free over
+// the opcode table, so a lookup is one probe and one compare.
+constexpr std::uint32_t kOpcodeHashMul = 0xfce5d2c7;
+constexpr std::size_t kOpcodeHashBits = 6;
+constexpr std::uint8_t kNoOpcode = 0xff;
+
+constexpr std::size_t opcodeHash(std::string_view name) {
+  auto key = static_cast<std::uint32_t>(static_cast<unsigned char>(name[0])) |
+             static_cast<std::uint32_t>(static_cast<unsigned char>(name[1]))
+                 << 8 |
+             static_cast<std::uint32_t>(
+                 static_cast<unsigned char>(name[name.size() - 1]))
+                 << 16 |
+             static_cast<std::uint32_t>(name.size()) << 24;
+  return static_cast<std::uint32_t>(key * kOpcodeHashMul) >>
+         (32 - kOpcodeHashBits);
+}
+
+constexpr std::array<std::uint8_t, 1 << kOpcodeHashBits> makeOpcodeTable() {
+  std::array<std::uint8_t, 1 << kOpcodeHashBits> table{};
+  for (auto &slot : table) {
+    slot = kNoOpcode;
+  }
+  for (std::size_t opc = 0; opc < kNumOpcodes; ++opc) {
+    table[opcodeHash(kOpcodeInfo[opc].name)] = static_cast<std::uint8_t>(opc);
+  }
+  return table;
+}
+
+constexpr auto kOpcodeTable = makeOpcodeTable();
+
+constexpr bool isOpcodeHashPerfect() {
+  for (std::size_t opc = 0; opc < kNumOpcodes; ++opc) {
+    if (kOpcodeTable[opcodeHash(kOpcodeInfo[opc].name)] != opc) {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(isOpcodeHashPerfect(),
+              "opcode names collide, pick another kOpcodeHashMul");
+
+std::optional<Opcode> lookupOpcode(std::string_view name) {
+  if (name.size() < 2) {
+    return std::nullopt;
+  }
+  auto opc = kOpcodeTable[opcodeHash(name)];
+  if (opc == kNoOpcode || kOpcodeInfo[opc].name != name) {
+    return std::nullopt;
+  }
+  return static_cast<Opcode>(opc);
+}
+
+std::optional<Type> lookupType(std::string_view name) {
+  if (name == "none") {
+    return Type{Type::None};
+  }
+  if (name.size() < 2 || name[0] != 'i') {
+    return std::nullopt;
+  }
+  switch (name.size()) {
+  case 2:
+    if (name[1] == '1') {
+      return Type{Type::I1};
+    }
+    if (name[1] == '8') {
+      return Type{Type::I8};
+    }
+    break;
+  case 3:
+    if (name[1] == '1' && name[2] == '6') {
+      return Type{Type::I16};
+    }
+    if (name[1] == '3' && name[2] == '2') {
+      return Type{Type::I32};
+    }
+    if (name[1] == '6' && name[2] == '4') {
+      return Type{Type::I64};
+    }
+    break;
+  default:
+    break;
+  }
+  return std::nullopt;
+}
+
+} // namespace
+
+std::uint64_t NameTable::hash(std::string_view name) {
+  // FNV-1a
+  std::uint64_t hash = 14695981039346656037ull;
+  for (auto c : name) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+  }
+  return hash;
+}
+
+void NameTable::reserve(std::size_t count) {
+  std::size_t capacity = 16;
+  while (capacity < 2 * count) {
+    capacity *= 2;
+  }
+  if (capacity <= m_entries.size()) {
+    return;
+  }
+
+  auto old = std::move(m_entries);
+  m_entries.assign(capacity, Entry{});
+  auto mask = capacity - 1;
+  for (auto &&entry : old) {
+    if (entry.slot == kNone) {
+      continue;
+    }
+    auto idx = entry.hash & mask;
+    while (m_entries[idx].slot != kNone) {
+      idx = (idx + 1) & mask;
+    }
+    m_entries[idx] = entry;
+  }
+}
+
+void NameTable::grow() { reserve(std::max<std::size_t>(8, m_count + 1)); }
+
+std::uint32_t NameTable::find(std::string_view name) const {
+  if (m_entries.empty()) {
+    return kNone;
+  }
+
+  auto h = hash(name);
+  auto mask = m_entries.size() - 1;
+  for (auto idx = h & mask;; idx = (idx + 1) & mask) {
+    auto &entry = m_entries[idx];
+    if (entry.slot == kNone) {
+      return kNone;
+    }
+    if (entry.hash == h && std::string_view{entry.data, entry.size} == name) {
+      return entry.slot;
+    }
+  }
+}
+
+std::uint32_t NameTable::insert(std::string_view name, std::uint32_t slot,
+                                bool &inserted) {
+  // keep the load factor at or below 1/2
+  if (2 * (m_count + 1) > m_entries.size()) {
+    grow();
+  }
+
+  auto h = hash(name);
+  auto mask = m_entries.size() - 1;
+  for (auto idx = h & mask;; idx = (idx + 1) & mask) {
+    auto &entry = m_entries[idx];
+    if (entry.slot == kNone) {
+      entry = Entry{h, name.data(), static_cast<std::uint32_t>(name.size()),
+                    slot};
+      ++m_count;
+      inserted = true;
+      return slot;
+    }
+    if (entry.hash == h && std::string_view{entry.data, entry.size} == name) {
+      inserted = false;
+      return entry.slot;
+    }
+  }
+}
+
+std::unique_ptr<Function> IRParser::parse() {
+  auto fn = std::make_unique<Function>();
+  m_fn = fn.get();
+  // rough guess of one named value per 32 bytes of text
+  m_valueNames.reserve(m_text.size() / 32);
+  m_values.reserve(m_text.size() / 32);
+  // and of one block per 256 bytes
+  m_blockNames.reserve(m_text.size() / 256);
+  m_blocks.reserve(m_text.size() / 256);
+
+  std::size_t pos = 0;
+  while (pos < m_text.size()) {
+    auto eol = m_text.find('\n', pos);
+    if (eol == std::string_view::npos) {
+      eol = m_text.size();
+    }
+
+    ++m_line;
+    if (!parseLine(m_text.substr(pos, eol - pos))) {
+      return nullptr;
+    }
+    pos = eol + 1;
+  }
+
+  auto undefined = false;
+  m_blockNames.forEach([&](std::string_view name, std::uint32_t idx) {
+    if (!undefined && !m_blocks[idx].defined) {
+      m_line = m_blocks[idx].line;
+      undefined = !error("undefined block " + std::string{name});
+    }
+  });
+  m_valueNames.forEach([&](std::string_view name, std::uint32_t idx) {
+    if (!undefined && !m_values[idx].defined) {
+      m_line = m_values[idx].line;
+      undefined = !error("undefined value " + std::string{name});
+    }
+  });
+  if (undefined) {
+    return nullptr;
+  }
+  for (auto [instr, line] : m_deferred) {
+    if (instr->input(0)->getType() != instr->input(1)->getType()) {
+      m_line = line;
+      error("operand type mismatch");
+      return nullptr;
+    }
+  }
+  for (std::size_t num = 0; num < m_numberedValues.size(); ++num) {
+    auto idx = m_numberedValues[num];
+    if (idx != kNoSlot && !m_values[idx].defined) {
+      m_line = m_values[idx].line;
+      error("undefined value %" + std::to_string(num));
+      return nullptr;
+    }
+  }
+
+  return fn;
+}
+
+bool IRParser::parseLine(std::string_view line) {
+  auto ref = nextToken(line);
+  if (ref.empty() || ref.front() == ';') {
+    return true;
+  }
+  if (ref.size() < 2 || ref.back() != ':') {
+    return error("expected label or instruction");
+  }
+  ref.remove_suffix(1);
+
+  auto rest = line;
+  if (nextToken(rest).empty()) {
+    return defineBlock(ref);
+  }
+  return parseInstr(ref, line);
+}
+
+bool IRParser::parseInstr(std::string_view ref, std::string_view rest) {
+  if (!m_cur) {
+    return error("instruction outside of a block");
+  }
+
+  auto opcTok = nextToken(rest);
+  auto opc = lookupOpcode(opcTok);
+  if (!opc) {
+    return error("unknown opcode " + std::string{opcTok});
+  }
+  auto typeTok = nextToken(rest);
+  auto type = lookupType(typeTok);
+  if (!type) {
+    return error("unknown type " + std::string{typeTok});
+  }
+
+  m_ops.clear();
+  for (auto tok = nextToken(rest); !tok.empty(); tok = nextToken(rest)) {
+    m_ops.push_back(tok);
+  }
+
+  const auto &info = getOpcodeInfo(*opc);
+  Instruction *instr = nullptr;
+  switch (*opc) {
+  case Opcode::PARAM:
+    instr = m_cur->create<ParamInstr>(*type);
+    break;
+  case Opcode::CONST: {
+    if (m_ops.size() != 1) {
+      return error("CONST expects one immediate");
+    }
+    std::int64_t val = 0;
+    auto imm = m_ops[0];
+    auto [ptr, ec] = std::from_chars(imm.data(), imm.data() + imm.size(), val);
+    if (ec != std::errc{} || ptr != imm.data() + imm.size()) {
+      return error("bad immediate " + std::string{imm});
+    }
+    switch (type->getType()) {
+    case Type::I64:
+      instr = m_cur->create<ConstI64>(val);
+      break;
+    case Type::I32:
+      instr = m_cur->create<ConstI32>(static_cast<std::int32_t>(val));
+      break;
+    case Type::I16:
+      instr = m_cur->create<ConstI16>(static_cast<std::int16_t>(val));
+      break;
+    case Type::I8:
+      instr = m_cur->create<ConstI8>(static_cast<std::int8_t>(val));
+      break;
+    case Type::I1:
+      instr = m_cur->create<ConstI1>(val != 0);
+      break;
+    default:
+      return error("CONST of type none");
+    }
+    break;
+  }
+  case Opcode::IF: {
+    if (m_ops.size() != 3 || m_ops[1].substr(0, 2) != "T:" ||
+        m_ops[2].substr(0, 2) != "F:") {
+      return error("IF expects <cond> T:<block> F:<block>");
+    }
+    auto *cond = useValue(m_ops[0], Type::I1);
+    if (!cond) {
+      return false;
+    }
+    auto *trueBB = useBlock(m_ops[1].substr(2));
+    auto *falseBB = useBlock(m_ops[2].substr(2));
+    instr = m_cur->create<IfInstr>(cond, falseBB, trueBB);
+    break;
+  }
+  case Opcode::GOTO:
+    if (m_ops.size() != 1) {
+      return error("GOTO expects one block");
+    }
+    instr = m_cur->create<GotoInstr>(useBlock(m_ops[0]));
+    break;
+  case Opcode::RET:
+    if (m_ops.size() > 1) {
+      return error("RET expects at most one value");
+    }
+    if (m_ops.empty()) {
+      instr = m_cur->create<RetInstr>();
+      break;
+    }
+    if (type->getType() == Type::None) {
+      return error("RET of a value of type none");
+    }
+    if (auto *val = useValue(m_ops[0], *type)) {
+      instr = m_cur->create<RetInstr>(val);
+      break;
+    }
+    return false;
+  case Opcode::PHI: {
+    if (m_ops.size() % 2) {
+      return error("PHI expects <block> <value> pairs");
+    }
+    auto *phi = m_cur->create<PhiInstr>(*type);
+    for (std::size_t idx = 0; idx < m_ops.size(); idx += 2) {
+      auto *val = useValue(m_ops[idx + 1], *type);
+      if (!val) {
+        return false;
+      }
+      phi->addOption(val, useBlock(m_ops[idx]));
+    }
+    instr = phi;
+    break;
+  }
+  case Opcode::CAST:
+    if (m_ops.size() != 1) {
+      return error("CAST expects one value");
+    }
+    instr = m_cur->create<CastInstr>(useValue(m_ops[0], Type{}), *type);
+    break;
+  case Opcode::CALL: {
+    if (m_ops.empty()) {
+      return error("CALL expects @<function> or null");
+    }
+    Function *callee = nullptr;
+    auto calleeTok = m_ops[0];
+    if (calleeTok.front() == '@') {
+      calleeTok.remove_prefix(1);
+      callee = m_module ? m_module->getFunction(calleeTok) : nullptr;
+      if (!callee) {
+        return error("unknown function " + std::string{calleeTok});
+      }
+    } else if (calleeTok != "null") {
+      return error("CALL expects @<function> or null");
+    }
+    auto *call = m_cur->create<CallInstr>(callee, *type);
+    for (std::size_t idx = 1; idx < m_ops.size(); ++idx) {
+      call->addArg(useValue(m_ops[idx], Type{}));
+    }
+    instr = call;
+    break;
+  }
+  default: {
+    if (static_cast<std::size_t>(info.arity) != m_ops.size()) {
+      return error(std::string{info.name} + " expects " +
+                   std::to_string(info.arity) + " operands");
+    }
+    if (info.arity == 1) {
+      auto *val = useValue(m_ops[0], *type);
+      if (!val) {
+        return false;
+      }
+      instr = m_cur->create<UnaryOp>(val, *opc);
+      break;
+    }
+
+    // comparisons produce i1: take the operand type from a known operand
+    auto hint = *type;
+    if (info.result == ResultRule::Bool) {
+      const auto *known = findValue(m_ops[0]);
+      if (!known) {
+        known = findValue(m_ops[1]);
+      }
+      hint = known ? Type{known->value->getType()} : Type{};
+    }
+    auto *lhs = useValue(m_ops[0], hint);
+    auto *rhs = lhs ? useValue(m_ops[1], Type{lhs->getType()}) : nullptr;
+    if (!rhs) {
+      return false;
+    }
+    if (info.result == ResultRule::Bool) {
+      instr = m_cur->create<CmpInstr>(lhs, rhs, *opc);
+      // both operands are forward references: compare once they are defined
+      if (lhs->getType() == Type::None) {
+        m_deferred.push_back({instr, m_line});
+      }
+    } else {
+      instr = m_cur->create<BinaryOp>(lhs, rhs, *opc);
+    }
+    break;
+  }
+  }
+
+  if (instr->getType() != type->getType()) {
+    return error(std::string{info.name} + " of type " +
+                 std::string{Type(instr->getType()).getName()} +
+                 " declared as " + std::string{type->getName()});
+  }
+
+  if (ref.front() != '%') {
+    instr->setName(std::string{ref});
+  }
+  return defineValue(ref, instr);
+}
+
+std::uint32_t IRParser::valueSlot(std::string_view name, bool &inserted) {
+  inserted = false;
+  std::uint32_t num = 0;
+  auto *end = name.data() + name.size();
+  if (name.size() > 1 && name.front() == '%' &&
+      std::from_chars(name.data() + 1, end, num).ptr == end) {
+    if (num >= m_numberedValues.size()) {
+      auto size = std::max<std::size_t>(num + 1, 2 * m_numberedValues.size());
+      m_numberedValues.resize(size, kNoSlot);
+    }
+    auto &idx = m_numberedValues[num];
+    if (idx == kNoSlot) {
+      idx = m_values.size();
+      inserted = true;
+    }
+    return idx;
+  }
+
+  return m_valueNames.insert(name, m_values.size(), inserted);
+}
+
+const IRParser::ValueSlot *IRParser::findValue(std::string_view name) const {
+  std::uint32_t num = 0;
+  auto *end = name.data() + name.size();
+  if (name.size() > 1 && name.front() == '%' &&
+      std::from_chars(name.data() + 1, end, num).ptr == end) {
+    if (num < m_numberedValues.size() && m_numberedValues[num] != kNoSlot) {
+      return &m_values[m_numberedValues[num]];
+    }
+    return nullptr;
+  }
+
+  auto idx = m_valueNames.find(name);
+  return idx == kNoSlot ? nullptr : &m_values[idx];
+}
+
+Instruction *IRParser::useValue(std::string_view name, Type expected) {
+  bool inserted = false;
+  auto idx = valueSlot(name, inserted);
+  if (inserted) {
+    // forward reference: a detached placeholder takes the uses for now
+    auto *placeholder = m_fn->getArena().create<ParamInstr>(expected);
+    m_values.push_back({placeholder, false, m_line});
+    return placeholder;
+  }
+
+  auto &slot = m_values[idx];
+  auto type = slot.value->getType();
+  if (expected.getType() == Type::None || type == expected.getType()) {
+    return slot.value;
+  }
+  if (type != Type::None) {
+    error("type mismatch for " + std::string{name} + ": expected " +
+          std::string{expected.getName()} + ", got " +
+          std::string{Type(type).getName()});
+    return nullptr;
+  }
+
+  // an untyped placeholder learns its type from the first typed use
+  auto *placeholder = m_fn->getArena().create<ParamInstr>(expected);
+  slot.value->replaceUsers(placeholder);
+  slot.value = placeholder;
+  return placeholder;
+}
+
+BasicBlock *IRParser::useBlock(std::string_view name) {
+  bool inserted = false;
+  auto idx = m_blockNames.insert(name, m_blocks.size(), inserted);
+  if (inserted) {
+    m_blocks.push_back({m_fn->getArena().create<BasicBlock>(), false, m_line});
+  }
+  return m_blocks[idx].bb;
+}
+
+bool IRParser::defineValue(std::string_view name, Instruction *instr) {
+  bool inserted = false;
+  auto idx = valueSlot(name, inserted);
+  if (inserted) {
+    m_values.push_back({instr, true, m_line});
+    return true;
+  }
+
+  auto &slot = m_values[idx];
+  if (slot.defined) {
+    return error("redefinition of " + std::string{name});
+  }
+  auto used = slot.value->getType();
+  if (used != Type::None && used != instr->getType()) {
+    return error("type mismatch for " + std::string{name} + ": used as " +
+                 std::string{Type(used).getName()} + ", defined as " +
+                 std::string{Type(instr->getType()).getName()});
+  }
+  slot.value->replaceUsers(instr);
+  slot.value = instr;
+  slot.defined = true;
+  return true;
+}
+
+bool IRParser::defineBlock(std::string_view name) {
+  auto *bb = useBlock(name);
+  auto &slot = m_blocks[m_blockNames.find(name)];
+  if (slot.defined) {
+    return error("redefinition of block " + std::string{name});
+  }
+  slot.defined = true;
+
+  m_fn->insert(bb);
+  bb->setName(std::string{name});
+  m_cur = bb;
+  return true;
+}
+
+bool IRParser::error(std::string message) {
+  m_error.line = m_line;
+  m_error.message = std::move(message);
+  return false;
+}
+
+std::unique_ptr<Function> parseIR(std::string_view text, ParseError *error,
+                                  const Module *module) {
+  IRParser parser{text, module};
+  auto fn = parser.parse();
+  if (!fn && error) {
+    *error = parser.getError();
+  }
+  return fn;
+}
+
+std::unique_ptr<Function> parseIRFile(const std::string &path,
+                                      ParseError *error,
+                                      const Module *module) {
+  auto file = MappedFile::open(path);
+  if (!file) {
+    if (error) {
+      *error = ParseError{0, "cannot open " + path};
+    }
+    return nullptr;
+  }
+  return parseIR(file->view(), error, module);
+}
+
+} // namespace jade
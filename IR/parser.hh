@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "IR.hh"
+#include "function.hh"
+
+namespace jade {
+
+class Module;
+
+struct ParseError {
+  std::size_t line{0};
+  std::string message;
+};
+
+// Open-addressing table from names (views into the parsed text) to dense
+// slot numbers. Entries are stored inline, so a lookup is one hash and
+// usually one cache line.
+class NameTable final {
+public:
+  static constexpr std::uint32_t kNone = ~std::uint32_t{0};
+
+  void reserve(std::size_t count);
+  std::uint32_t find(std::string_view name) const;
+  // Slot of name, a new name is given slot.
+  std::uint32_t insert(std::string_view name, std::uint32_t slot,
+                       bool &inserted);
+
+  template <typename Fn> void forEach(Fn fn) const {
+    for (auto &&entry : m_entries) {
+      if (entry.slot != kNone) {
+        fn(std::string_view{entry.data, entry.size}, entry.slot);
+      }
+    }
+  }
+
+private:
+  struct Entry {
+    std::uint64_t hash{0};
+    const char *data{nullptr};
+    std::uint32_t size{0};
+    std::uint32_t slot{kNone};
+  };
+
+  static std::uint64_t hash(std::string_view name);
+  void grow();
+
+  std::vector<Entry> m_entries;
+  std::size_t m_count{0};
+};
+
+// Single-pass parser for the textual form emitted by IRPrinter. Tokens are
+// views into the input and names are interned into dense slots; %<id> refs
+// are indexed by the number directly. A value or block used before its
+// definition gets a placeholder that is replaced (RAUW) once the definition
+// is reached. Lines starting with ';' are comments. CALL callees are looked
+// up by name in the module given to the parser.
+//
+// Types are checked as values are used and defined: a placeholder carries
+// the type its first typed use expects, and a definition of another type is
+// rejected.
+class IRParser final {
+public:
+  explicit IRParser(std::string_view text, const Module *module = nullptr)
+      : m_text{text}, m_module{module} {}
+
+  // Returns nullptr on malformed input, see getError().
+  std::unique_ptr<Function> parse();
+  const ParseError &getError() const { return m_error; }
+
+private:
+  // line keeps the first mention for "undefined" diagnostics
+  struct ValueSlot {
+    Instruction *value{nullptr};
+    bool defined{false};
+    std::size_t line{0};
+  };
+  struct BlockSlot {
+    BasicBlock *bb{nullptr};
+    bool defined{false};
+    std::size_t line{0};
+  };
+
+  bool parseLine(std::string_view line);
+  bool parseInstr(std::string_view ref, std::string_view rest);
+
+  // slot of a value name, unnamed values (%<id>) skip hashing
+  std::uint32_t valueSlot(std::string_view name, bool &inserted);
+  const ValueSlot *findValue(std::string_view name) const;
+  // Type::None accepts any type. Returns nullptr on a type mismatch.
+  Instruction *useValue(std::string_view name, Type expected);
+  BasicBlock *useBlock(std::string_view name);
+  bool defineValue(std::string_view name, Instruction *instr);
+  bool defineBlock(std::string_view name);
+
+  bool error(std::string message);
+
+  std::string_view m_text;
+  const Module *m_module;
+  std::size_t m_line{0};
+  ParseError m_error;
+
+  Function *m_fn{nullptr};
+  BasicBlock *m_cur{nullptr};
+
+  NameTable m_valueNames;
+  std::vector<std::uint32_t> m_numberedValues;
+  std::vector<ValueSlot> m_values;
+  NameTable m_blockNames;
+  std::vector<BlockSlot> m_blocks;
+  // operand tokens of the current line
+  std::vector<std::string_view> m_ops;
+  // comparisons of two forward references, checked after the last line
+  struct Deferred {
+    Instruction *instr;
+    std::size_t line;
+  };
+  std::vector<Deferred> m_deferred;
+};
+
+std::unique_ptr<Function> parseIR(std::string_view text,
+                                  ParseError *error = nullptr,
+                                  const Module *module = nullptr);
+// The file is memory-mapped and parsed in place.
+std::unique_ptr<Function> parseIRFile(const std::string &path,
+                                      ParseError *error = nullptr,
+                                      const Module *module = nullptr);
+
+} // namespace jade
@@ -0,0 +1,142 @@
+#include "printer.hh"
+#include "IR.hh"
+#include "function.hh"
+#include "opcodes.hh"
+#include <cerrno>
+#include <unistd.h>
+
+namespace jade {
+
+void PrintBuffer::flush() {
+  if (m_buf != &m_own || m_own.empty()) {
+    return;
+  }
+
+  if (m_stream) {
+    m_stream->write(m_own.data(), m_own.size());
+  } else if (m_fd >= 0) {
+    const char *data = m_own.data();
+    std::size_t left = m_own.size();
+    while (left) {
+      auto written = ::write(m_fd, data, left);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        break;
+      }
+      data += written;
+      left -= written;
+    }
+  }
+  m_own.clear();
+}
+
+void IRPrinter::print(const Function &fn) {
+  for (auto &&bb : fn) {
+    print(bb);
+    m_out << '\n';
+  }
+}
+
+void IRPrinter::print(const BasicBlock &bb) {
+  m_out << bb.getNameView() << ":\n";
+  for (auto &&instr : bb) {
+    m_out << "  ";
+    print(instr);
+  }
+}
+
+void IRPrinter::printRef(const Instruction &instr) {
+  auto name = instr.getNameView();
+  if (name.empty()) {
+    m_out << '%' << instr.getId();
+  } else {
+    m_out << name;
+  }
+}
+
+void IRPrinter::print(const Instruction &instr) {
+  auto printOperand = [this](const Instruction *val) {
+    m_out << ' ';
+    if (val) {
+      printRef(*val);
+    } else {
+      m_out << "null";
+    }
+  };
+
+  printRef(instr);
+  m_out << ": " << OpcodeToStr(instr.getOpcode()) << ' '
+        << Type(instr.getType()).getName();
+
+  switch (instr.getOpcode()) {
+  case Opcode::IF: {
+    auto &ifInstr = static_cast<const IfInstr &>(instr);
+    printOperand(ifInstr.input(0));
+    m_out << " T:" << ifInstr.getTrueBB()->getNameView();
+    m_out << " F:" << ifInstr.getFalseBB()->getNameView();
+    break;
+  }
+  case Opcode::GOTO:
+    m_out << ' '
+          << static_cast<const GotoInstr &>(instr).getBB()->getNameView();
+    break;
+  case Opcode::PHI: {
+    auto &phi = static_cast<const PhiInstr &>(instr);
+    for (std::size_t idx = 0; idx < phi.numOptions(); ++idx) {
+      m_out << (idx ? ", " : " ") << phi.getIncomingBlock(idx)->getNameView();
+      printOperand(phi.input(idx));
+    }
+    break;
+  }
+  case Opcode::CONST: {
+    m_out << ' ';
+    if (instr.getType() == Type::I1) {
+      m_out << static_cast<const ConstI1 &>(instr).getValue();
+    } else {
+      m_out << loadIntegerConst(&instr).value();
+    }
+    break;
+  }
+  case Opcode::CALL: {
+    auto *callee = static_cast<const CallInstr &>(instr).getCallee();
+    if (callee) {
+      m_out << " @" << callee->getName();
+    } else {
+      m_out << " null";
+    }
+    for (auto *input : instr) {
+      printOperand(input);
+    }
+    break;
+  }
+  default:
+    for (auto *input : instr) {
+      printOperand(input);
+    }
+    break;
+  }
+
+  m_out << '\n';
+}
+
+std::string toString(const Function &fn) {
+  std::string out;
+  {
+    PrintBuffer buf{out};
+    IRPrinter{buf}.print(fn);
+  }
+  return out;
+}
+
+std::string toString(const Instruction &instr) {
+  std::string out;
+  {
+    PrintBuffer buf{out};
+    IRPrinter{buf}.print(instr);
+  }
+  return out;
+}
+
+} // namespace jade
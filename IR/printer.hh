@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "IR.hh"
+
+namespace jade {
+
+class Function;
+
+// Growable output buffer. Text is formatted in place and handed to the sink
+// in chunks of kChunkSize bytes: nothing is flushed per line. A string sink
+// is written directly, without an intermediate copy.
+//
+// The buffer grows on demand. Whole-function dumps pass kBulkReserve to skip
+// the regrowth, short dumps of a single value should not.
+class PrintBuffer final {
+public:
+  static constexpr std::size_t kChunkSize = 1 << 16;
+  static constexpr std::size_t kBulkReserve = 2 * kChunkSize;
+
+  explicit PrintBuffer(int fd, std::size_t reserve = 0) : m_fd{fd} {
+    m_own.reserve(reserve);
+  }
+  explicit PrintBuffer(std::ostream &out, std::size_t reserve = 0)
+      : m_stream{&out} {
+    m_own.reserve(reserve);
+  }
+  explicit PrintBuffer(std::string &out) : m_buf{&out} {}
+
+  PrintBuffer(const PrintBuffer &) = delete;
+  PrintBuffer &operator=(const PrintBuffer &) = delete;
+
+  ~PrintBuffer() { flush(); }
+
+  PrintBuffer &operator<<(std::string_view str) {
+    m_buf->append(str.data(), str.size());
+    return spill();
+  }
+  PrintBuffer &operator<<(char c) {
+    m_buf->push_back(c);
+    return spill();
+  }
+  template <typename T>
+  std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char>,
+                   PrintBuffer &>
+  operator<<(T val) {
+    if constexpr (std::is_signed_v<T>) {
+      if (val < 0) {
+        m_buf->push_back('-');
+        // negate in unsigned arithmetic: INT64_MIN has no positive pair
+        return writeUnsigned(0 - static_cast<std::uint64_t>(val));
+      }
+    }
+    return writeUnsigned(static_cast<std::uint64_t>(val));
+  }
+
+  // Hand everything buffered so far to the sink.
+  void flush();
+
+private:
+  PrintBuffer &writeUnsigned(std::uint64_t val) {
+    char digits[20];
+    auto *end = digits + sizeof(digits);
+    auto *cur = end;
+    do {
+      *--cur = static_cast<char>('0' + val % 10);
+      val /= 10;
+    } while (val);
+    m_buf->append(cur, end);
+    return spill();
+  }
+
+  PrintBuffer &spill() {
+    if (m_buf == &m_own && m_own.size() >= kChunkSize) {
+      flush();
+    }
+    return *this;
+  }
+
+  std::string m_own;
+  std::string *m_buf{&m_own};
+  std::ostream *m_stream{nullptr};
+  int m_fd{-1};
+};
+
+// Formats IR in its textual form:
+//
+//   bb0:
+//     v0: PARAM i32
+//     v1: CONST i32 1
+//     v2: ADD i32 v0 v1
+//     v3: LE i1 v2 v0
+//     %4: IF none v3 T:bb1 F:bb2
+//
+// Every instruction line is "<ref>: <OPCODE> <type>" followed by the
+// operands; unnamed values are referred to as %<id>. A CALL names its callee
+// as @<function> before the arguments, or null when it has none.
+class IRPrinter final {
+public:
+  explicit IRPrinter(PrintBuffer &out) : m_out{out} {}
+
+  void print(const Function &fn);
+  void print(const BasicBlock &bb);
+  void print(const Instruction &instr);
+  void printRef(const Instruction &instr);
+
+private:
+  PrintBuffer &m_out;
+};
+
+std::string toString(const Function &fn);
+std::string toString(const Instruction &instr);
+
+} // namespace jade
@@ -0,0 +1,792 @@
+#include "serialize.hh"
+#include "IR.hh"
+#include "function.hh"
+#include "mappedFile.hh"
+#include "opcodes.hh"
+#include "valueMap.hh"
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace jade {
+
+namespace {
+
+constexpr std::size_t kHeaderSize = sizeof(kBinaryMagic) + 4;
+
+void writeVarint(std::string &out, std::uint64_t val) {
+  while (val >= 0x80) {
+    out.push_back(static_cast<char>(val | 0x80));
+    val >>= 7;
+  }
+  out.push_back(static_cast<char>(val));
+}
+
+std::uint64_t zigzag(std::int64_t val) {
+  return (static_cast<std::uint64_t>(val) << 1) ^
+         static_cast<std::uint64_t>(val >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t val) {
+  return static_cast<std::int64_t>(val >> 1) ^
+         -static_cast<std::int64_t>(val & 1);
+}
+
+class Encoder final {
+public:
+  explicit Encoder(const CalleeIds *callees) : m_callees{callees} {}
+
+  void encodeRecord(const Function &fn, std::string &out);
+
+private:
+  std::uint32_t intern(std::string_view str) {
+    auto [it, inserted] = m_stringIds.try_emplace(str, m_strings.size());
+    if (inserted) {
+      m_strings.push_back(str);
+    }
+    return it->second;
+  }
+  void writeValue(std::size_t user, const Instruction *val) {
+    assert(val && "dropped operands cannot be encoded");
+    auto idx = static_cast<std::int64_t>(m_indices.at(val));
+    writeVarint(m_body, zigzag(static_cast<std::int64_t>(user) - idx));
+  }
+  void writeBlock(const BasicBlock *bb) {
+    writeVarint(m_body, m_blockIndices.at(bb));
+  }
+
+  std::uint32_t calleeId(const Function *callee) const {
+    if (!m_callees) {
+      return 0;
+    }
+    auto it = m_callees->find(callee);
+    return it == m_callees->end() ? 0 : it->second;
+  }
+
+  const CalleeIds *m_callees;
+  std::unordered_map<std::string_view, std::uint32_t> m_stringIds;
+  std::vector<std::string_view> m_strings{""};
+  ValueMap<std::uint32_t> m_indices;
+  BlockMap<std::uint32_t> m_blockIndices;
+  std::string m_body;
+};
+
+void Encoder::encodeRecord(const Function &fn, std::string &out) {
+  m_indices.assign(fn.numValues());
+  m_blockIndices.assign(fn.numBlocks());
+
+  std::size_t numBlocks = 0;
+  std::size_t numInstrs = 0;
+  for (auto &&bb : fn) {
+    m_blockIndices[&bb] = numBlocks++;
+    for (auto &&instr : bb) {
+      m_indices[&instr] = numInstrs++;
+    }
+  }
+
+  writeVarint(m_body, numBlocks);
+  for (auto &&bb : fn) {
+    writeVarint(m_body, intern(bb.getNameView()));
+    writeVarint(m_body, std::distance(bb.begin(), bb.end()));
+  }
+
+  writeVarint(m_body, numInstrs);
+  std::size_t cur = 0;
+  for (auto &&bb : fn) {
+    for (auto &&instr : bb) {
+      auto opc = instr.getOpcode();
+      m_body.push_back(static_cast<char>(opc));
+      m_body.push_back(static_cast<char>(instr.getType()));
+      writeVarint(m_body, intern(instr.getNameView()));
+
+      switch (opc) {
+      case Opcode::IF: {
+        auto &ifInstr = static_cast<const IfInstr &>(instr);
+        writeValue(cur, ifInstr.input(0));
+        writeBlock(ifInstr.getTrueBB());
+        writeBlock(ifInstr.getFalseBB());
+        break;
+      }
+      case Opcode::GOTO:
+        writeBlock(static_cast<const GotoInstr &>(instr).getBB());
+        break;
+      case Opcode::PHI: {
+        auto &phi = static_cast<const PhiInstr &>(instr);
+        writeVarint(m_body, phi.numOptions());
+        for (std::size_t idx = 0; idx < phi.numOptions(); ++idx) {
+          writeBlock(phi.getIncomingBlock(idx));
+          writeValue(cur, phi.input(idx));
+        }
+        break;
+      }
+      case Opcode::CONST:
+        if (instr.getType() == Type::I1) {
+          writeVarint(m_body, static_cast<const ConstI1 &>(instr).getValue());
+        } else {
+          writeVarint(m_body, zigzag(loadIntegerConst(&instr).value()));
+        }
+        break;
+      case Opcode::CALL: {
+        auto *callee = static_cast<const CallInstr &>(instr).getCallee();
+        writeVarint(m_body, calleeId(callee));
+        [[fallthrough]];
+      }
+      case Opcode::RET:
+        writeVarint(m_body, instr.numInputs());
+        [[fallthrough]];
+      default:
+        for (auto *input : instr) {
+          writeValue(cur, input);
+        }
+        break;
+      }
+      ++cur;
+    }
+  }
+
+  std::string strings;
+  writeVarint(strings, m_strings.size());
+  for (auto str : m_strings) {
+    writeVarint(strings, str.size());
+    strings.append(str.data(), str.size());
+  }
+
+  writeVarint(out, strings.size() + m_body.size());
+  out += strings;
+  out += m_body;
+}
+
+class Decoder final {
+public:
+  Decoder(std::string_view data, const std::vector<Function *> *callees)
+      : m_data{data}, m_end{data.size()}, m_callees{callees} {}
+
+  bool readHeader(std::uint16_t &flags);
+  bool readModuleIndex(std::vector<ModuleEntry> &entries);
+  bool decodeRecord(Function &fn);
+  bool scanCallees(std::vector<Function *> &out);
+  std::size_t getPos() const { return m_pos; }
+  const DecodeError &getError() const { return m_error; }
+
+  bool fail(std::string message) {
+    if (m_error.message.empty()) {
+      m_error.offset = m_pos;
+      m_error.message = std::move(message);
+    }
+    return false;
+  }
+  bool failed() const { return !m_error.message.empty(); }
+
+private:
+
+  std::uint64_t readVarint() {
+    std::uint64_t val = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      if (m_pos >= m_end) {
+        fail("unexpected end of data");
+        return 0;
+      }
+      auto byte = static_cast<std::uint8_t>(m_data[m_pos++]);
+      val |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return val;
+      }
+    }
+    fail("varint is too long");
+    return 0;
+  }
+  std::uint8_t readByte() {
+    if (m_pos >= m_end) {
+      fail("unexpected end of data");
+      return 0;
+    }
+    return static_cast<std::uint8_t>(m_data[m_pos++]);
+  }
+  std::string readString() {
+    auto idx = readVarint();
+    if (idx >= m_strings.size()) {
+      fail("bad string index");
+      return {};
+    }
+    return std::string{m_strings[idx]};
+  }
+  void skipVarints(std::uint64_t count) {
+    for (std::uint64_t idx = 0; idx < count && !failed(); ++idx) {
+      readVarint();
+    }
+  }
+  BasicBlock *readBlock() {
+    auto idx = readVarint();
+    if (idx >= m_blocks.size()) {
+      fail("bad block index");
+      return nullptr;
+    }
+    return m_blocks[idx];
+  }
+  Instruction *readValue(Type hint);
+
+  bool readInstr(BasicBlock *bb);
+
+  std::string_view m_data;
+  std::size_t m_pos{0};
+  std::size_t m_end{0};
+  DecodeError m_error;
+
+  const std::vector<Function *> *m_callees;
+  Function *m_fn{nullptr};
+  std::vector<std::string_view> m_strings;
+  std::vector<BasicBlock *> m_blocks;
+  // decoded values, forward references point to placeholders until defined
+  std::vector<Instruction *> m_values;
+  std::vector<bool> m_defined;
+  std::size_t m_cur{0};
+};
+
+Instruction *Decoder::readValue(Type hint) {
+  auto delta = unzigzag(readVarint());
+  auto idx = static_cast<std::int64_t>(m_cur) - delta;
+  if (failed() || idx < 0 || static_cast<std::size_t>(idx) >= m_values.size()) {
+    fail("bad value index");
+    return nullptr;
+  }
+
+  auto &val = m_values[idx];
+  if (!val) {
+    val = m_fn->getArena().create<ParamInstr>(hint);
+  }
+  return val;
+}
+
+bool Decoder::readHeader(std::uint16_t &flags) {
+  if (m_data.size() < kHeaderSize ||
+      std::memcmp(m_data.data(), kBinaryMagic, sizeof(kBinaryMagic))) {
+    return fail("not a jade binary");
+  }
+  m_pos = sizeof(kBinaryMagic);
+  std::uint16_t version = readByte();
+  version |= static_cast<std::uint16_t>(readByte()) << 8;
+  if (version != kBinaryVersion) {
+    return fail("unsupported version " + std::to_string(version));
+  }
+  flags = readByte();
+  flags |= static_cast<std::uint16_t>(readByte()) << 8;
+  return true;
+}
+
+bool Decoder::readModuleIndex(std::vector<ModuleEntry> &entries) {
+  std::uint16_t flags = 0;
+  if (!readHeader(flags)) {
+    return false;
+  }
+  if (!(flags & kModuleFlag)) {
+    return fail("function instead of a module");
+  }
+
+  auto count = readVarint();
+  if (failed() || count > m_end - m_pos) {
+    return fail("bad function count");
+  }
+
+  struct Range {
+    std::string_view name;
+    std::uint64_t offset;
+    std::uint64_t size;
+  };
+  std::vector<Range> ranges;
+  ranges.reserve(count);
+  for (std::uint64_t idx = 0; idx < count; ++idx) {
+    auto len = readVarint();
+    if (failed() || len > m_end - m_pos) {
+      return fail("truncated function name");
+    }
+    auto name = m_data.substr(m_pos, len);
+    m_pos += len;
+    auto offset = readVarint();
+    auto size = readVarint();
+    if (failed()) {
+      return false;
+    }
+    ranges.push_back({name, offset, size});
+  }
+
+  // records follow the index
+  auto records = m_data.substr(m_pos);
+  entries.clear();
+  entries.reserve(count);
+  for (auto &&range : ranges) {
+    if (range.offset > records.size() ||
+        range.size > records.size() - range.offset) {
+      return fail("record out of bounds");
+    }
+    entries.push_back({range.name, records.substr(range.offset, range.size)});
+  }
+  return true;
+}
+
+bool Decoder::decodeRecord(Function &fn) {
+  assert(fn.begin() == fn.end() && "decoding into a non-empty function");
+  m_fn = &fn;
+
+  auto size = readVarint();
+  if (failed() || size > m_end - m_pos) {
+    return fail("truncated record");
+  }
+  m_end = m_pos + size;
+
+  // string views point into the mapped data
+  auto numStrings = readVarint();
+  if (numStrings > m_end - m_pos) {
+    return fail("bad string count");
+  }
+  m_strings.reserve(numStrings);
+  for (std::size_t i = 0; i < numStrings && !failed(); ++i) {
+    auto len = readVarint();
+    if (len > m_end - m_pos) {
+      return fail("truncated string");
+    }
+    m_strings.push_back(m_data.substr(m_pos, len));
+    m_pos += len;
+  }
+
+  auto numBlocks = readVarint();
+  if (numBlocks > m_end - m_pos) {
+    return fail("bad block count");
+  }
+  std::vector<std::uint64_t> blockSizes(numBlocks);
+  m_blocks.reserve(numBlocks);
+  for (std::size_t i = 0; i < numBlocks && !failed(); ++i) {
+    auto name = readString();
+    blockSizes[i] = readVarint();
+    auto *bb = fn.create<BasicBlock>();
+    bb->setName(std::move(name));
+    m_blocks.push_back(bb);
+  }
+
+  auto numInstrs = readVarint();
+  if (failed() || numInstrs > m_end - m_pos) {
+    return fail("bad instruction count");
+  }
+  m_values.assign(numInstrs, nullptr);
+  m_defined.assign(numInstrs, false);
+
+  for (std::size_t i = 0; i < numBlocks && !failed(); ++i) {
+    for (std::uint64_t j = 0; j < blockSizes[i]; ++j) {
+      if (m_cur >= numInstrs) {
+        return fail("more instructions than declared");
+      }
+      if (!readInstr(m_blocks[i])) {
+        return false;
+      }
+      ++m_cur;
+    }
+  }
+
+  if (failed()) {
+    return false;
+  }
+  if (m_cur != numInstrs || m_pos != m_end) {
+    return fail("record size mismatch");
+  }
+  for (std::size_t idx = 0; idx < numInstrs; ++idx) {
+    if (!m_defined[idx]) {
+      return fail("undefined value");
+    }
+  }
+  return true;
+}
+
+// Walks the record like decodeRecord, but only reads what is needed to step
+// over each instruction, and builds no IR.
+bool Decoder::scanCallees(std::vector<Function *> &out) {
+  auto size = readVarint();
+  if (failed() || size > m_end - m_pos) {
+    return fail("truncated record");
+  }
+  m_end = m_pos + size;
+
+  auto numStrings = readVarint();
+  for (std::uint64_t i = 0; i < numStrings && !failed(); ++i) {
+    auto len = readVarint();
+    if (len > m_end - m_pos) {
+      return fail("truncated string");
+    }
+    m_pos += len;
+  }
+  // name and size of every block
+  skipVarints(2 * readVarint());
+
+  auto numInstrs = readVarint();
+  for (std::uint64_t i = 0; i < numInstrs && !failed(); ++i) {
+    auto opcByte = readByte();
+    readByte();
+    readVarint();
+    if (opcByte >= kNumOpcodes) {
+      return fail("bad opcode or type");
+    }
+
+    auto opc = static_cast<Opcode>(opcByte);
+    switch (opc) {
+    case Opcode::PARAM:
+      break;
+    case Opcode::CONST:
+    case Opcode::GOTO:
+      skipVarints(1);
+      break;
+    case Opcode::IF:
+      skipVarints(3);
+      break;
+    case Opcode::RET:
+      skipVarints(readVarint());
+      break;
+    case Opcode::PHI:
+      skipVarints(2 * readVarint());
+      break;
+    case Opcode::CALL: {
+      auto calleeId = readVarint();
+      Function *callee = nullptr;
+      if (calleeId) {
+        if (!m_callees || calleeId > m_callees->size()) {
+          return fail("bad callee");
+        }
+        callee = (*m_callees)[calleeId - 1];
+      }
+      out.push_back(callee);
+      skipVarints(readVarint());
+      break;
+    }
+    default:
+      skipVarints(getOpcodeInfo(opc).arity);
+      break;
+    }
+  }
+
+  if (failed()) {
+    return false;
+  }
+  if (m_pos != m_end) {
+    return fail("record size mismatch");
+  }
+  return true;
+}
+
+bool Decoder::readInstr(BasicBlock *bb) {
+  auto opcByte = readByte();
+  auto typeByte = readByte();
+  if (opcByte >= kNumOpcodes || typeByte > Type::None) {
+    return fail("bad opcode or type");
+  }
+  auto opc = static_cast<Opcode>(opcByte);
+  auto type = Type{static_cast<Type::Tag>(typeByte)};
+  auto name = readString();
+  const auto &info = getOpcodeInfo(opc);
+
+  Instruction *instr = nullptr;
+  switch (opc) {
+  case Opcode::PARAM:
+    instr = bb->create<ParamInstr>(type);
+    break;
+  case Opcode::CONST: {
+    auto raw = readVarint();
+    switch (type.getType()) {
+    case Type::I64:
+      instr = bb->create<ConstI64>(unzigzag(raw));
+      break;
+    case Type::I32:
+      instr = bb->create<ConstI32>(static_cast<std::int32_t>(unzigzag(raw)));
+      break;
+    case Type::I16:
+      instr = bb->create<ConstI16>(static_cast<std::int16_t>(unzigzag(raw)));
+      break;
+    case Type::I8:
+      instr = bb->create<ConstI8>(static_cast<std::int8_t>(unzigzag(raw)));
+      break;
+    case Type::I1:
+      instr = bb->create<ConstI1>(raw != 0);
+      break;
+    default:
+      return fail("CONST of type none");
+    }
+    break;
+  }
+  case Opcode::IF: {
+    auto *cond = readValue(Type::I1);
+    auto *trueBB = readBlock();
+    auto *falseBB = readBlock();
+    if (failed()) {
+      return false;
+    }
+    instr = bb->create<IfInstr>(cond, falseBB, trueBB);
+    break;
+  }
+  case Opcode::GOTO: {
+    auto *target = readBlock();
+    if (failed()) {
+      return false;
+    }
+    instr = bb->create<GotoInstr>(target);
+    break;
+  }
+  case Opcode::RET: {
+    auto count = readVarint();
+    if (count > 1) {
+      return fail("RET with several values");
+    }
+    auto *val = count ? readValue(type) : nullptr;
+    if (failed()) {
+      return false;
+    }
+    instr = val ? bb->create<RetInstr>(val) : bb->create<RetInstr>();
+    break;
+  }
+  case Opcode::PHI: {
+    auto count = readVarint();
+    if (count > m_end - m_pos) {
+      return fail("bad PHI operand count");
+    }
+    auto *phi = bb->create<PhiInstr>(type);
+    for (std::uint64_t idx = 0; idx < count && !failed(); ++idx) {
+      auto *from = readBlock();
+      auto *val = readValue(type);
+      if (failed()) {
+        return false;
+      }
+      if (val->getType() != type.getType()) {
+        return fail("PHI operand type mismatch");
+      }
+      phi->addOption(val, from);
+    }
+    instr = phi;
+    break;
+  }
+  case Opcode::CAST: {
+    auto *val = readValue(Type{});
+    if (failed()) {
+      return false;
+    }
+    instr = bb->create<CastInstr>(val, type);
+    break;
+  }
+  case Opcode::CALL: {
+    auto calleeId = readVarint();
+    Function *callee = nullptr;
+    if (calleeId) {
+      if (!m_callees || calleeId > m_callees->size()) {
+        return fail("bad callee");
+      }
+      callee = (*m_callees)[calleeId - 1];
+    }
+    auto count = readVarint();
+    if (count > m_end - m_pos) {
+      return fail("bad CALL operand count");
+    }
+    auto *call = bb->create<CallInstr>(callee, type);
+    for (std::uint64_t idx = 0; idx < count && !failed(); ++idx) {
+      auto *arg = readValue(Type{});
+      if (failed()) {
+        return false;
+      }
+      call->addArg(arg);
+    }
+    instr = call;
+    break;
+  }
+  default: {
+    if (info.arity == 1) {
+      auto *val = readValue(type);
+      if (failed()) {
+        return false;
+      }
+      instr = bb->create<UnaryOp>(val, opc);
+      break;
+    }
+
+    auto *lhs = readValue(info.result == ResultRule::Bool ? Type{} : type);
+    if (failed()) {
+      return false;
+    }
+    auto *rhs = readValue(Type{lhs->getType()});
+    if (failed()) {
+      return false;
+    }
+    if (lhs->getType() != rhs->getType()) {
+      return fail("operand type mismatch");
+    }
+    if (info.result == ResultRule::Bool) {
+      instr = bb->create<CmpInstr>(lhs, rhs, opc);
+    } else {
+      instr = bb->create<BinaryOp>(lhs, rhs, opc);
+    }
+    break;
+  }
+  }
+
+  if (failed()) {
+    return false;
+  }
+  instr->setName(std::move(name));
+
+  auto &slot = m_values[m_cur];
+  if (slot) {
+    slot->replaceUsers(instr);
+  }
+  slot = instr;
+  m_defined[m_cur] = true;
+  return true;
+}
+
+} // namespace
+
+void writeHeader(std::string &out, std::uint16_t flags) {
+  out.append(kBinaryMagic, sizeof(kBinaryMagic));
+  out.push_back(static_cast<char>(kBinaryVersion & 0xff));
+  out.push_back(static_cast<char>(kBinaryVersion >> 8));
+  out.push_back(static_cast<char>(flags & 0xff));
+  out.push_back(static_cast<char>(flags >> 8));
+}
+
+bool readHeader(std::string_view data, std::uint16_t &flags,
+                DecodeError *error) {
+  Decoder decoder{data, nullptr};
+  if (!decoder.readHeader(flags)) {
+    if (error) {
+      *error = decoder.getError();
+    }
+    return false;
+  }
+  return true;
+}
+
+void writeRecord(const Function &fn, std::string &out,
+                 const CalleeIds *callees) {
+  Encoder{callees}.encodeRecord(fn, out);
+}
+
+bool readRecord(std::string_view record, Function &fn,
+                const std::vector<Function *> *callees, DecodeError *error) {
+  Decoder decoder{record, callees};
+  if (!decoder.decodeRecord(fn)) {
+    if (error) {
+      *error = decoder.getError();
+    }
+    return false;
+  }
+  return true;
+}
+
+bool readRecordCallees(std::string_view record,
+                       const std::vector<Function *> *callees,
+                       std::vector<Function *> &out, DecodeError *error) {
+  Decoder decoder{record, callees};
+  if (!decoder.scanCallees(out)) {
+    if (error) {
+      *error = decoder.getError();
+    }
+    return false;
+  }
+  return true;
+}
+
+void writeModule(const std::vector<const Function *> &fns, std::string &out) {
+  CalleeIds ids;
+  for (std::size_t idx = 0; idx < fns.size(); ++idx) {
+    ids[fns[idx]] = idx + 1;
+  }
+
+  std::string records;
+  writeHeader(out, kModuleFlag);
+  writeVarint(out, fns.size());
+  for (auto *fn : fns) {
+    auto offset = records.size();
+    writeRecord(*fn, records, &ids);
+
+    writeVarint(out, fn->getName().size());
+    out += fn->getName();
+    writeVarint(out, offset);
+    writeVarint(out, records.size() - offset);
+  }
+  out += records;
+}
+
+bool readModuleIndex(std::string_view data, std::vector<ModuleEntry> &entries,
+                     DecodeError *error) {
+  Decoder decoder{data, nullptr};
+  auto ok = decoder.readModuleIndex(entries);
+  if (!ok && error) {
+    *error = decoder.getError();
+  }
+  return ok;
+}
+
+void writeBinary(const Function &fn, std::string &out) {
+  writeHeader(out, 0);
+  writeRecord(fn, out);
+}
+
+bool writeFile(const std::string &path, std::string_view data) {
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  std::size_t left = data.size();
+  const char *cur = data.data();
+  while (left) {
+    auto written = ::write(fd, cur, left);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ::close(fd);
+      return false;
+    }
+    cur += written;
+    left -= written;
+  }
+  return ::close(fd) == 0;
+}
+
+bool writeBinaryFile(const Function &fn, const std::string &path) {
+  std::string out;
+  writeBinary(fn, out);
+  return writeFile(path, out);
+}
+
+std::unique_ptr<Function> readBinary(std::string_view data,
+                                     DecodeError *error) {
+  Decoder decoder{data, nullptr};
+  auto fn = std::make_unique<Function>();
+
+  std::uint16_t flags = 0;
+  auto ok = decoder.readHeader(flags);
+  if (ok && (flags & kModuleFlag)) {
+    ok = decoder.fail("module instead of a function");
+  }
+  if (ok) {
+    ok = decoder.decodeRecord(*fn);
+  }
+
+  if (!ok) {
+    if (error) {
+      *error = decoder.getError();
+    }
+    return nullptr;
+  }
+  return fn;
+}
+
+std::unique_ptr<Function> readBinaryFile(const std::string &path,
+                                         DecodeError *error) {
+  auto file = MappedFile::open(path);
+  if (!file) {
+    if (error) {
+      *error = DecodeError{0, "cannot open " + path};
+    }
+    return nullptr;
+  }
+  return readBinary(file->view(), error);
+}
+
+} // namespace jade
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "IR.hh"
+#include "function.hh"
+
+namespace jade {
+
+// Binary encoding of a Function.
+//
+//   file     := header, record
+//   header   := magic "JADE", version (u16 LE), flags (u16 LE)
+//   record   := size, strings, blocks, instrs   (size is the payload length)
+//   strings  := count, { length, bytes }         (string 0 is "")
+//   blocks   := count, { name, numInstrs }
+//   instrs   := count, { opcode (u8), type (u8), name, operands }
+//
+// Every number is an unsigned LEB128 varint, immediates are zigzag encoded.
+// A callee is a 1-based index into the function table of the container the
+// record belongs to (see LazyModule), 0 when there is none.
+// Instructions are numbered in layout order; a value operand is stored as
+// the zigzag distance from the using instruction, so forward references
+// (phis) are negative and most operands fit in one byte. The operands of an
+// instruction depend on its opcode:
+//
+//   IF: cond, true block, false block      GOTO: block
+//   RET: count, values                     CALL: callee, count, values
+//   PHI: count, { block, value }           CONST: immediate
+//   anything else: as many values as the opcode arity
+inline constexpr char kBinaryMagic[4] = {'J', 'A', 'D', 'E'};
+inline constexpr std::uint16_t kBinaryVersion = 1;
+// set in the header of a module (see LazyModule)
+inline constexpr std::uint16_t kModuleFlag = 1;
+
+struct DecodeError {
+  std::size_t offset{0};
+  std::string message;
+};
+
+using CalleeIds = std::unordered_map<const Function *, std::uint32_t>;
+
+void writeHeader(std::string &out, std::uint16_t flags);
+bool readHeader(std::string_view data, std::uint16_t &flags,
+                DecodeError *error = nullptr);
+
+// Records alone are the building blocks of containers of many functions.
+void writeRecord(const Function &fn, std::string &out,
+                 const CalleeIds *callees = nullptr);
+// Decodes a record into the empty function fn.
+bool readRecord(std::string_view record, Function &fn,
+                const std::vector<Function *> *callees = nullptr,
+                DecodeError *error = nullptr);
+// Appends the callee of every CALL of a record to out, in layout order,
+// without decoding the function.
+bool readRecordCallees(std::string_view record,
+                       const std::vector<Function *> *callees,
+                       std::vector<Function *> &out,
+                       DecodeError *error = nullptr);
+
+bool writeFile(const std::string &path, std::string_view data);
+
+// Module file:
+//
+//   module := header (kModuleFlag), count, { name, offset, size }, records
+//
+// The index lists every function with the position of its record, offsets
+// are relative to the first record. Calls between functions of the module
+// keep their callee.
+struct ModuleEntry {
+  std::string_view name;
+  std::string_view record;
+};
+
+void writeModule(const std::vector<const Function *> &fns, std::string &out);
+// Reads the index only, the records are left untouched.
+bool readModuleIndex(std::string_view data, std::vector<ModuleEntry> &entries,
+                     DecodeError *error = nullptr);
+
+// Appends the encoding of fn (header included) to out.
+void writeBinary(const Function &fn, std::string &out);
+bool writeBinaryFile(const Function &fn, const std::string &path);
+
+// Decodes a function straight from data, nothing is copied up front. Returns
+// nullptr on a malformed or incompatible input.
+std::unique_ptr<Function> readBinary(std::string_view data,
+                                     DecodeError *error = nullptr);
+// The file is memory-mapped and decoded in place.
+std::unique_ptr<Function> readBinaryFile(const std::string &path,
+                                         DecodeError *error = nullptr);
+
+} // namespace jade
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include "IR.hh"
+
+namespace jade {
+
+// Side table indexed by the dense id of a key (see Function::renumber). Keys
+// are never hashed: lookup is a plain vector access.
+template <typename KeyTy, typename T> class IdMap {
+public:
+  IdMap() = default;
+  explicit IdMap(std::size_t size, const T &init = T{}) : m_data(size, init) {}
+
+  T &operator[](const KeyTy *key) {
+    auto id = key->getId();
+    if (id >= m_data.size()) {
+      m_data.resize(id + 1);
+    }
+    return m_data[id];
+  }
+
+  const T &at(const KeyTy *key) const {
+    assert(key->getId() < m_data.size());
+    return m_data[key->getId()];
+  }
+
+  T &at(const KeyTy *key) {
+    assert(key->getId() < m_data.size());
+    return m_data[key->getId()];
+  }
+
+  bool inBounds(const KeyTy *key) const { return key->getId() < m_data.size(); }
+
+  void resize(std::size_t size, const T &init = T{}) {
+    m_data.resize(size, init);
+  }
+  void assign(std::size_t size, const T &init = T{}) {
+    m_data.assign(size, init);
+  }
+  void clear() { m_data.clear(); }
+  std::size_t size() const { return m_data.size(); }
+
+  auto begin() { return m_data.begin(); }
+  auto end() { return m_data.end(); }
+  auto begin() const { return m_data.begin(); }
+  auto end() const { return m_data.end(); }
+
+private:
+  std::vector<T> m_data;
+};
+
+template <typename T> using ValueMap = IdMap<Instruction, T>;
+template <typename T> using BlockMap = IdMap<BasicBlock, T>;
+
+} // namespace jade
@@ -0,0 +1,118 @@
+#include "callGraph.hh"
+#include <algorithm>
+
+namespace jade {
+
+CallGraph::CallGraph(const Module &module) {
+  std::vector<Function *> fns;
+  fns.reserve(module.size());
+  for (auto &&fn : module) {
+    fns.push_back(fn.get());
+  }
+  build(std::move(fns));
+}
+
+CallGraph::CallGraph(LazyModule &module) {
+  std::vector<Function *> fns;
+  fns.reserve(module.size());
+  for (std::size_t idx = 0; idx < module.size(); ++idx) {
+    fns.push_back(module.getFunction(idx));
+  }
+  build(std::move(fns));
+}
+
+void CallGraph::build(std::vector<Function *> fns) {
+  m_fns = std::move(fns);
+  m_nodes.reserve(size());
+  for (std::size_t node = 0; node < size(); ++node) {
+    m_nodes.emplace(m_fns[node], node);
+  }
+
+  m_callees.resize(size());
+  m_callers.resize(size());
+  std::vector<Function *> targets;
+  for (std::size_t node = 0; node < size(); ++node) {
+    targets.clear();
+    if (m_fns[node]->collectCallees(targets)) {
+      addCalls(node, targets);
+    }
+  }
+  buildSCCs();
+}
+
+void CallGraph::addCalls(std::size_t node,
+                         const std::vector<Function *> &targets) {
+  auto &callees = m_callees[node];
+  for (auto *target : targets) {
+    auto callee = getNode(target);
+    if (callee == kNone ||
+        std::find(callees.begin(), callees.end(), callee) != callees.end()) {
+      continue;
+    }
+    callees.push_back(callee);
+    m_callers[callee].push_back(node);
+  }
+}
+
+// Tarjan's algorithm with an explicit stack: a component is complete when
+// the walk leaves its root, which happens only after the components it
+// reaches are done, so they come out bottom-up.
+void CallGraph::buildSCCs() {
+  std::vector<std::size_t> index(size(), kNone);
+  std::vector<std::size_t> low(size(), 0);
+  std::vector<bool> onStack(size(), false);
+  std::vector<std::size_t> stack;
+  // (node, next callee to visit)
+  std::vector<std::pair<std::size_t, std::size_t>> walk;
+  std::size_t counter = 0;
+
+  m_sccOf.assign(size(), kNone);
+  for (std::size_t root = 0; root < size(); ++root) {
+    if (index[root] != kNone) {
+      continue;
+    }
+
+    walk.emplace_back(root, 0);
+    while (!walk.empty()) {
+      auto &[node, next] = walk.back();
+      if (next == 0 && index[node] == kNone) {
+        index[node] = low[node] = counter++;
+        stack.push_back(node);
+        onStack[node] = true;
+      }
+
+      if (next < m_callees[node].size()) {
+        auto callee = m_callees[node][next++];
+        if (index[callee] == kNone) {
+          walk.emplace_back(callee, 0);
+        } else if (onStack[callee]) {
+          low[node] = std::min(low[node], index[callee]);
+        }
+        continue;
+      }
+
+      auto done = node;
+      walk.pop_back();
+      if (!walk.empty()) {
+        auto parent = walk.back().first;
+        low[parent] = std::min(low[parent], low[done]);
+      }
+      if (low[done] != index[done]) {
+        continue;
+      }
+
+      auto &scc = m_sccs.emplace_back();
+      std::size_t member = kNone;
+      do {
+        member = stack.back();
+        stack.pop_back();
+        onStack[member] = false;
+        m_sccOf[member] = m_sccs.size() - 1;
+        scc.push_back(member);
+      } while (member != done);
+      std::reverse(scc.begin(), scc.end());
+    }
+  }
+}
+
+} // namespace jade
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "denseMap.hh"
+#include "function.hh"
+#include "lazyModule.hh"
+#include "module.hh"
+
+namespace jade {
+
+// Who calls whom in a module, collected from CallInstr sites. Nodes are the
+// indices of the functions in the module; calls to functions of another
+// module are not edges. Functions of a LazyModule are not materialized: their
+// calls are read from the encoded records.
+//
+// Strongly connected components come bottom-up: every function is in a
+// component after the components of its callees, the mutually recursive
+// ones share a component.
+class CallGraph {
+public:
+  static constexpr std::size_t kNone = std::numeric_limits<std::size_t>::max();
+
+  explicit CallGraph(const Module &module);
+  explicit CallGraph(LazyModule &module);
+
+  std::size_t size() const { return m_fns.size(); }
+  Function *getFunction(std::size_t node) const { return m_fns[node]; }
+  std::size_t getNode(const Function *fn) const {
+    auto it = m_nodes.find(fn);
+    return it == m_nodes.end() ? kNone : it->second;
+  }
+
+  // distinct, in order of the first call
+  const std::vector<std::size_t> &callees(std::size_t node) const {
+    return m_callees[node];
+  }
+  const std::vector<std::size_t> &callers(std::size_t node) const {
+    return m_callers[node];
+  }
+
+  const std::vector<std::vector<std::size_t>> &sccs() const { return m_sccs; }
+  std::size_t sccOf(std::size_t node) const { return m_sccOf[node]; }
+
+private:
+  void build(std::vector<Function *> fns);
+  void addCalls(std::size_t node, const std::vector<Function *> &targets);
+  void buildSCCs();
+
+  std::vector<Function *> m_fns;
+  DenseMap<const Function *, std::size_t> m_nodes;
+  std::vector<std::vector<std::size_t>> m_callees;
+  std::vector<std::vector<std::size_t>> m_callers;
+
+  std::vector<std::vector<std::size_t>> m_sccs;
+  std::vector<std::size_t> m_sccOf;
+};
+
+} // namespace jade
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "bitVector.hh"
+#include "graph.hh"
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace jade {
+
+enum class DataflowDirection {
+  Forward,
+  Backward,
+};
+
+// Iterative dataflow over any graph with GraphTraits. A problem gives the
+// lattice and the transfer functions:
+//
+//   using ValueTy = ...;
+//   static constexpr DataflowDirection kDirection = ...;
+//   // value of every node before the first visit: the optimistic start
+//   ValueTy top() const;
+//   // what flows into node before any edge: a boundary value at the entry
+//   // (exits going backward), else the identity of meet
+//   void init(NodeTy node, ValueTy &value) const;
+//   // value = value meet other
+//   void meet(ValueTy &value, const ValueTy &other) const;
+//   // to = the effect of node applied to from, tells whether to changed
+//   bool transfer(NodeTy node, const ValueTy &from, ValueTy &to) const;
+//
+// In and out are the values at the start and at the end of a node whatever
+// the direction: forward, in is the meet over the preds and out the result
+// of the transfer, backward the other way round.
+//
+// Nodes are visited in RPO (postorder going backward) from a worklist kept
+// as a bit per position: the next node is the first pending one after the
+// last visited, so the solver runs sweeps in that order over the nodes
+// whose inputs changed. Without loops one sweep is enough. Only the nodes
+// reachable from the entry are visited, the others keep top.
+template <typename GraphTy, typename ProblemTy> class DataflowSolver {
+public:
+  using Traits = GraphTraits<GraphTy>;
+  using NodeTy = typename Traits::NodeTy;
+  using ValueTy = typename ProblemTy::ValueTy;
+
+  explicit DataflowSolver(const ProblemTy &problem) : m_problem{problem} {}
+
+  void solve(GraphTy &G);
+
+  const ValueTy &getIn(NodeTy node) const { return m_in[Traits::id(node)]; }
+  const ValueTy &getOut(NodeTy node) const {
+    return m_out[Traits::id(node)];
+  }
+  // the results can be moved out once solved
+  ValueTy &getIn(NodeTy node) { return m_in[Traits::id(node)]; }
+  ValueTy &getOut(NodeTy node) { return m_out[Traits::id(node)]; }
+
+  std::size_t numVisits() const { return m_numVisits; }
+  std::size_t numSweeps() const { return m_numSweeps; }
+
+private:
+  static constexpr bool kForward =
+      ProblemTy::kDirection == DataflowDirection::Forward;
+  static constexpr std::size_t kUnreached = ~std::size_t{0};
+
+  // Returns whether the value the node passes on changed.
+  bool visit(NodeTy node);
+  // queues the nodes the value of node flows to
+  void schedule(NodeTy node);
+  void push(NodeTy node) {
+    auto pos = m_position[Traits::id(node)];
+    if (pos != kUnreached) {
+      m_pending.set(pos);
+    }
+  }
+
+  const ProblemTy &m_problem;
+  std::vector<ValueTy> m_in;
+  std::vector<ValueTy> m_out;
+  // visiting order and position of each node id in it
+  std::vector<NodeTy> m_order;
+  std::vector<std::size_t> m_position;
+  BitVector m_pending;
+  std::size_t m_numVisits{0};
+  std::size_t m_numSweeps{0};
+};
+
+template <typename GraphTy, typename ProblemTy>
+void DataflowSolver<GraphTy, ProblemTy>::solve(GraphTy &G) {
+  auto numIds = Traits::nodesCount(G);
+  m_in.assign(numIds, m_problem.top());
+  m_out.assign(numIds, m_problem.top());
+  m_order = PostOrderIterator<GraphTy>::collect(G);
+  if constexpr (kForward) {
+    std::reverse(m_order.begin(), m_order.end());
+  }
+  m_position.assign(numIds, kUnreached);
+  for (std::size_t pos = 0; pos < m_order.size(); ++pos) {
+    m_position[Traits::id(m_order[pos])] = pos;
+  }
+
+  m_numVisits = 0;
+  m_numSweeps = 0;
+  m_pending = BitVector(m_order.size(), true);
+  auto pos = m_order.size();
+  while (true) {
+    pos = m_pending.findNext(pos + 1);
+    if (pos == m_order.size()) {
+      pos = m_pending.findFirst();
+      if (pos == m_order.size()) {
+        break;
+      }
+      ++m_numSweeps;
+    }
+    m_pending.reset(pos);
+    ++m_numVisits;
+    if (visit(m_order[pos])) {
+      schedule(m_order[pos]);
+    }
+  }
+}
+
+template <typename GraphTy, typename ProblemTy>
+bool DataflowSolver<GraphTy, ProblemTy>::visit(NodeTy node) {
+  auto id = Traits::id(node);
+  if constexpr (kForward) {
+    auto &in = m_in[id];
+    m_problem.init(node, in);
+    for (auto it = Traits::inEdgeBegin(node); it != Traits::inEdgeEnd(node);
+         ++it) {
+      m_problem.meet(in, m_out[Traits::id(*it)]);
+    }
+    return m_problem.transfer(node, in, m_out[id]);
+  } else {
+    auto &out = m_out[id];
+    m_problem.init(node, out);
+    for (auto it = Traits::outEdgeBegin(node); it != Traits::outEdgeEnd(node);
+         ++it) {
+      m_problem.meet(out, m_in[Traits::id(*it)]);
+    }
+    return m_problem.transfer(node, out, m_in[id]);
+  }
+}
+
+template <typename GraphTy, typename ProblemTy>
+void DataflowSolver<GraphTy, ProblemTy>::schedule(NodeTy node) {
+  if constexpr (kForward) {
+    for (auto it = Traits::outEdgeBegin(node); it != Traits::outEdgeEnd(node);
+         ++it) {
+      push(*it);
+    }
+  } else {
+    for (auto it = Traits::inEdgeBegin(node); it != Traits::inEdgeEnd(node);
+         ++it) {
+      push(*it);
+    }
+  }
+}
+
+// Gen/kill problem on bitvectors: to = gen + (from - kill), unions meet for
+// "may" problems, intersections for "must" ones. A node with a seed starts
+// its meet from it instead of the identity: what flows in at the entry or
+// the exits, or along all edges at once.
+template <typename GraphTy, DataflowDirection Direction, bool IsUnion = true>
+struct BitVectorProblem {
+  using Traits = GraphTraits<GraphTy>;
+  using NodeTy = typename Traits::NodeTy;
+  using ValueTy = BitVector;
+  static constexpr DataflowDirection kDirection = Direction;
+
+  BitVectorProblem(std::size_t numNodes = 0, std::size_t numBits = 0)
+      : gen(numNodes, BitVector(numBits)), kill(numNodes, BitVector(numBits)),
+        m_numBits{numBits} {}
+
+  ValueTy top() const { return BitVector(m_numBits, !IsUnion); }
+  void init(NodeTy node, ValueTy &value) const {
+    auto id = Traits::id(node);
+    if (id < seed.size() && seed[id].size()) {
+      value = seed[id];
+    } else if (IsUnion) {
+      value.reset();
+    } else {
+      value.set();
+    }
+  }
+  void meet(ValueTy &value, const ValueTy &other) const {
+    if (IsUnion) {
+      value.unionWith(other);
+    } else {
+      value.intersectWith(other);
+    }
+  }
+  bool transfer(NodeTy node, const ValueTy &from, ValueTy &to) const {
+    auto id = Traits::id(node);
+    m_scratch = from;
+    m_scratch.subtract(kill[id]);
+    m_scratch.unionWith(gen[id]);
+    if (m_scratch == to) {
+      return false;
+    }
+    std::swap(m_scratch, to);
+    return true;
+  }
+
+  // by node id, seed may be shorter and holds empty vectors for no seed
+  std::vector<BitVector> gen;
+  std::vector<BitVector> kill;
+  std::vector<BitVector> seed;
+
+private:
+  std::size_t m_numBits;
+  mutable BitVector m_scratch;
+};
+
+} // namespace jade
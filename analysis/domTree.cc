@@ -1,7 +1,7 @@
 #include "domTree.hh"
 
 namespace jade {
-bool dominate(DomTree<BasicBlocksGraph> &domTree, Instruction *lhs,
+bool dominate(const DomTree<BasicBlocksGraph> &domTree, Instruction *lhs,
               Instruction *rhs) {
   if (lhs == rhs) {
     return true;
@@ -1,73 +1,470 @@
 #pragma once
 
 #include <algorithm>
+#include <cassert>
 #include <cstddef>
+#include <memory>
 #include <ostream>
-#include <set>
-#include <unordered_map>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "IR.hh"
 #include "function.hh"
 #include "graph.hh"
+#include "smallPtrSet.hh"
+#include "smallVector.hh"
 
 namespace jade {
 
+template <typename GraphTy> class DomTree;
 template <typename GraphTy> class DominatorTreeBuilder;
 
+// Node of a dominator tree. The children of all nodes sit in one array of
+// the tree, a node only points at its slice of it.
+template <typename GraphTy> class DomTreeNode {
+public:
+  using Traits = GraphTraits<GraphTy>;
+  using NodeTy = typename Traits::NodeTy;
+  using ChildIt = DomTreeNode *const *;
+
+  NodeTy getBlock() const { return m_block; }
+  // nullptr for the root
+  DomTreeNode *getIdom() const { return m_idom; }
+  Range<ChildIt> children() const { return {m_childBegin, m_childEnd}; }
+  std::size_t numChildren() const { return m_childEnd - m_childBegin; }
+  // depth in the tree, 0 for the root
+  std::size_t getLevel() const { return m_level; }
+
+  // Preorder number of the node and the last one in its subtree.
+  std::size_t getDFSIn() const { return m_dfsIn; }
+  std::size_t getDFSOut() const { return m_dfsOut; }
+  // nodes done before it in postorder: the ones before it in preorder
+  // except its ancestors, and its subtree
+  std::size_t getPostNum() const { return m_dfsOut - m_level; }
+
+  bool dominate(const DomTreeNode *other) const {
+    return m_dfsIn <= other->m_dfsIn && other->m_dfsIn <= m_dfsOut;
+  }
+
+private:
+  friend DomTree<GraphTy>;
+  friend GraphTraits<DomTree<GraphTy>>;
+
+  NodeTy m_block{};
+  DomTreeNode *m_idom{nullptr};
+  DomTreeNode **m_childBegin{nullptr};
+  DomTreeNode **m_childEnd{nullptr};
+  std::size_t m_level{0};
+  std::size_t m_dfsIn{0};
+  std::size_t m_dfsOut{0};
+};
+
+// An edge added to or removed from a graph, see DomTree::applyUpdates.
+template <typename NodeTy> struct CFGUpdate {
+  enum Kind {
+    Insert,
+    Delete,
+  };
+
+  Kind kind;
+  NodeTy from;
+  NodeTy to;
+};
+
+// Dominator tree of a graph, nodes are stored in a vector indexed by node
+// id. Reachable nodes are numbered in preorder and every subtree is a slice
+// of the preorder and of the postorder: a dominates b iff b's number falls
+// in a's slice, so a query is two comparisons and a walk over a subtree
+// needs no stack. Unreachable nodes have no tree node and dominate only
+// themselves.
+//
+// Tree nodes point into the tree's arrays, so a tree can be moved but not
+// copied.
 template <typename GraphTy> class DomTree {
 public:
   using Traits = GraphTraits<GraphTy>;
   using NodeTy = typename Traits::NodeTy;
+  using DomTreeNodeTy = DomTreeNode<GraphTy>;
+  using NodesRange = Range<DomTreeNodeTy *const *>;
+  using UpdateTy = CFGUpdate<NodeTy>;
 
-  bool dominate(NodeTy lhs, NodeTy rhs) {
+  DomTree() = default;
+  DomTree(const DomTree &) = delete;
+  DomTree &operator=(const DomTree &) = delete;
+  DomTree(DomTree &&) = default;
+  DomTree &operator=(DomTree &&) = default;
+
+  bool dominate(NodeTy lhs, NodeTy rhs) const {
     if (Traits::id(lhs) == Traits::id(rhs)) {
       return true;
     }
+    auto *lhsNode = getNode(lhs);
+    auto *rhsNode = getNode(rhs);
+    return lhsNode && rhsNode && lhsNode->dominate(rhsNode);
+  }
+  bool strictlyDominate(NodeTy lhs, NodeTy rhs) const {
+    return Traits::id(lhs) != Traits::id(rhs) && dominate(lhs, rhs);
+  }
 
-    auto &&data = m_tree[lhs].dominate;
-    for (auto &&node : data) {
-      if (Traits::id(node) == Traits::id(lhs)) {
-        continue;
+  // nullptr for unreachable nodes
+  DomTreeNodeTy *getNode(NodeTy node) const {
+    auto id = Traits::id(node);
+    if (id >= m_nodes.size() || m_nodes[id].m_block == NodeTy{}) {
+      return nullptr;
+    }
+    return const_cast<DomTreeNodeTy *>(&m_nodes[id]);
+  }
+  DomTreeNodeTy *getRootNode() const { return m_root; }
+  NodeTy getRoot() const { return m_root ? m_root->m_block : NodeTy{}; }
+  // NodeTy{} for the root and unreachable nodes
+  NodeTy getIdom(NodeTy node) const {
+    auto *treeNode = getNode(node);
+    return treeNode && treeNode->m_idom ? treeNode->m_idom->m_block
+                                        : NodeTy{};
+  }
+  bool isReachable(NodeTy node) const { return getNode(node) != nullptr; }
+  std::size_t getDFSIn(NodeTy node) const { return getNode(node)->m_dfsIn; }
+  std::size_t getDFSOut(NodeTy node) const { return getNode(node)->m_dfsOut; }
+
+  // reachable nodes
+  std::size_t size() const { return m_preorder.size(); }
+  // capacity of node ids
+  std::size_t numIds() const { return m_nodes.size(); }
+
+  // The subtree of node in preorder and in postorder.
+  NodesRange preorder(const DomTreeNodeTy *node) const {
+    auto *begin = m_preorder.data();
+    return {begin + node->m_dfsIn, begin + node->m_dfsOut + 1};
+  }
+  NodesRange postorder(const DomTreeNodeTy *node) const {
+    auto *end = m_postorder.data() + node->getPostNum() + 1;
+    return {end - (node->m_dfsOut - node->m_dfsIn + 1), end};
+  }
+  NodesRange preorder() const {
+    return {m_preorder.data(), m_preorder.data() + m_preorder.size()};
+  }
+  NodesRange postorder() const {
+    return {m_postorder.data(), m_postorder.data() + m_postorder.size()};
+  }
+
+  // Brings the tree up to date with edges added to or removed from the
+  // graph. The graph already holds all of them, they are replayed in order
+  // as if each had been made alone. Only the part of the tree an edge can
+  // change is recomputed; a batch large against the tree is rebuilt.
+  void applyUpdates(const std::vector<UpdateTy> &updates);
+  void insertEdge(NodeTy from, NodeTy to) {
+    applyUpdates({{UpdateTy::Insert, from, to}});
+  }
+  void deleteEdge(NodeTy from, NodeTy to) {
+    applyUpdates({{UpdateTy::Delete, from, to}});
+  }
+  // Builds the tree again from the same root.
+  void recalculate();
+
+  void dump(std::ostream &stream) const {
+    for (auto *node : preorder()) {
+      stream << "node: " << Traits::id(node->m_block) << std::endl;
+      if (node->m_idom) {
+        stream << "    idom:" << Traits::id(node->m_idom->m_block) << std::endl;
+      }
+      stream << "    dominates:" << std::endl;
+      for (auto *dominatee : node->children()) {
+        stream << "        " << Traits::id(dominatee->m_block) << std::endl;
       }
+    }
+  }
+
+private:
+  friend DominatorTreeBuilder<GraphTy>;
+
+  // a batch with more updates than this part of the tree is rebuilt
+  static constexpr std::size_t kBatchFraction = 16;
+
+  // The graph as it was right after an update: the edits of the updates
+  // still to apply are undone on the fly. The walks of the builder stay in
+  // the subtree of the region, or out of the tree when it is null.
+  class UpdateView {
+  public:
+    UpdateView(const DomTree &tree, const UpdateTy *begin,
+               const UpdateTy *end)
+        : m_tree{tree}, m_begin{begin}, m_end{end} {}
 
-      if (Traits::id(node) == Traits::id(rhs)) {
-        return true;
+    template <typename Fn> void succs(NodeTy node, Fn &&fn) const {
+      forEachEdge<true>(node, Traits::outEdgeBegin(node),
+                        Traits::outEdgeEnd(node), fn);
+    }
+    template <typename Fn> void preds(NodeTy node, Fn &&fn) const {
+      forEachEdge<false>(node, Traits::inEdgeBegin(node),
+                         Traits::inEdgeEnd(node), fn);
+    }
+    bool descend(NodeTy node) const {
+      auto *treeNode = m_tree.getNode(node);
+      return m_region ? treeNode && m_region->dominate(treeNode) : !treeNode;
+    }
+    bool hasEdge(NodeTy from, NodeTy to) const {
+      auto found = false;
+      succs(from, [&](NodeTy succ) { found |= succ == to; });
+      return found;
+    }
+
+    UpdateView within(const DomTreeNodeTy *region) const {
+      auto view = *this;
+      view.m_region = region;
+      return view;
+    }
+
+  private:
+    template <bool Out, typename It, typename Fn>
+    void forEachEdge(NodeTy node, It begin, It end, Fn &&fn) const {
+      if (m_begin == m_end) {
+        for (; begin != end; ++begin) {
+          fn(*begin);
+        }
+        return;
+      }
+      SmallVector<NodeTy, 8> edges;
+      edges.append(begin, end);
+      for (auto *upd = m_begin; upd != m_end; ++upd) {
+        if ((Out ? upd->from : upd->to) != node) {
+          continue;
+        }
+        auto other = Out ? upd->to : upd->from;
+        if (upd->kind == UpdateTy::Delete) {
+          edges.push_back(other);
+        } else if (auto it = std::find(edges.begin(), edges.end(), other);
+                   it != edges.end()) {
+          edges.erase(it);
+        }
       }
+      for (auto edge : edges) {
+        fn(edge);
+      }
+    }
 
-      if (dominate(node, rhs)) {
-        return true;
+    const DomTree &m_tree;
+    const UpdateTy *m_begin;
+    const UpdateTy *m_end;
+    const DomTreeNodeTy *m_region{nullptr};
+  };
+
+  void insertEdge(const UpdateView &view, NodeTy from, NodeTy to);
+  void insertReachable(const UpdateView &view, DomTreeNodeTy *from,
+                       DomTreeNodeTy *to);
+  void insertUnreachable(const UpdateView &view, DomTreeNodeTy *from,
+                         NodeTy to);
+  void deleteEdge(const UpdateView &view, NodeTy from, NodeTy to);
+  bool hasProperSupport(const UpdateView &view, DomTreeNodeTy *node) const;
+  void deleteUnreachable(const UpdateView &view, DomTreeNodeTy *to);
+  void rebuildSubtree(const UpdateView &view, DomTreeNodeTy *root);
+
+  DomTreeNodeTy *findNCA(DomTreeNodeTy *lhs, DomTreeNodeTy *rhs) const {
+    while (!lhs->dominate(rhs)) {
+      lhs = lhs->m_idom;
+    }
+    return lhs;
+  }
+
+  void reset(std::size_t numIds) {
+    m_root = nullptr;
+    m_nodes.assign(numIds, DomTreeNodeTy{});
+    m_childList.clear();
+    m_preorder.clear();
+    m_postorder.clear();
+  }
+
+  // Makes room for new node ids, the tree needs a relayout afterwards.
+  void growIds(std::size_t numIds) {
+    if (numIds <= m_nodes.size()) {
+      return;
+    }
+    constexpr auto kNone = ~std::size_t{0};
+    std::vector<std::size_t> idoms(m_nodes.size(), kNone);
+    for (std::size_t id = 0; id < m_nodes.size(); ++id) {
+      if (auto *idom = m_nodes[id].m_idom) {
+        idoms[id] = idom - m_nodes.data();
       }
     }
-    return false;
+    auto rootId = m_root ? m_root - m_nodes.data() : kNone;
+    m_nodes.resize(numIds);
+    for (std::size_t id = 0; id < idoms.size(); ++id) {
+      m_nodes[id].m_idom = idoms[id] == kNone ? nullptr : &m_nodes[idoms[id]];
+    }
+    m_root = rootId == kNone ? nullptr : &m_nodes[rootId];
   }
 
-  void dump(std::ostream &stream) {
-    for (auto &&[node, dnode] : m_tree) {
-      stream << "node: " << Traits::id(node) << std::endl;
-      stream << "    idom:" << Traits::id(dnode.idom) << std::endl;
-      stream << "    dominates:" << std::endl;
-      for (auto &&dominatee : dnode.dominate) {
-        stream << "        " << Traits::id(dominatee) << std::endl;
+  // The root is the node with NodeTy{} as idom.
+  void setNode(NodeTy node, NodeTy idom) {
+    auto &treeNode = m_nodes[Traits::id(node)];
+    treeNode.m_block = node;
+    if (idom == NodeTy{}) {
+      treeNode.m_idom = nullptr;
+      m_root = &treeNode;
+    } else {
+      treeNode.m_idom = &m_nodes[Traits::id(idom)];
+    }
+  }
+  void clearNode(DomTreeNodeTy *node) { *node = DomTreeNodeTy{}; }
+
+  // Lays the children out in one array and numbers the tree, after idoms
+  // were changed. The children of every node follow the ones of the nodes
+  // before it in preorder, so those of a subtree are a slice as well.
+  void relayout() {
+    if (!m_root) {
+      m_childList.clear();
+      m_preorder.clear();
+      m_postorder.clear();
+      return;
+    }
+    linkChildren([this](auto &&fn) {
+      for (auto &node : m_nodes) {
+        if (node.m_block != NodeTy{}) {
+          fn(node);
+        }
       }
+    });
+    auto size = m_scratch.size() + 1;
+    m_childList.resize(size - 1);
+    m_preorder.resize(size);
+    m_postorder.resize(size);
+    m_root->m_level = 0;
+    layout(m_root, 0, 0, m_childList.data());
+  }
+
+  // Same for the subtree of root when idoms changed only inside of it: the
+  // subtree keeps its nodes and its slices of every array.
+  void relayout(DomTreeNodeTy *root) {
+    auto pre = root->m_dfsIn;
+    auto size = root->m_dfsOut - pre + 1;
+    auto post = root->getPostNum() + 1 - size;
+    auto *childPos = root->m_childBegin;
+    m_subtree.assign(m_preorder.begin() + pre,
+                     m_preorder.begin() + pre + size);
+    linkChildren(
+        [this](auto &&fn) {
+          for (auto *node : m_subtree) {
+            fn(*node);
+          }
+        },
+        root);
+    layout(root, pre, post, childPos);
+  }
+
+  // Children of the nodes forEachNode gives, in m_scratch for now.
+  template <typename ForEachTy>
+  void linkChildren(ForEachTy &&forEachNode, DomTreeNodeTy *root = nullptr) {
+    // count children in m_dfsIn, the slices follow the counts
+    std::size_t numChildren = 0;
+    forEachNode([](DomTreeNodeTy &node) { node.m_dfsIn = 0; });
+    forEachNode([&](DomTreeNodeTy &node) {
+      if (node.m_idom && &node != root) {
+        ++node.m_idom->m_dfsIn;
+        ++numChildren;
+      }
+    });
+    m_scratch.resize(numChildren);
+    auto *slice = m_scratch.data();
+    forEachNode([&](DomTreeNodeTy &node) {
+      node.m_childBegin = node.m_childEnd = slice;
+      slice += node.m_dfsIn;
+    });
+    forEachNode([&](DomTreeNodeTy &node) {
+      if (node.m_idom && &node != root) {
+        *node.m_idom->m_childEnd++ = &node;
+      }
+    });
+  }
+
+  // Iterative walk from root numbering its subtree from pre and post, and
+  // moving the children of each node to childPos as it is entered.
+  void layout(DomTreeNodeTy *root, std::size_t pre, std::size_t post,
+              DomTreeNodeTy **childPos) {
+    auto &stack = m_layoutStack;
+    auto enter = [&](DomTreeNodeTy *node) {
+      node->m_dfsIn = pre;
+      m_preorder[pre++] = node;
+      auto *end = std::copy(node->m_childBegin, node->m_childEnd, childPos);
+      node->m_childBegin = childPos;
+      node->m_childEnd = childPos = end;
+      stack.emplace_back(node, 0);
+    };
+    enter(root);
+    while (!stack.empty()) {
+      auto &[node, child] = stack.back();
+      if (child == node->numChildren()) {
+        node->m_dfsOut = pre - 1;
+        m_postorder[post++] = node;
+        stack.pop_back();
+        continue;
+      }
+      auto *next = node->m_childBegin[child++];
+      next->m_level = node->m_level + 1;
+      enter(next);
     }
   }
 
-private:
-  friend DominatorTreeBuilder<GraphTy>;
+  // Builder for the parts of the tree updates recompute, kept for its
+  // buffers.
+  DominatorTreeBuilder<GraphTy> &getUpdater() {
+    if (!m_updater) {
+      m_updater = std::make_unique<DominatorTreeBuilder<GraphTy>>();
+    }
+    return *m_updater;
+  }
 
-  struct DomTreeNode {
-    NodeTy idom;
-    std::vector<NodeTy> dominate;
-  };
+  DomTreeNodeTy *m_root{nullptr};
+  std::vector<DomTreeNodeTy> m_nodes;
+  // children of every node, each node owns a slice
+  std::vector<DomTreeNodeTy *> m_childList;
+  std::vector<DomTreeNodeTy *> m_preorder;
+  std::vector<DomTreeNodeTy *> m_postorder;
+  // buffers of relayouts and updates
+  std::vector<DomTreeNodeTy *> m_scratch;
+  std::vector<DomTreeNodeTy *> m_subtree;
+  std::vector<std::pair<DomTreeNodeTy *, std::size_t>> m_layoutStack;
+  std::unique_ptr<DominatorTreeBuilder<GraphTy>> m_updater;
+};
+
+// The dominator tree as a graph: out edges go to the children, the in edge
+// to the idom.
+template <typename GraphTy> struct GraphTraits<DomTree<GraphTy>> {
+  using TreeTy = DomTree<GraphTy>;
+  using NodeTy = DomTreeNode<GraphTy> *;
+  using EdgesItTy = NodeTy const *;
+  using NodesIt = EdgesItTy;
+
+  static NodeTy entry(const TreeTy &G) { return G.getRootNode(); }
+  // reachable nodes in preorder
+  static NodesIt nodesBegin(TreeTy &G) { return G.preorder().begin(); }
+  static NodesIt nodesEnd(TreeTy &G) { return G.preorder().end(); }
+
+  static std::size_t nodesCount(const TreeTy &G) { return G.numIds(); }
+  static std::size_t id(NodeTy node) {
+    return GraphTraits<GraphTy>::id(node->m_block);
+  }
 
-  std::unordered_map<NodeTy, DomTreeNode> m_tree;
+  static EdgesItTy inEdgeBegin(NodeTy node) { return &node->m_idom; }
+  static EdgesItTy inEdgeEnd(NodeTy node) {
+    return &node->m_idom + (node->m_idom != nullptr);
+  }
+
+  static EdgesItTy outEdgeBegin(NodeTy node) { return node->m_childBegin; }
+  static EdgesItTy outEdgeEnd(NodeTy node) { return node->m_childEnd; }
 };
 
-template <typename NodeTy> struct GraphTraits<DomTree<NodeTy>> {
-  // TODO
+// Algorithm used by DominatorTreeBuilder. Both give the same tree:
+// Lengauer-Tarjan fixes idoms through semi-dominator buckets, Semi-NCA
+// walks up the partially built tree instead, which is simpler and usually
+// faster on CFGs.
+enum class DomTreeAlgo {
+  LengauerTarjan,
+  SemiNCA,
 };
 
+// Builds dominator trees. Everything is indexed by the preorder number of
+// a node (1 for the entry, 0 means not reached) in flat arrays reused
+// between builds, and both the DFS and the path compression are iterative,
+// so the depth of the graph is not bounded by the call stack.
 template <typename GraphTy> class DominatorTreeBuilder {
 public:
   using Traits = GraphTraits<GraphTy>;
@@ -75,208 +472,526 @@ public:
   using EdgesItTy = typename Traits::EdgesItTy;
   using DomTreeTy = DomTree<GraphTy>;
 
+  explicit DominatorTreeBuilder(DomTreeAlgo algo = DomTreeAlgo::SemiNCA)
+      : m_algo{algo} {}
+
   DomTreeTy build(GraphTy &G);
 
 private:
-  void reset();
-  void initState(GraphTy &G);
-  void computeLabels(NodeTy node);
+  friend DomTreeTy;
+
+  // Edges of the whole graph, DomTree updates walk a part of it instead.
+  struct GraphEdges {
+    template <typename Fn> void succs(NodeTy node, Fn &&fn) const {
+      auto it = Traits::outEdgeBegin(node);
+      for (; it != Traits::outEdgeEnd(node); ++it) {
+        fn(*it);
+      }
+    }
+    template <typename Fn> void preds(NodeTy node, Fn &&fn) const {
+      auto it = Traits::inEdgeBegin(node);
+      for (; it != Traits::inEdgeEnd(node); ++it) {
+        fn(*it);
+      }
+    }
+    bool descend(NodeTy) const { return true; }
+  };
 
-  class DSU;
-  void computeSdoms(DSU &dsu);
-  void computeIdoms();
+  // Computes the idoms of the nodes edges reach from root. Numbers must be
+  // all zero: a builder runs once, or is reused through build or after
+  // clearNums.
+  template <typename EdgesTy> void run(NodeTy root, const EdgesTy &edges);
+  // Zeroes the numbers of the last run, while its nodes are alive.
+  void clearNums() {
+    for (std::size_t num = 1; num < m_nodes.size(); ++num) {
+      m_dfsNum[Traits::id(m_nodes[num])] = 0;
+    }
+  }
+  // Replaces the content of domTree with the result of run.
+  void fill(DomTreeTy &domTree, std::size_t numIds) const;
+
+  template <typename EdgesTy>
+  void computeDFS(NodeTy root, const EdgesTy &edges);
+  template <typename EdgesTy> void computeSemiNCA(const EdgesTy &edges);
+  template <typename EdgesTy> void computeLengauerTarjan(const EdgesTy &edges);
+
+  // the node with the minimal semi on the path from num up to its forest
+  // root, compressing the path on the way
+  std::size_t eval(std::size_t num);
+  void compress(std::size_t num);
+
+  // preorder number of node, 0 when the last run did not reach it
+  std::size_t getNum(NodeTy node) const {
+    auto id = Traits::id(node);
+    return id < m_dfsNum.size() ? m_dfsNum[id] : 0;
+  }
+
+  // preorder numbers of reached preds of num
+  template <typename EdgesTy, typename Fn>
+  void forEachPred(const EdgesTy &edges, std::size_t num, Fn &&fn) {
+    edges.preds(m_nodes[num], [&](NodeTy pred) {
+      if (auto predNum = getNum(pred)) {
+        fn(predNum);
+      }
+    });
+  }
 
 private:
-  using IndexMap = std::unordered_map<std::size_t, std::size_t>;
-
-  IndexMap m_dfsLabels;
-  std::vector<NodeTy> m_dfsNodes;
-  std::set<std::size_t> m_visited;
-  // parent of node i in dfs tree
-  IndexMap m_dfsParents;
-  // label of semi-dominator of the i’th node
-  std::vector<std::size_t> m_sdoms;
-  // label of immediate-dominator of the i’th node
-  std::vector<std::size_t> m_idoms;
-  // For a vertex i, it stores a list of vertices for which i is the
-  // semi-dominator
-  std::vector<std::vector<std::size_t>> m_bucket;
-
-  DomTreeTy m_domTree;
-  class DSU {
-  public:
-    DSU(const IndexMap &dfsLabels, const std::vector<std::size_t> &sdoms,
-        const std::vector<NodeTy> &dfsNodes)
-        : m_dfsLabels{dfsLabels}, m_sdoms{sdoms} {
-      m_dsu = dfsNodes;
-      m_labels = dfsNodes;
-    }
+  DomTreeAlgo m_algo;
+
+  // preorder number by node id, only the reached nodes are non zero
+  std::vector<std::size_t> m_dfsNum;
+  // the rest is indexed by preorder number
+  std::vector<NodeTy> m_nodes;
+  std::vector<std::size_t> m_parent;
+  std::vector<std::size_t> m_semi;
+  std::vector<std::size_t> m_idom;
+  // link-eval forest: ancestor 0 marks a root, label is the node with the
+  // minimal semi on the compressed path
+  std::vector<std::size_t> m_ancestor;
+  std::vector<std::size_t> m_label;
+  // nodes grouped by semi-dominator, as linked lists
+  std::vector<std::size_t> m_bucket;
+  std::vector<std::size_t> m_bucketNext;
+
+  std::vector<std::pair<NodeTy, EdgesItTy>> m_edgeStack;
+  // nodes to visit with the number of the node they were found from
+  std::vector<std::pair<NodeTy, std::size_t>> m_dfsStack;
+  std::vector<std::size_t> m_path;
+};
 
-    NodeTy find(NodeTy v);
-    void merge(NodeTy parent, NodeTy node) { setParent(parent, node); }
+template <typename GraphTy>
+typename DominatorTreeBuilder<GraphTy>::DomTreeTy
+DominatorTreeBuilder<GraphTy>::build(GraphTy &G) {
+  // the nodes of the last build may be gone, their numbers are dropped
+  // wholesale
+  m_dfsNum.assign(Traits::nodesCount(G), 0);
+  run(Traits::entry(G), GraphEdges{});
+
+  auto domTree = DomTreeTy{};
+  fill(domTree, Traits::nodesCount(G));
+  return domTree;
+}
 
-    NodeTy getParent(NodeTy node) {
-      return m_dsu[m_dfsLabels.at(Traits::id(node))];
-    }
+template <typename GraphTy>
+template <typename EdgesTy>
+void DominatorTreeBuilder<GraphTy>::run(NodeTy root, const EdgesTy &edges) {
+  m_nodes.assign(1, NodeTy{});
+  m_parent.assign(1, 0);
+
+  computeDFS(root, edges);
+  if (m_algo == DomTreeAlgo::SemiNCA) {
+    computeSemiNCA(edges);
+  } else {
+    computeLengauerTarjan(edges);
+  }
+}
 
-    void setParent(NodeTy parent, NodeTy node) {
-      m_dsu[m_dfsLabels.at(Traits::id(node))] = parent;
-    }
+template <typename GraphTy>
+void DominatorTreeBuilder<GraphTy>::fill(DomTreeTy &domTree,
+                                         std::size_t numIds) const {
+  for (std::size_t num = 1; num < m_nodes.size(); ++num) {
+    numIds = std::max(numIds, Traits::id(m_nodes[num]) + 1);
+  }
+  domTree.reset(numIds);
+  domTree.setNode(m_nodes[1], NodeTy{});
+  for (std::size_t num = 2; num < m_nodes.size(); ++num) {
+    domTree.setNode(m_nodes[num], m_nodes[m_idom[num]]);
+  }
+  domTree.relayout();
+}
 
-    NodeTy getLabel(NodeTy node) {
-      return m_labels[m_dfsLabels.at(Traits::id(node))];
+// A whole graph is walked edge by edge with a stack of (node, next edge).
+// Other edges are only seen through a callback: then a node is numbered
+// when it is popped, with the node that pushed it last as parent, which
+// gives a depth-first spanning tree as well.
+template <typename GraphTy>
+template <typename EdgesTy>
+void DominatorTreeBuilder<GraphTy>::computeDFS(NodeTy root,
+                                               const EdgesTy &edges) {
+  auto visit = [this](NodeTy node, std::size_t parent) {
+    auto id = Traits::id(node);
+    if (id >= m_dfsNum.size()) {
+      m_dfsNum.resize(std::max(id + 1, 2 * m_dfsNum.size()));
     }
+    m_dfsNum[id] = m_nodes.size();
+    m_nodes.push_back(node);
+    m_parent.push_back(parent);
+  };
 
-    void setLabel(NodeTy node, NodeTy parent) {
-      m_labels[m_dfsLabels.at(Traits::id(node))] = parent;
+  if constexpr (std::is_same_v<EdgesTy, GraphEdges>) {
+    m_edgeStack.clear();
+    visit(root, 0);
+    m_edgeStack.emplace_back(root, Traits::outEdgeBegin(root));
+    while (!m_edgeStack.empty()) {
+      auto &[node, edgeIt] = m_edgeStack.back();
+      if (edgeIt == Traits::outEdgeEnd(node)) {
+        m_edgeStack.pop_back();
+        continue;
+      }
+      auto succ = *edgeIt++;
+      if (!getNum(succ)) {
+        visit(succ, getNum(node));
+        m_edgeStack.emplace_back(succ, Traits::outEdgeBegin(succ));
+      }
     }
-
-    std::size_t getSemi(NodeTy node) {
-      return m_sdoms[m_dfsLabels.at(Traits::id(node))];
+  } else {
+    m_dfsStack.clear();
+    m_dfsStack.emplace_back(root, 0);
+    while (!m_dfsStack.empty()) {
+      auto [node, parent] = m_dfsStack.back();
+      m_dfsStack.pop_back();
+      if (getNum(node)) {
+        continue;
+      }
+      visit(node, parent);
+      auto num = m_nodes.size() - 1;
+      edges.succs(node, [&](NodeTy succ) {
+        if (!getNum(succ) && edges.descend(succ)) {
+          m_dfsStack.emplace_back(succ, num);
+        }
+      });
     }
+  }
 
-  private:
-    void compress(NodeTy node);
-
-  private:
-    const IndexMap &m_dfsLabels;
-    const std::vector<std::size_t> &m_sdoms;
+  auto size = m_nodes.size();
+  m_semi.resize(size);
+  m_label.resize(size);
+  m_idom.resize(size);
+  m_ancestor.assign(size, 0);
+  for (std::size_t num = 0; num < size; ++num) {
+    m_semi[num] = m_label[num] = num;
+  }
+}
 
-    std::vector<NodeTy> m_dsu;
-    // m_labels[i] stores the vertex v with minimum sdom,
-    // lying on path from i to the dsu root.
-    std::vector<NodeTy> m_labels;
-  };
-};
+template <typename GraphTy>
+std::size_t DominatorTreeBuilder<GraphTy>::eval(std::size_t num) {
+  if (!m_ancestor[num]) {
+    return num;
+  }
+  compress(num);
+  return m_label[num];
+}
 
 template <typename GraphTy>
-typename DominatorTreeBuilder<GraphTy>::NodeTy
-DominatorTreeBuilder<GraphTy>::DSU::find(NodeTy v) {
-  compress(v);
-  return getLabel(v);
+void DominatorTreeBuilder<GraphTy>::compress(std::size_t num) {
+  // nodes below the child of the forest root, the root is not evaluated
+  m_path.clear();
+  for (auto cur = num; m_ancestor[m_ancestor[cur]]; cur = m_ancestor[cur]) {
+    m_path.push_back(cur);
+  }
+  // from the top down, so every ancestor is already compressed
+  for (auto it = m_path.rbegin(); it != m_path.rend(); ++it) {
+    auto cur = *it;
+    auto anc = m_ancestor[cur];
+    if (m_semi[m_label[anc]] < m_semi[m_label[cur]]) {
+      m_label[cur] = m_label[anc];
+    }
+    m_ancestor[cur] = m_ancestor[anc];
+  }
 }
 
 template <typename GraphTy>
-void DominatorTreeBuilder<GraphTy>::DSU::compress(NodeTy node) {
-  auto parentNode = getParent(node);
-  if (parentNode == node) {
-    return;
+template <typename EdgesTy>
+void DominatorTreeBuilder<GraphTy>::computeSemiNCA(const EdgesTy &edges) {
+  auto size = m_nodes.size();
+  for (auto num = size - 1; num >= 2; --num) {
+    forEachPred(edges, num, [&](std::size_t pred) {
+      m_semi[num] = std::min(m_semi[num], m_semi[eval(pred)]);
+    });
+    m_ancestor[num] = m_parent[num];
   }
 
-  compress(parentNode);
+  // the idom is the nearest common ancestor of the parent and the semi
+  // in the tree built so far, the first one not below the semi
+  m_idom[1] = 0;
+  for (std::size_t num = 2; num < size; ++num) {
+    auto idom = m_parent[num];
+    while (idom > m_semi[num]) {
+      idom = m_idom[idom];
+    }
+    m_idom[num] = idom;
+  }
+}
 
-  setParent(getParent(parentNode), node);
+template <typename GraphTy>
+template <typename EdgesTy>
+void DominatorTreeBuilder<GraphTy>::computeLengauerTarjan(
+    const EdgesTy &edges) {
+  auto size = m_nodes.size();
+  m_bucket.assign(size, 0);
+  m_bucketNext.assign(size, 0);
+  for (auto num = size - 1; num >= 2; --num) {
+    forEachPred(edges, num, [&](std::size_t pred) {
+      m_semi[num] = std::min(m_semi[num], m_semi[eval(pred)]);
+    });
+    auto semi = m_semi[num];
+    m_bucketNext[num] = m_bucket[semi];
+    m_bucket[semi] = num;
+
+    auto parent = m_parent[num];
+    m_ancestor[num] = parent;
+    // the bucket of parent is complete: its nodes are all in its subtree
+    for (auto dominatee = m_bucket[parent]; dominatee;
+         dominatee = m_bucketNext[dominatee]) {
+      auto minNode = eval(dominatee);
+      m_idom[dominatee] =
+          m_semi[minNode] < m_semi[dominatee] ? minNode : parent;
+    }
+    m_bucket[parent] = 0;
+  }
 
-  if (getSemi(parentNode) < getSemi(node)) {
-    setLabel(node, getParent(node));
+  // preorder: the idom of a node is fixed before the node itself
+  m_idom[1] = 0;
+  for (std::size_t num = 2; num < size; ++num) {
+    if (m_idom[num] != m_semi[num]) {
+      m_idom[num] = m_idom[m_idom[num]];
+    }
   }
 }
 
 template <typename GraphTy>
-typename DominatorTreeBuilder<GraphTy>::DomTreeTy
-DominatorTreeBuilder<GraphTy>::build(GraphTy &G) {
-  reset();
-  initState(G);
-  computeLabels(Traits::entry(G));
-  auto dsu = DSU(m_dfsLabels, m_sdoms, m_dfsNodes);
-  computeSdoms(dsu);
-  computeIdoms();
-
-  return m_domTree;
+void DomTree<GraphTy>::applyUpdates(const std::vector<UpdateTy> &updates) {
+  assert(m_root && "the tree was never built");
+  if (updates.size() > 1 && updates.size() > size() / kBatchFraction) {
+    recalculate();
+    return;
+  }
+  auto *end = updates.data() + updates.size();
+  for (auto *upd = updates.data(); upd != end; ++upd) {
+    auto view = UpdateView{*this, upd + 1, end};
+    if (upd->kind == UpdateTy::Insert) {
+      insertEdge(view, upd->from, upd->to);
+    } else {
+      deleteEdge(view, upd->from, upd->to);
+    }
+  }
 }
 
-template <typename GraphTy> void DominatorTreeBuilder<GraphTy>::reset() {
-  m_dfsNodes.clear();
-  m_dfsLabels.clear();
-  m_dfsParents.clear();
-  m_sdoms.clear();
-  m_bucket.clear();
+template <typename GraphTy> void DomTree<GraphTy>::recalculate() {
+  assert(m_root && "the tree was never built");
+  using BuilderTy = DominatorTreeBuilder<GraphTy>;
+  auto builder = BuilderTy{};
+  builder.run(m_root->m_block, typename BuilderTy::GraphEdges{});
+  builder.fill(*this, m_nodes.size());
 }
 
 template <typename GraphTy>
-void DominatorTreeBuilder<GraphTy>::initState(GraphTy &G) {
-  m_dfsNodes.reserve(Traits::nodesCount(G));
-  m_sdoms.resize(Traits::nodesCount(G));
-  m_idoms.resize(Traits::nodesCount(G));
-  m_bucket.resize(Traits::nodesCount(G));
-
-  m_dfsParents[Traits::id(Traits::entry(G))] = 0;
+void DomTree<GraphTy>::insertEdge(const UpdateView &view, NodeTy from,
+                                  NodeTy to) {
+  // edges out of unreachable code change nothing
+  if (auto *fromNode = getNode(from)) {
+    if (auto *toNode = getNode(to)) {
+      insertReachable(view, fromNode, toNode);
+    } else {
+      insertUnreachable(view, fromNode, to);
+    }
+  }
 }
 
+// The nodes that get the NCA of from and to as idom are the ones deeper
+// than its children that to reaches through nodes at least as deep as they
+// are. They are found deepest first with a priority queue by level.
 template <typename GraphTy>
-void DominatorTreeBuilder<GraphTy>::computeLabels(NodeTy node) {
-  auto counter = m_visited.size();
-
-  m_dfsNodes.push_back(node);
-  m_visited.insert(Traits::id(node));
-
-  m_dfsLabels[Traits::id(node)] = counter;
-  m_sdoms[counter] = counter;
-  m_idoms[counter] = counter;
+void DomTree<GraphTy>::insertReachable(const UpdateView &view,
+                                       DomTreeNodeTy *from,
+                                       DomTreeNodeTy *to) {
+  auto *nca = findNCA(from, to);
+  auto minLevel = nca->m_level + 1;
+  if (to->m_level <= minLevel) {
+    return;
+  }
 
-  auto it = Traits::outEdgeBegin(node);
-  for (; it != Traits::outEdgeEnd(node); ++it) {
-    if (!m_visited.count(Traits::id(*it))) {
-      m_dfsParents[Traits::id(*it)] = counter;
-      computeLabels(*it);
+  using LevelNode = std::pair<std::size_t, DomTreeNodeTy *>;
+  std::vector<LevelNode> bucket;
+  std::vector<DomTreeNodeTy *> affected;
+  std::vector<DomTreeNodeTy *> unaffected;
+  SmallPtrSet<DomTreeNodeTy *, 16> visited;
+  bucket.emplace_back(to->m_level, to);
+  visited.insert(to);
+  while (!bucket.empty()) {
+    std::pop_heap(bucket.begin(), bucket.end());
+    auto *node = bucket.back().second;
+    bucket.pop_back();
+    affected.push_back(node);
+
+    auto level = node->m_level;
+    while (true) {
+      view.succs(node->m_block, [&](NodeTy succ) {
+        auto *succNode = getNode(succ);
+        if (!succNode || succNode->m_level <= minLevel ||
+            !visited.insert(succNode)) {
+          return;
+        }
+        if (succNode->m_level > level) {
+          // not affected, but what it reaches may be
+          unaffected.push_back(succNode);
+        } else {
+          bucket.emplace_back(succNode->m_level, succNode);
+          std::push_heap(bucket.begin(), bucket.end());
+        }
+      });
+      if (unaffected.empty()) {
+        break;
+      }
+      node = unaffected.back();
+      unaffected.pop_back();
     }
   }
+
+  for (auto *node : affected) {
+    node->m_idom = nca;
+  }
+  relayout(nca);
 }
 
+// The part of the graph that to makes reachable gets its own tree under
+// from, then the edges leaving it into the old tree are inserted.
 template <typename GraphTy>
-void DominatorTreeBuilder<GraphTy>::computeSdoms(DSU &dsu) {
-  std::size_t currentIdx = m_dfsNodes.size() - 1;
-  for (auto it = m_dfsNodes.rbegin(); it != m_dfsNodes.rend();
-       ++it, --currentIdx) {
-    auto currenNode = *it;
-
-    auto ancestorIt = Traits::inEdgeBegin(currenNode);
-    auto ancestorEnd = Traits::inEdgeEnd(currenNode);
-
-    for (; ancestorIt != ancestorEnd; ++ancestorIt) {
-      auto ancWithMinSdom = dsu.find(*ancestorIt);
-      auto ancWithMinSdomIdx = m_dfsLabels[Traits::id(ancWithMinSdom)];
-
-      m_sdoms[currentIdx] =
-          std::min(m_sdoms[currentIdx], m_sdoms[ancWithMinSdomIdx]);
-      if (*it != *m_dfsNodes.begin()) {
-        m_bucket[m_sdoms[currentIdx]].push_back(currentIdx);
+void DomTree<GraphTy>::insertUnreachable(const UpdateView &view,
+                                         DomTreeNodeTy *from, NodeTy to) {
+  auto &builder = getUpdater();
+  builder.run(to, view.within(nullptr));
+
+  std::vector<std::pair<NodeTy, NodeTy>> connecting;
+  auto numIds = m_nodes.size();
+  for (std::size_t num = 1; num < builder.m_nodes.size(); ++num) {
+    auto node = builder.m_nodes[num];
+    numIds = std::max(numIds, Traits::id(node) + 1);
+    view.succs(node, [&](NodeTy succ) {
+      if (getNode(succ)) {
+        connecting.emplace_back(node, succ);
       }
-    }
+    });
+  }
+
+  auto fromBlock = from->m_block;
+  growIds(numIds);
+  setNode(to, fromBlock);
+  for (std::size_t num = 2; num < builder.m_nodes.size(); ++num) {
+    setNode(builder.m_nodes[num], builder.m_nodes[builder.m_idom[num]]);
+  }
+  builder.clearNums();
+  relayout();
 
-    for (auto &&dominateeIdx : m_bucket[currentIdx]) {
-      auto minSdom = dsu.find(m_dfsNodes[dominateeIdx]);
-      auto minSdomIdx = m_dfsLabels[Traits::id(minSdom)];
+  for (auto &&[src, dst] : connecting) {
+    insertReachable(view, getNode(src), getNode(dst));
+  }
+}
 
-      if (m_sdoms[minSdomIdx] == m_sdoms[dominateeIdx]) {
-        m_idoms[dominateeIdx] = m_sdoms[dominateeIdx];
-      } else {
-        m_idoms[dominateeIdx] = minSdomIdx;
+template <typename GraphTy>
+void DomTree<GraphTy>::deleteEdge(const UpdateView &view, NodeTy from,
+                                  NodeTy to) {
+  auto *fromNode = getNode(from);
+  auto *toNode = getNode(to);
+  // a parallel edge may be left
+  if (!fromNode || !toNode || view.hasEdge(from, to)) {
+    return;
+  }
+  // none loses a path avoiding one of its dominators when to dominates from
+  auto *nca = findNCA(fromNode, toNode);
+  if (nca == toNode) {
+    return;
+  }
+  if (toNode->m_idom != fromNode || hasProperSupport(view, toNode)) {
+    // to stays reachable: only nodes below the NCA can change
+    rebuildSubtree(view, nca);
+  } else {
+    deleteUnreachable(view, toNode);
+  }
+}
+
+// A pred that node does not dominate still reaches it.
+template <typename GraphTy>
+bool DomTree<GraphTy>::hasProperSupport(const UpdateView &view,
+                                        DomTreeNodeTy *node) const {
+  auto supported = false;
+  view.preds(node->m_block, [&](NodeTy pred) {
+    auto *predNode = getNode(pred);
+    supported |= predNode && !node->dominate(predNode);
+  });
+  return supported;
+}
+
+// The subtree of to is cut off. The nodes it has edges to elsewhere may
+// lose paths too: the smallest subtree holding them and to is rebuilt.
+template <typename GraphTy>
+void DomTree<GraphTy>::deleteUnreachable(const UpdateView &view,
+                                         DomTreeNodeTy *to) {
+  auto *top = to;
+  for (auto *node : preorder(to)) {
+    view.succs(node->m_block, [&](NodeTy succ) {
+      auto *succNode = getNode(succ);
+      if (succNode && !to->dominate(succNode) && !succNode->dominate(to)) {
+        top = findNCA(top, succNode);
       }
-    }
+    });
+  }
+  if (top != to) {
+    rebuildSubtree(view, top);
+    return;
+  }
+  for (auto *node : preorder(to)) {
+    clearNode(node);
+  }
+  relayout();
+}
 
-    if (*it != *m_dfsNodes.begin()) {
-      dsu.merge(m_dfsNodes[m_dfsParents[Traits::id(currenNode)]], currenNode);
+// Runs the builder on the subtree of root. Nodes it does not reach any
+// more became unreachable.
+template <typename GraphTy>
+void DomTree<GraphTy>::rebuildSubtree(const UpdateView &view,
+                                      DomTreeNodeTy *root) {
+  auto &builder = getUpdater();
+  builder.run(root->m_block, view.within(root));
+
+  // the subtree keeps its slices when it keeps all of its nodes
+  auto lost = false;
+  for (auto *node : preorder(root)) {
+    if (!builder.getNum(node->m_block)) {
+      clearNode(node);
+      lost = true;
     }
   }
+  for (std::size_t num = 2; num < builder.m_nodes.size(); ++num) {
+    setNode(builder.m_nodes[num], builder.m_nodes[builder.m_idom[num]]);
+  }
+  builder.clearNums();
+  if (lost) {
+    relayout();
+  } else {
+    relayout(root);
+  }
 }
 
-template <typename GraphTy> void DominatorTreeBuilder<GraphTy>::computeIdoms() {
-  std::size_t id = 0;
-  for (auto &&node : m_dfsNodes) {
-    if (m_idoms[id] != m_sdoms[id]) {
-      m_idoms[id] = m_idoms[m_idoms[id]];
-    }
+// Keeps the dominator tree of a function valid across edits of its CFG:
+// while the listener is alive every edge the function gains or loses
+// updates the tree.
+class DomTreeListener final : public CFGListener {
+public:
+  DomTreeListener(Function &function, DomTree<BasicBlocksGraph> &domTree)
+      : m_function{function}, m_domTree{domTree} {
+    assert(!function.getCFGListener() && "the function has a listener");
+    function.setCFGListener(this);
+  }
+  ~DomTreeListener() override { m_function.setCFGListener(nullptr); }
 
-    auto immNode = m_dfsNodes[m_idoms[id]];
-    m_domTree.m_tree[node].idom = immNode;
-    m_domTree.m_tree[immNode].dominate.push_back(node);
+  DomTreeListener(const DomTreeListener &) = delete;
+  DomTreeListener &operator=(const DomTreeListener &) = delete;
 
-    ++id;
+  void edgeInserted(BasicBlock *from, BasicBlock *to) override {
+    m_domTree.insertEdge(from, to);
   }
-}
+  void edgeDeleted(BasicBlock *from, BasicBlock *to) override {
+    m_domTree.deleteEdge(from, to);
+  }
+
+private:
+  Function &m_function;
+  DomTree<BasicBlocksGraph> &m_domTree;
+};
 
-bool dominate(DomTree<BasicBlocksGraph> &domTree, Instruction *lhs,
+bool dominate(const DomTree<BasicBlocksGraph> &domTree, Instruction *lhs,
               Instruction *rhs);
 
 } // namespace jade
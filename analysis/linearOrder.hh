@@ -16,16 +16,28 @@ template <typename GraphTy> class LinearOrder {
 public:
   using Traits = GraphTraits<GraphTy>;
 
-  LinearOrder(GraphTy &G) : m_graph(G) {
+  using NodeTy = typename Traits::NodeTy;
+
+  LinearOrder(GraphTy &G) : m_graph(G), m_loopTree(&m_ownLoopTree) {
     auto lBuilder = LoopTreeBuilder<GraphTy>();
-    m_loopTree = lBuilder.build(G);
+    m_ownLoopTree = lBuilder.build(G);
   }
+  // Reuses a loop tree the caller already has, it must outlive the order.
+  LinearOrder(GraphTy &G, const LoopTree<GraphTy> &loops)
+      : m_graph(G), m_loopTree(&loops) {}
+  LinearOrder(const LinearOrder &) = delete;
+  LinearOrder &operator=(const LinearOrder &) = delete;
 
-  std::vector<typename Traits::NodeTy> linearize();
+  std::vector<NodeTy> linearize();
+  // Same, from an RPO of the graph computed elsewhere (see Function::rpo).
+  std::vector<NodeTy> linearize(const std::vector<NodeTy> &rpo);
 
 private:
+  void visit(NodeTy node);
+
   GraphTy &m_graph;
-  LoopTree<GraphTy> m_loopTree;
+  LoopTree<GraphTy> m_ownLoopTree;
+  const LoopTree<GraphTy> *m_loopTree;
   std::set<typename Traits::NodeTy> m_visited;
   std::vector<typename Traits::NodeTy> m_linear{};
 };
@@ -37,29 +49,42 @@ LinearOrder<GraphTy>::linearize() {
   auto rpoEnd = RPOIterator<GraphTy>::end(m_graph);
 
   for (; rpoIt != rpoEnd; ++rpoIt) {
-    auto node = *rpoIt;
-    if (m_visited.count(node)) {
-      continue;
-    }
+    visit(*rpoIt);
+  }
+
+  return m_linear;
+}
+
+template <typename GraphTy>
+std::vector<typename GraphTraits<GraphTy>::NodeTy>
+LinearOrder<GraphTy>::linearize(const std::vector<NodeTy> &rpo) {
+  for (auto node : rpo) {
+    visit(node);
+  }
 
-    m_visited.insert(node);
-    m_linear.push_back(node);
+  return m_linear;
+}
 
-    auto *loop = m_loopTree.getLoop(node);
-    if (loop && loop->getHeader() == node && loop->isReducible()) {
-      auto loop_nodes = loop->getNodes();
-      for (auto &&loop_node : loop_nodes) {
-        if (m_visited.count(node)) {
-          continue;
-        }
+template <typename GraphTy> void LinearOrder<GraphTy>::visit(NodeTy node) {
+  if (m_visited.count(node)) {
+    return;
+  }
 
-        m_visited.insert(loop_node);
-        m_linear.push_back(node);
+  m_visited.insert(node);
+  m_linear.push_back(node);
+
+  auto *loop = m_loopTree->getLoop(node);
+  if (loop && loop->getHeader() == node && loop->isReducible()) {
+    auto loop_nodes = loop->getNodes();
+    for (auto &&loop_node : loop_nodes) {
+      if (m_visited.count(node)) {
+        continue;
       }
+
+      m_visited.insert(loop_node);
+      m_linear.push_back(node);
     }
   }
-
-  return m_linear;
 }
 
 } // namespace jade
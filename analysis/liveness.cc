@@ -7,125 +7,230 @@
 
 namespace jade {
 
-static void dumpLiveSet(std::ostream &stream, const Liveness::LiveSet &set) {
-  for (auto *instr : set) {
-    stream << instr->getName() << " ";
+static void dumpLiveSet(std::ostream &stream, const Liveness::LiveSet &set,
+                        const std::vector<Instruction *> &values) {
+  for (auto id : set) {
+    stream << values[id]->getName() << " ";
   }
   stream << std::endl;
 }
 
-static void dumpLiveInterval(std::ostream &stream,
+static void dumpLiveInterval(std::ostream &stream, Function &func,
                              const Liveness::LiveIntervals &lints) {
-  for (auto &&[val, interaval] : lints) {
-    stream << val->getName() << " " << interaval << " ";
+  for (auto &&bb : func.getBasicBlocks().nodes()) {
+    for (auto &&instr : bb) {
+      if (lints.inBounds(&instr)) {
+        stream << instr.getName() << " " << lints.at(&instr) << " ";
+      }
+    }
   }
   stream << std::endl;
 }
 
+void LiveRange::addSegment(std::size_t begin, std::size_t end) {
+  if (!m_segments.empty() && m_segments.back().begin <= end) {
+    auto &last = m_segments.back();
+    last.begin = std::min(last.begin, begin);
+    last.end = std::max(last.end, end);
+    return;
+  }
+  m_segments.push_back({begin, end});
+}
+
+void LiveRange::setBegin(std::size_t pos) {
+  // a value nobody reads lives at its def only
+  if (m_segments.empty()) {
+    m_segments.push_back({pos, pos + 1});
+    return;
+  }
+  assert(m_segments.back().begin <= pos && pos < m_segments.back().end);
+  m_segments.back().begin = pos;
+}
+
+void LiveRange::finish() {
+  std::reverse(m_segments.begin(), m_segments.end());
+  std::reverse(m_uses.begin(), m_uses.end());
+}
+
+std::size_t LiveRange::firstIntersection(const LiveRange &other) const {
+  if (empty() || other.empty() || end() <= other.begin() ||
+      other.end() <= begin()) {
+    return kNone;
+  }
+  // skip the segments ending before the other range starts
+  auto byEnd = [](const Segment &seg, std::size_t pos) {
+    return seg.end <= pos;
+  };
+  auto lhs = std::lower_bound(m_segments.begin(), m_segments.end(),
+                              other.begin(), byEnd);
+  auto rhs = std::lower_bound(other.m_segments.begin(),
+                              other.m_segments.end(), begin(), byEnd);
+  while (lhs != m_segments.end() && rhs != other.m_segments.end()) {
+    auto from = std::max(lhs->begin, rhs->begin);
+    if (from < std::min(lhs->end, rhs->end)) {
+      return from;
+    }
+    if (lhs->end <= rhs->end) {
+      ++lhs;
+    } else {
+      ++rhs;
+    }
+  }
+  return kNone;
+}
+
 void Liveness::compute() {
   auto graph = m_func.getBasicBlocks();
-
   auto loopBuilder = LoopTreeBuilder<BasicBlocksGraph>();
-  m_loops = loopBuilder.build(graph);
-  m_linearNumbers = computeLinearNumbers();
-  auto linearOrder = LinearOrder(graph).linearize();
+  auto loops = loopBuilder.build(graph);
+  compute(LinearOrder(graph, loops).linearize(m_func.rpo()));
+}
+
+void Liveness::compute(const std::vector<BasicBlock *> &linearOrder) {
+  m_liveInts.assign(m_func.numValues());
+  m_liveRanges.assign(m_func.numValues());
+  m_blockInts.assign(m_func.numBlocks());
+  m_values.assign(m_func.numValues(), nullptr);
+  for (auto &&bb : m_func) {
+    for (auto &&instr : bb) {
+      m_values[instr.getId()] = &instr;
+    }
+  }
+
+  m_problem = m_compact ? buildProblem(*m_compact) : buildProblem(m_func);
+  computeLiveSets();
+  m_linearNumbers = computeLinearNumbers(linearOrder);
 
+  // Blocks in reverse: a def is reached after all of its uses and sets the
+  // start of the interval last.
   for (auto &&bbIt = linearOrder.rbegin(), itEnd = linearOrder.rend();
        bbIt != itEnd; ++bbIt) {
     auto bb = *bbIt;
-    auto live = computeInitialLiveSet(bb);
-
-    // initial live interaval for instrs
-    auto currBBInterval = m_liveInts[bb];
-    for (auto *instr : live) {
+    auto currBBInterval = m_blockInts[bb];
+    for (auto id : m_liveOut[bb]) {
+      auto *instr = m_values[id];
       m_liveInts[instr].begin = currBBInterval.begin;
       m_liveInts[instr].end =
           std::max(currBBInterval.end, m_liveInts[instr].end);
+      m_liveRanges[instr].addSegment(currBBInterval.begin, currBBInterval.end);
     }
-
-    processEachInstr(live, bb);
-
-    // remove phi's
-    for (auto *phi : bb->phis()) {
-      if (live.count(phi)) {
-        live.erase(phi);
-      }
+    // successor phis read their inputs after the last instruction
+    for (auto id : m_problem.seed[bb->getId()]) {
+      m_liveRanges[m_values[id]].addUse(currBBInterval.end - 1,
+                                        UsePosition::Any);
     }
 
-    processLoop(live, bb);
-
-    m_liveSets[bb] = live;
+    processEachInstr(bb);
+  }
+  for (auto &range : m_liveRanges) {
+    range.finish();
   }
 }
 
-void Liveness::processEachInstr(LiveSet &live, BasicBlock *bb) {
-  auto currBBInterval = m_liveInts[bb];
-  Instruction *instr = bb->terminator();
-  // FIXME: fix reverse iterator for ilist
-  while (instr != nullptr) {
-    // process output
-    m_liveInts[instr].begin = m_linearNumbers[instr];
-    m_liveInts[instr].end =
-        std::max(m_linearNumbers[instr], m_liveInts[instr].end);
-    live.erase(instr);
-
-    // process inputs
-    for (auto &&instrInputIt = instr->begin(); instrInputIt != instr->end();
-         ++instrInputIt) {
-      auto *input = *instrInputIt;
-      m_liveInts[input].begin = currBBInterval.begin;
-      m_liveInts[input].end =
-          std::max(m_linearNumbers[instr], m_liveInts[input].end);
-      live.insert(input);
+Liveness::LiveProblem Liveness::buildProblem(Function &func) {
+  auto numBlocks = func.numBlocks();
+  auto numValues = func.numValues();
+  auto problem = LiveProblem{numBlocks, numValues};
+  problem.seed.assign(numBlocks, LiveSet(numValues));
+
+  for (auto &&bb : func) {
+    auto &uses = problem.gen[bb.getId()];
+    auto &defs = problem.kill[bb.getId()];
+    for (auto &&instr : bb) {
+      defs.set(instr.getId());
+      if (instr.getOpcode() == Opcode::PHI) {
+        continue;
+      }
+      // in SSA a value of the block is defined before its uses here
+      for (auto *input : instr) {
+        if (!defs.test(input->getId())) {
+          uses.set(input->getId());
+        }
+      }
+    }
+    for (auto *phi : bb.phis()) {
+      for (auto &&[pred, value] : *phi) {
+        problem.seed[pred->getId()].set(value->getId());
+      }
     }
-
-    instr = static_cast<Instruction *>(instr->getPrev());
   }
+  return problem;
 }
 
-void Liveness::processLoop(LiveSet &live, BasicBlock *bb) {
-  auto loop = m_loops.getLoop(bb);
-  if (loop && loop->getHeader() == bb) {
-    auto currBBInterval = m_liveInts[bb];
-    std::size_t loopEnd = 0;
-    for (auto *block : loop->getNodes()) {
-      loopEnd = std::max(m_liveInts[block].end, loopEnd);
-    }
-
-    for (auto *vreg : live) {
-      m_liveInts[vreg].begin =
-          std::min(currBBInterval.begin, m_liveInts[vreg].begin);
-      m_liveInts[vreg].end = std::max(loopEnd, m_liveInts[vreg].end);
+Liveness::LiveProblem Liveness::buildProblem(const CompactFunction &func) {
+  auto numBlocks = func.numBlockIds();
+  auto numValues = func.numValues();
+  auto problem = LiveProblem{numBlocks, numValues};
+  problem.seed.assign(numBlocks, LiveSet(numValues));
+
+  for (Handle bb = 0; bb < func.numBlocks(); ++bb) {
+    auto &uses = problem.gen[func.getBlockId(bb)];
+    auto &defs = problem.kill[func.getBlockId(bb)];
+    for (auto i = func.blockBegin(bb), end = func.blockEnd(bb); i != end;
+         ++i) {
+      auto instr = func.instr(i);
+      defs.set(instr.getId());
+      if (instr.getOpcode() == Opcode::PHI) {
+        auto preds = func.blockOperands(i);
+        auto values = func.operands(i);
+        for (std::size_t idx = 0; idx < values.size(); ++idx) {
+          problem.seed[func.getBlockId(preds[idx])].set(
+              func.getId(values[idx]));
+        }
+        continue;
+      }
+      for (auto input : func.operands(i)) {
+        auto id = func.getId(input);
+        if (!defs.test(id)) {
+          uses.set(id);
+        }
+      }
     }
   }
+  return problem;
 }
 
-Liveness::LiveSet Liveness::computeInitialLiveSet(BasicBlock *bb) {
-  LiveSet live;
-  auto successors = bb->successors();
-  for (auto *succ : successors) {
-    auto liveSet = m_liveSets[succ];
-    for (auto *vreg : liveSet) {
-      live.insert(vreg);
-    }
+// live-out = phi uses + live-in of the successors
+// live-in = uses + (live-out - defs)
+void Liveness::computeLiveSets() {
+  auto graph = m_func.getBasicBlocks();
+  auto solver = DataflowSolver<BasicBlocksGraph, LiveProblem>{m_problem};
+  solver.solve(graph);
+  m_liveIn.assign(m_func.numBlocks());
+  m_liveOut.assign(m_func.numBlocks());
+  for (auto &&bb : m_func) {
+    m_liveIn[&bb] = std::move(solver.getIn(&bb));
+    m_liveOut[&bb] = std::move(solver.getOut(&bb));
+  }
+}
 
-    for (auto *phi : succ->phis()) {
-      for (auto &&arg : *phi) {
-        if (arg.first->getId() == bb->getId()) {
-          live.insert(arg.second);
-        }
+void Liveness::processEachInstr(BasicBlock *bb) {
+  auto currBBInterval = m_blockInts[bb];
+  for (auto it = bb->rbegin(), itEnd = bb->rend(); it != itEnd; ++it) {
+    auto *instr = &*it;
+    // process output
+    auto pos = m_linearNumbers[instr];
+    m_liveInts[instr].begin = pos;
+    m_liveInts[instr].end = std::max(pos, m_liveInts[instr].end);
+    m_liveRanges[instr].setBegin(pos);
+
+    // process inputs, phi inputs are live-out of predecessors
+    if (instr->getOpcode() != Opcode::PHI) {
+      for (auto &&instrInputIt = instr->begin(); instrInputIt != instr->end();
+           ++instrInputIt) {
+        auto *input = *instrInputIt;
+        m_liveInts[input].begin = currBBInterval.begin;
+        m_liveInts[input].end = std::max(pos, m_liveInts[input].end);
+        m_liveRanges[input].addSegment(currBBInterval.begin, pos + 1);
+        m_liveRanges[input].addUse(pos, UsePosition::Register);
       }
     }
   }
-
-  return live;
 }
 
-Liveness::LinearNumbers Liveness::computeLinearNumbers() {
-  auto ret = LinearNumbers{};
-  auto graph = m_func.getBasicBlocks();
-  auto linOrder = LinearOrder(graph);
-  auto linearOrder = linOrder.linearize();
+Liveness::LinearNumbers
+Liveness::computeLinearNumbers(const std::vector<BasicBlock *> &linearOrder) {
+  auto ret = LinearNumbers(m_func.numValues());
 
   std::size_t step = 2;
   std::size_t currentBBLive = 0;
@@ -140,7 +245,7 @@ Liveness::LinearNumbers Liveness::computeLinearNumbers() {
         ret[&instr] = currentBBLive;
       }
     }
-    m_liveInts[bb] = {currentBBLive, currentInstLive};
+    m_blockInts[bb] = {currentBBLive, currentInstLive};
     currentBBLive = currentInstLive;
   }
   return ret;
@@ -1,12 +1,17 @@
 #pragma once
 
 #include "IR.hh"
+#include "bitVector.hh"
+#include "compact.hh"
+#include "dataflow.hh"
 #include "function.hh"
 #include "graph.hh"
-#include "loopAnalyser.hh"
+#include "valueMap.hh"
+#include <algorithm>
+#include <cassert>
+#include <limits>
 #include <ostream>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 namespace jade {
@@ -30,38 +35,132 @@ inline std::ostream &operator<<(std::ostream &out, LiveIn lin) {
   return out;
 }
 
+// Where a value is read and whether the reader needs it in a register.
+struct UsePosition {
+  enum Kind {
+    Register,
+    // phi inputs: moved at the end of the predecessor, a stack slot does
+    Any,
+  };
+
+  std::size_t pos;
+  Kind kind;
+};
+
+// Linear positions where a value is live: disjoint half-open segments
+// sorted by start, with lifetime holes between them where the value is
+// dead, as in a loop it is not used in. A def at pos starts the range at
+// pos, a use at pos keeps it live up to pos + 1.
+class LiveRange {
+public:
+  struct Segment {
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  static constexpr std::size_t kNone = std::numeric_limits<std::size_t>::max();
+
+  const std::vector<Segment> &segments() const { return m_segments; }
+  // sorted by position
+  const std::vector<UsePosition> &uses() const { return m_uses; }
+  bool empty() const { return m_segments.empty(); }
+  std::size_t begin() const { return m_segments.front().begin; }
+  std::size_t end() const { return m_segments.back().end; }
+
+  bool covers(std::size_t pos) const {
+    auto it = std::upper_bound(
+        m_segments.begin(), m_segments.end(), pos,
+        [](std::size_t pos, const Segment &seg) { return pos < seg.begin; });
+    return it != m_segments.begin() && pos < std::prev(it)->end;
+  }
+  bool intersects(const LiveRange &other) const {
+    return firstIntersection(other) != kNone;
+  }
+  // first position both ranges cover, kNone when there is none
+  std::size_t firstIntersection(const LiveRange &other) const;
+
+private:
+  friend class Liveness;
+
+  // Ranges are built from the last position to the first: segments and
+  // uses are added at the back in decreasing order, then reversed.
+  void addSegment(std::size_t begin, std::size_t end);
+  // a def shortens the segment reaching it
+  void setBegin(std::size_t pos);
+  void addUse(std::size_t pos, UsePosition::Kind kind) {
+    m_uses.push_back({pos, kind});
+  }
+  void finish();
+
+  std::vector<Segment> m_segments;
+  std::vector<UsePosition> m_uses;
+};
+
 class Liveness {
 public:
   using Traits = GraphTraits<BasicBlocksGraph>;
-  using LiveSet = std::unordered_set<Instruction *>;
-  using LiveIntervals = std::unordered_map<Value *, LiveIn>;
+  // value ids
+  using LiveSet = BitVector;
+  using LiveIntervals = ValueMap<LiveIn>;
+  // Backward union of live values: gen holds the values a block reads
+  // before any def, phi inputs excluded, kill its defs, phis included, and
+  // seed the inputs of successor phis coming along the edges out of it.
+  using LiveProblem =
+      BitVectorProblem<BasicBlocksGraph, DataflowDirection::Backward>;
+
+  // The dataflow problem compute() solves for the live sets of func.
+  static LiveProblem buildProblem(Function &func);
+  // Same from a snapshot of the function, reading its tables only.
+  static LiveProblem buildProblem(const CompactFunction &func);
 
   Liveness(Function &func) : m_func{func} {}
+  // compute() builds the problem from compact, a current snapshot of func.
+  Liveness(Function &func, const CompactFunction &compact)
+      : m_func{func}, m_compact{&compact} {}
+  Liveness(const Liveness &) = delete;
+  Liveness &operator=(const Liveness &) = delete;
 
   void compute();
+  // Same from a linear order of the function the caller already has.
+  void compute(const std::vector<BasicBlock *> &linearOrder);
 
   std::size_t getLinearNumber(Instruction *instr) const {
     return m_linearNumbers.at(instr);
   }
 
-  LiveIn getLiveInterval(Value *val) const { return m_liveInts.at(val); }
+  LiveIn getLiveInterval(Instruction *instr) const {
+    return m_liveInts.at(instr);
+  }
+  LiveIn getLiveInterval(BasicBlock *bb) const { return m_blockInts.at(bb); }
   LiveIntervals const &getLiveIntervals() const { return m_liveInts; }
+  const LiveRange &getLiveRange(Instruction *instr) const {
+    return m_liveRanges.at(instr);
+  }
+
+  // Values live on entry to bb, its phis excluded, and on exit from it.
+  // Empty for unreachable blocks.
+  const LiveSet &getLiveIn(BasicBlock *bb) const { return m_liveIn.at(bb); }
+  const LiveSet &getLiveOut(BasicBlock *bb) const { return m_liveOut.at(bb); }
 
 private:
-  using LinearNumbers = std::unordered_map<Instruction *, std::size_t>;
-  using LiveSets = std::unordered_map<BasicBlock *, LiveSet>;
-  using LoopAnalyser = LoopTree<BasicBlocksGraph>;
+  using LinearNumbers = ValueMap<std::size_t>;
+  using LiveSets = BlockMap<LiveSet>;
 
   Function &m_func;
+  const CompactFunction *m_compact{nullptr};
   LinearNumbers m_linearNumbers;
-  LiveSets m_liveSets;
+  LiveProblem m_problem;
+  LiveSets m_liveIn;
+  LiveSets m_liveOut;
+  // instruction of every value id
+  std::vector<Instruction *> m_values;
   LiveIntervals m_liveInts;
-  LoopAnalyser m_loops;
+  ValueMap<LiveRange> m_liveRanges;
+  BlockMap<LiveIn> m_blockInts;
 
-  LinearNumbers computeLinearNumbers();
-  LiveSet computeInitialLiveSet(BasicBlock *bb);
-  void processEachInstr(LiveSet &live, BasicBlock *bb);
-  void processLoop(LiveSet &live, BasicBlock *bb);
+  LinearNumbers computeLinearNumbers(const std::vector<BasicBlock *> &order);
+  void computeLiveSets();
+  void processEachInstr(BasicBlock *bb);
 };
 
 } // namespace jade
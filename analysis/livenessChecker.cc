@@ -0,0 +1,189 @@
+#include "livenessChecker.hh"
+#include "opcodes.hh"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace jade {
+
+LivenessChecker::LivenessChecker(Function &func,
+                                 const DomTree<BasicBlocksGraph> &domTree)
+    : m_func{func}, m_domTree{domTree}, m_cfgEpoch{func.getCFGEpoch()} {
+  computeReachability();
+  for (auto &&[src, dst] : m_backEdges) {
+    m_reducible &= m_domTree.dominate(dst, src);
+  }
+  if (m_reducible) {
+    computeLoopHeaders();
+  }
+}
+
+// Iterative DFS from the entry: an edge to a block still on the stack is a
+// back edge. Blocks are done in postorder, after all of the blocks they
+// reach through other edges, so R of a block is the union of R of those
+// successors.
+void LivenessChecker::computeReachability() {
+  auto numBlocks = m_func.numBlocks();
+  m_reduced.assign(numBlocks);
+  if (m_func.begin() == m_func.end()) {
+    return;
+  }
+
+  using SuccIt = decltype(std::declval<BasicBlock &>().successors().begin());
+  // 0: not seen, 1: on the stack, 2: done
+  std::vector<char> state(numBlocks, 0);
+  std::vector<std::pair<BasicBlock *, SuccIt>> stack;
+  auto push = [&](BasicBlock *bb) {
+    state[bb->getId()] = 1;
+    m_reduced[bb].resize(numBlocks);
+    m_reduced[bb].set(bb->getId());
+    stack.emplace_back(bb, bb->successors().begin());
+  };
+  push(&*m_func.begin());
+  while (!stack.empty()) {
+    auto &[bb, succIt] = stack.back();
+    if (succIt == bb->successors().end()) {
+      for (auto *succ : bb->successors()) {
+        if (state[succ->getId()] == 2) {
+          m_reduced[bb].unionWith(m_reduced[succ]);
+        }
+      }
+      state[bb->getId()] = 2;
+      stack.pop_back();
+      continue;
+    }
+    auto *succ = *succIt++;
+    if (state[succ->getId()] == 1) {
+      m_backEdges.emplace_back(bb, succ);
+    } else if (state[succ->getId()] == 0) {
+      push(succ);
+    }
+  }
+}
+
+// The loop of header t is what reaches the sources of its back edges
+// without passing t, a walk over preds from them. In a reducible CFG this
+// is all of T.
+void LivenessChecker::computeLoopHeaders() {
+  m_headers.assign(m_func.numBlocks());
+  std::sort(m_backEdges.begin(), m_backEdges.end(),
+            [](auto &lhs, auto &rhs) {
+              return lhs.second->getId() < rhs.second->getId();
+            });
+  // header the block was last added to the loop of
+  std::vector<BasicBlock *> seen(m_func.numBlocks(), nullptr);
+  std::vector<BasicBlock *> worklist;
+  for (auto &&[src, header] : m_backEdges) {
+    seen[header->getId()] = header;
+    if (seen[src->getId()] != header) {
+      seen[src->getId()] = header;
+      worklist.push_back(src);
+    }
+    while (!worklist.empty()) {
+      auto *bb = worklist.back();
+      worklist.pop_back();
+      m_headers[bb].push_back(header);
+      for (auto *pred : bb->predecessors()) {
+        // unreachable preds are outside of every loop
+        if (seen[pred->getId()] != header && m_domTree.isReachable(pred)) {
+          seen[pred->getId()] = header;
+          worklist.push_back(pred);
+        }
+      }
+    }
+  }
+}
+
+template <typename Fn>
+bool LivenessChecker::anyUseBlock(Instruction *value, Fn &&fn) const {
+  for (auto *user : value->users()) {
+    if (user->getOpcode() != Opcode::PHI) {
+      if (fn(user->getParent())) {
+        return true;
+      }
+      continue;
+    }
+    for (auto &&[pred, input] : *static_cast<PhiInstr *>(user)) {
+      if (input == value && fn(pred)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool LivenessChecker::isLiveIn(Instruction *value, BasicBlock *bb) const {
+  assert(m_cfgEpoch == m_func.getCFGEpoch() && "the CFG changed");
+  auto *def = value->getParent();
+  if (!m_domTree.strictlyDominate(def, bb)) {
+    return false;
+  }
+  if (!m_reducible) {
+    return isLiveInWalk(value, bb);
+  }
+  // some loop around bb, or bb itself, reaches a use without leaving def
+  auto reachesUse = [&](BasicBlock *target) {
+    if (!m_domTree.strictlyDominate(def, target)) {
+      return false;
+    }
+    auto &reduced = m_reduced.at(target);
+    return anyUseBlock(value, [&](BasicBlock *use) {
+      return reduced.test(use->getId());
+    });
+  };
+  auto &headers = m_headers.at(bb);
+  return reachesUse(bb) ||
+         std::any_of(headers.begin(), headers.end(), reachesUse);
+}
+
+bool LivenessChecker::isLiveOut(Instruction *value, BasicBlock *bb) const {
+  auto *def = value->getParent();
+  if (!m_domTree.isReachable(bb) || !m_domTree.dominate(def, bb)) {
+    return false;
+  }
+  for (auto *succ : bb->successors()) {
+    if (isLiveIn(value, succ)) {
+      return true;
+    }
+    for (auto *phi : succ->phis()) {
+      for (auto &&[pred, input] : *phi) {
+        if (pred == bb && input == value) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+// Backwards from the uses, def stops the walk.
+bool LivenessChecker::isLiveInWalk(Instruction *value, BasicBlock *bb) const {
+  auto *def = value->getParent();
+  auto visited = BitVector(m_func.numBlocks());
+  std::vector<BasicBlock *> worklist;
+  auto visit = [&](BasicBlock *block) {
+    if (block == bb) {
+      return true;
+    }
+    if (block != def && m_domTree.isReachable(block) &&
+        visited.insert(block->getId())) {
+      worklist.push_back(block);
+    }
+    return false;
+  };
+  if (anyUseBlock(value, visit)) {
+    return true;
+  }
+  while (!worklist.empty()) {
+    auto *block = worklist.back();
+    worklist.pop_back();
+    for (auto *pred : block->predecessors()) {
+      if (visit(pred)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace jade
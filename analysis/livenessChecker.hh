@@ -0,0 +1,57 @@
+#pragma once
+
+#include "IR.hh"
+#include "bitVector.hh"
+#include "domTree.hh"
+#include "function.hh"
+#include "valueMap.hh"
+#include <cstdint>
+#include <vector>
+
+namespace jade {
+
+// Answers "is v live-in / live-out at b" without computing live sets, after
+// Boissinot et al., Fast Liveness Checking for SSA-Form Programs. The
+// precomputation only looks at the CFG:
+// - R[b]: blocks b reaches without taking a DFS back edge,
+// - T[b]: b and the headers of the loops around it.
+// v defined in d is live-in at q iff d strictly dominates q and, for some t
+// in T[q] that d strictly dominates, R[t] holds a block using v. A query
+// costs a walk over the uses of v per loop around q.
+//
+// Uses are read at query time, so the checker stays valid across any edit
+// of instructions; an edit of the CFG needs a new checker and a new
+// dominator tree. Irreducible CFGs break the characterization: there a
+// query walks backwards from the uses instead.
+class LivenessChecker {
+public:
+  LivenessChecker(Function &func, const DomTree<BasicBlocksGraph> &domTree);
+
+  // phis of bb are not live-in of it, their inputs are live-out of the
+  // predecessors
+  bool isLiveIn(Instruction *value, BasicBlock *bb) const;
+  bool isLiveOut(Instruction *value, BasicBlock *bb) const;
+
+  bool isReducible() const { return m_reducible; }
+
+private:
+  void computeReachability();
+  void computeLoopHeaders();
+
+  // Calls fn with the block of every use of value: the block of the user,
+  // or the incoming block for a phi. Stops when fn returns true.
+  template <typename Fn> bool anyUseBlock(Instruction *value, Fn &&fn) const;
+  bool isLiveInWalk(Instruction *value, BasicBlock *bb) const;
+
+  Function &m_func;
+  const DomTree<BasicBlocksGraph> &m_domTree;
+  std::uint64_t m_cfgEpoch;
+  // R by block id, back edges come from a DFS of the entry
+  BlockMap<BitVector> m_reduced;
+  // T by block id, the block itself left out
+  BlockMap<std::vector<BasicBlock *>> m_headers;
+  std::vector<std::pair<BasicBlock *, BasicBlock *>> m_backEdges;
+  bool m_reducible{true};
+};
+
+} // namespace jade
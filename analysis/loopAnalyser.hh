@@ -1,10 +1,12 @@
 #pragma once
 
+#include "bitVector.hh"
+#include "denseMap.hh"
 #include "domTree.hh"
 #include "graph.hh"
+#include "smallPtrSet.hh"
 #include <iostream>
 #include <ostream>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -33,13 +35,16 @@ public:
 
   auto backEdgesEnd() const { return m_backEdges.end(); }
 
-  auto getBackEdges() const { return m_backEdges; }
+  const auto &getBackEdges() const { return m_backEdges; }
 
-  auto getNodes() const { return m_nodes; }
+  // blocks of the loop body in discovery order
+  const std::vector<NodeTy> &getNodes() const { return m_nodes; }
 
-  bool contains(NodeTy node) const { return m_nodes.count(node); }
+  bool contains(NodeTy node) const {
+    return m_members.count(Traits::id(node));
+  }
 
-  auto getInners() const { return m_inners; }
+  const auto &getInners() const { return m_inners; }
 
 private:
   void insertInnerLoop(LoopTreeNode *node) { m_inners.insert(node); }
@@ -47,11 +52,15 @@ private:
   void setOuter(LoopTreeNode *node) { m_outer = node; }
 
   void addBackEdge(NodeTy node) {
-    m_nodes.insert(node);
+    insertNode(node);
     m_backEdges.insert(node);
   }
 
-  void insertNode(NodeTy node) { m_nodes.insert(node); }
+  void insertNode(NodeTy node) {
+    if (m_members.insert(Traits::id(node))) {
+      m_nodes.push_back(node);
+    }
+  }
 
   void addReducibility(bool isReducible) { m_isReducible = isReducible; }
 
@@ -76,10 +85,12 @@ private:
   friend LoopTreeBuilder<GraphTy>;
 
   NodeTy m_header;
-  std::set<NodeTy> m_backEdges;
-  std::set<NodeTy> m_nodes;
+  SmallPtrSet<NodeTy, 2> m_backEdges;
+  std::vector<NodeTy> m_nodes;
+  // ids of m_nodes
+  SparseBitVector m_members;
   LoopTreeNode *m_outer{nullptr};
-  std::set<LoopTreeNode *> m_inners;
+  SmallPtrSet<LoopTreeNode *, 4> m_inners;
 
   bool m_isReducible{false};
 };
@@ -90,7 +101,10 @@ public:
   using Traits = GraphTraits<GraphTy>;
   using NodeTy = typename Traits::NodeTy;
 
-  LoopTreeNodeTy *getLoop(NodeTy node) { return m_nodesMap[node]; }
+  // innermost loop of node, nullptr outside of loops
+  LoopTreeNodeTy *getLoop(NodeTy node) const {
+    return m_nodesMap.lookupOr(node, nullptr);
+  }
 
   void dump(std::ostream &out) const {
     for (auto &&loop : m_arena) {
@@ -102,7 +116,7 @@ private:
   friend LoopTreeBuilder<GraphTy>;
 
   std::vector<LoopTreeNodeTy> m_arena;
-  std::unordered_map<NodeTy, LoopTreeNodeTy *> m_nodesMap;
+  DenseMap<NodeTy, LoopTreeNodeTy *> m_nodesMap;
 };
 
 template <typename GraphTy> class LoopTreeBuilder final {
@@ -115,20 +129,23 @@ public:
   using DomTreeTy = DomTree<GraphTy>;
 
   LoopTreeTy build(GraphTy &G);
+  // Same with a dominator tree of G the caller already has.
+  LoopTreeTy build(GraphTy &G, const DomTreeTy &domTree);
 
 private:
   void init(GraphTy &G);
-  void collectBackEdges(NodeTy node);
+  void collectBackEdges(NodeTy root);
   void populate(GraphTy &G);
-  void populateInner(LoopTreeNodeTy *loop, NodeTy node);
-  LoopTreeTy finalize(GraphTy &G);
+  void populateInner(LoopTreeNodeTy *loop, NodeTy start);
+  LoopTreeTy finalize();
 
-  using ColorMap = std::unordered_map<NodeTy, Gcolor>;
+  using ColorMap = DenseMap<NodeTy, Gcolor>;
 
 private:
-  DomTreeTy m_domTree;
+  DomTreeTy m_ownDomTree;
+  const DomTreeTy *m_domTree{nullptr};
   ColorMap m_colors;
-  std::unordered_map<NodeTy, LoopTreeNodeTy *> m_loopsMap;
+  DenseMap<NodeTy, LoopTreeNodeTy *> m_loopsMap;
   std::vector<LoopTreeNodeTy> m_arena;
   std::vector<NodeTy> m_dfsNodes;
 };
@@ -136,43 +153,56 @@ private:
 template <typename GraphTy> void LoopTreeBuilder<GraphTy>::init(GraphTy &G) {
   m_arena.reserve(Traits::nodesCount(G));
   m_dfsNodes.reserve(Traits::nodesCount(G));
+  m_colors.reserve(Traits::nodesCount(G));
 }
 
 template <typename GraphTy>
 typename LoopTreeBuilder<GraphTy>::LoopTreeTy
 LoopTreeBuilder<GraphTy>::build(GraphTy &G) {
-  init(G);
-
   auto domTreeBuilder = DominatorTreeBuilder<GraphTy>();
-  m_domTree = domTreeBuilder.build(G);
+  m_ownDomTree = domTreeBuilder.build(G);
+  return build(G, m_ownDomTree);
+}
+
+template <typename GraphTy>
+typename LoopTreeBuilder<GraphTy>::LoopTreeTy
+LoopTreeBuilder<GraphTy>::build(GraphTy &G, const DomTreeTy &domTree) {
+  init(G);
+  m_domTree = &domTree;
 
   collectBackEdges(Traits::entry(G));
   populate(G);
-  return finalize(G);
+  return finalize();
 }
 
 template <typename GraphTy>
 typename LoopTreeBuilder<GraphTy>::LoopTreeTy
-LoopTreeBuilder<GraphTy>::finalize(GraphTy &G) {
+LoopTreeBuilder<GraphTy>::finalize() {
   auto res = LoopTreeTy{};
   res.m_arena = std::move(m_arena);
   res.m_nodesMap = std::move(m_loopsMap);
-  for (auto nodeIt = Traits::nodesBegin(G); nodeIt != Traits::nodesEnd(G);
-       ++nodeIt) {
-    if (res.m_nodesMap.find(&*nodeIt) == res.m_nodesMap.end()) {
-      res.m_nodesMap[&*nodeIt] = nullptr;
-    }
-  }
   return res;
 }
 
+// Iterative DFS: nodes are GRAY while on the stack, an edge into a GRAY node
+// closes a loop. m_dfsNodes gets the nodes in post order.
 template <typename GraphTy>
-void LoopTreeBuilder<GraphTy>::collectBackEdges(NodeTy node) {
-  m_colors[node] = Gcolor::GRAY;
+void LoopTreeBuilder<GraphTy>::collectBackEdges(NodeTy root) {
+  std::vector<std::pair<NodeTy, EdgesItTy>> stack;
+  m_colors[root] = Gcolor::GRAY;
+  stack.emplace_back(root, Traits::outEdgeBegin(root));
+
+  while (!stack.empty()) {
+    auto &[node, it] = stack.back();
+    if (it == Traits::outEdgeEnd(node)) {
+      m_colors[node] = Gcolor::BLACK;
+      m_dfsNodes.push_back(node);
+      stack.pop_back();
+      continue;
+    }
 
-  for (auto it = Traits::outEdgeBegin(node); it != Traits::outEdgeEnd(node);
-       ++it) {
     NodeTy nextNode = *it;
+    ++it;
     if (m_colors[nextNode] == Gcolor::GRAY) {
       auto loopIt = m_loopsMap.find(nextNode);
       if (loopIt == m_loopsMap.end()) {
@@ -180,17 +210,15 @@ void LoopTreeBuilder<GraphTy>::collectBackEdges(NodeTy node) {
         m_loopsMap.insert({nextNode, &(m_arena.back())});
       }
 
-      auto isReducible = m_domTree.dominate(nextNode, node);
+      auto isReducible = m_domTree->dominate(nextNode, node);
       auto &loop = m_loopsMap[nextNode];
       loop->addReducibility(isReducible);
       loop->addBackEdge(node);
     } else if (m_colors[nextNode] != Gcolor::BLACK) {
-      collectBackEdges(nextNode);
+      m_colors[nextNode] = Gcolor::GRAY;
+      stack.emplace_back(nextNode, Traits::outEdgeBegin(nextNode));
     }
   }
-
-  m_colors[node] = Gcolor::BLACK;
-  m_dfsNodes.push_back(node);
 }
 
 template <typename GraphTy>
@@ -224,27 +252,33 @@ void LoopTreeBuilder<GraphTy>::populate(GraphTy &G) {
   }
 }
 
+// Walks predecessors up from a back edge source until the header (BLACK).
 template <typename GraphTy>
 void LoopTreeBuilder<GraphTy>::populateInner(LoopTreeNodeTy *loop,
-                                             NodeTy node) {
-  if (m_colors[node] == Gcolor::BLACK) {
-    return;
-  }
+                                             NodeTy start) {
+  std::vector<NodeTy> worklist{start};
+  while (!worklist.empty()) {
+    auto node = worklist.back();
+    worklist.pop_back();
+    if (m_colors[node] == Gcolor::BLACK) {
+      continue;
+    }
 
-  m_colors[node] = Gcolor::BLACK;
-  auto nodeLoopIt = m_loopsMap.find(node);
-  if (nodeLoopIt == m_loopsMap.end()) {
-    loop->insertNode(node);
-    m_loopsMap[node] = loop;
-  } else if (loop != nodeLoopIt->second &&
-             nodeLoopIt->second->getOuter() == nullptr) {
-    nodeLoopIt->second->setOuter(loop);
-    loop->insertInnerLoop(nodeLoopIt->second);
-  }
+    m_colors[node] = Gcolor::BLACK;
+    auto nodeLoopIt = m_loopsMap.find(node);
+    if (nodeLoopIt == m_loopsMap.end()) {
+      loop->insertNode(node);
+      m_loopsMap[node] = loop;
+    } else if (loop != nodeLoopIt->second &&
+               nodeLoopIt->second->getOuter() == nullptr) {
+      nodeLoopIt->second->setOuter(loop);
+      loop->insertInnerLoop(nodeLoopIt->second);
+    }
 
-  auto predIt = Traits::inEdgeBegin(node);
-  for (; predIt != Traits::inEdgeEnd(node); ++predIt) {
-    populateInner(loop, *predIt);
+    auto predIt = Traits::inEdgeBegin(node);
+    for (; predIt != Traits::inEdgeEnd(node); ++predIt) {
+      worklist.push_back(*predIt);
+    }
   }
 }
 
@@ -3,6 +3,7 @@
 #include "IR.hh"
 #include "function.hh"
 #include "liveness.hh"
+#include "valueMap.hh"
 
 #include <array>
 #include <functional>
@@ -29,7 +30,7 @@ private:
   Function &m_func;
 
   std::vector<LiveIn> m_intervals;
-  std::vector<Value *> m_instructions;
+  std::vector<Instruction *> m_instructions;
   // sorted intervals
   std::vector<std::size_t> m_indicies;
 
@@ -64,7 +65,7 @@ private:
 
   std::vector<std::size_t> m_freeRegs;
 
-  std::unordered_map<Value *, Location> m_allocInfo;
+  ValueMap<Location> m_allocInfo;
   std::size_t m_stackLocation;
 
 public:
@@ -85,21 +86,24 @@ template <std::size_t RegNum> void RegAlloc<RegNum>::init() {
 
   m_intervals.reserve(liveIntervals.size());
   m_instructions.reserve(liveIntervals.size());
-
-  for (auto &&[value, interval] : liveIntervals) {
-    if (value->is_vreg()) {
-      m_intervals.push_back(interval);
-      m_instructions.push_back(value);
+  m_allocInfo.assign(m_func.numValues());
+
+  for (auto &&bb : m_func.getBasicBlocks().nodes()) {
+    for (auto &&instr : bb) {
+      if (instr.is_vreg()) {
+        m_intervals.push_back(liveIntervals.at(&instr));
+        m_instructions.push_back(&instr);
+      }
     }
   }
   m_indicies.resize(m_intervals.size());
 
   std::iota(m_indicies.begin(), m_indicies.end(), 0);
-  std::sort(m_indicies.begin(), m_indicies.end(),
-            [this](std::size_t lhs, std::size_t rhs) {
-              return this->m_intervals[lhs].begin <
-                     this->m_intervals[rhs].begin;
-            });
+  std::stable_sort(m_indicies.begin(), m_indicies.end(),
+                   [this](std::size_t lhs, std::size_t rhs) {
+                     return this->m_intervals[lhs].begin <
+                            this->m_intervals[rhs].begin;
+                   });
 }
 
 template <std::size_t RegNum> void RegAlloc<RegNum>::run() {
@@ -158,7 +162,8 @@ void RegAlloc<RegNum>::spillAtInterval(std::size_t i) {
 template <std::size_t RegNum>
 void RegAlloc<RegNum>::dumpAllocInfo(std::ostream &out) {
   out << "alloc info: " << std::endl;
-  for (auto &&[value, location] : m_allocInfo) {
+  for (auto *value : m_instructions) {
+    auto &&location = m_allocInfo.at(value);
     out << value->getName() << " location idx: " << location.idx
         << " on stask: " << location.on_stack << std::endl;
   }
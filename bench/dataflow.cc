@@ -0,0 +1,184 @@
+// Live sets on large SSA functions: the generic DataflowSolver against the
+// round-robin postorder iteration Liveness used before, on the same
+// gen/kill sets, and a whole Liveness::compute for scale. Then the gen/kill
+// sets themselves, from the instruction lists and from a CompactFunction.
+#include "dataflow.hh"
+#include "IR.hh"
+#include "compact.hh"
+#include "domTree.hh"
+#include "function.hh"
+#include "liveness.hh"
+#include "randomIR.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace jade;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using LiveProblem = Liveness::LiveProblem;
+
+// Liveness before the solver: postorder rounds until nothing changes.
+std::size_t roundRobin(Function &function, const LiveProblem &problem,
+                       std::vector<BitVector> &liveIn) {
+  auto numValues = function.numValues();
+  liveIn.assign(function.numBlocks(), BitVector(numValues));
+  auto liveOut = std::vector<BitVector>(function.numBlocks(),
+                                        BitVector(numValues));
+  auto through = BitVector(numValues);
+  std::size_t visits = 0;
+  for (auto changed = true; changed;) {
+    changed = false;
+    for (auto *bb : function.postOrder()) {
+      auto id = bb->getId();
+      ++visits;
+      liveOut[id].unionWith(problem.seed[id]);
+      for (auto *succ : bb->successors()) {
+        liveOut[id].unionWith(liveIn[succ->getId()]);
+      }
+      through = liveOut[id];
+      through.subtract(problem.kill[id]);
+      through.unionWith(problem.gen[id]);
+      changed |= liveIn[id].unionWith(through);
+    }
+  }
+  return visits;
+}
+
+template <typename Fn> double bestOf(int rounds, Fn &&fn) {
+  double best = 0;
+  for (int round = 0; round < rounds; ++round) {
+    auto start = Clock::now();
+    fn();
+    auto elapsed =
+        std::chrono::duration<double, std::milli>(Clock::now() - start);
+    best = round == 0 ? elapsed.count() : std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+// Long blocks of adds over the values of the block and its nearest
+// dominators: the gen/kill scan dominates building the problem.
+void fillLongBlocks(Function &function,
+                    const DomTree<BasicBlocksGraph> &domTree,
+                    std::size_t perBlock, std::mt19937 &gen) {
+  for (auto *bb : function.rpo()) {
+    auto values = available(domTree, bb, 2);
+    values.push_back(bb->create<ConstI64>(1));
+    for (std::size_t i = 0; i < perBlock; ++i) {
+      values.push_back(bb->create<BinaryOp>(pick(values, gen),
+                                            pick(values, gen), Opcode::ADD));
+    }
+  }
+}
+
+bool sameProblem(const LiveProblem &lhs, const LiveProblem &rhs) {
+  return lhs.gen == rhs.gen && lhs.kill == rhs.kill && lhs.seed == rhs.seed;
+}
+
+// Liveness::buildProblem walking the lists against scanning a snapshot, and
+// what building the snapshot costs.
+bool compareProblems(Function &function, int rounds) {
+  auto problem = Liveness::buildProblem(function);
+  auto walk = bestOf(rounds, [&] {
+    problem = Liveness::buildProblem(function);
+  });
+  auto compact = CompactFunction{function};
+  auto fromCompact = Liveness::buildProblem(compact);
+  auto scan = bestOf(rounds, [&] {
+    fromCompact = Liveness::buildProblem(compact);
+  });
+  auto snapshot = bestOf(rounds, [&] { CompactFunction{function}; });
+  if (!sameProblem(problem, fromCompact)) {
+    std::printf("gen/kill sets of the snapshot differ\n");
+    return false;
+  }
+  std::printf("%-8zu %8zu %8.2f %8.2f %9.2f\n", function.numBlocks(),
+              function.numValues(), walk, scan, snapshot);
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  constexpr int kRounds = 5;
+  std::vector<std::size_t> sizes;
+  for (int i = 1; i < argc; ++i) {
+    sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+  }
+  if (sizes.empty()) {
+    sizes = {500, 2000};
+  }
+
+  std::printf("best of %d rounds, ms; block visits to the fixpoint\n",
+              kRounds);
+  std::printf("%-8s %8s %12s %8s %8s %8s %8s %10s\n", "blocks", "values",
+              "round-robin", "visits", "solver", "visits", "sweeps",
+              "liveness");
+  for (auto size : sizes) {
+    auto function = Function{};
+    makeCFG(function, size, 1);
+    auto graph = function.getBasicBlocks();
+    {
+      auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+      std::mt19937 gen(2);
+      fillBody(function, domTree, gen);
+    }
+    auto problem = Liveness::buildProblem(function);
+
+    std::vector<BitVector> liveIn;
+    std::size_t rrVisits = 0;
+    auto rr = bestOf(kRounds, [&] {
+      rrVisits = roundRobin(function, problem, liveIn);
+    });
+    auto solver = DataflowSolver<BasicBlocksGraph, LiveProblem>{problem};
+    auto solve = bestOf(kRounds, [&] { solver.solve(graph); });
+    auto full = bestOf(kRounds, [&] {
+      auto liveness = Liveness{function};
+      liveness.compute();
+    });
+
+    for (auto &bb : function) {
+      if (!(solver.getIn(&bb) == liveIn[bb.getId()])) {
+        std::printf("live-in of block %zu differs\n", bb.getId());
+        return 1;
+      }
+    }
+    std::printf("%-8zu %8zu %12.2f %8zu %8.2f %8zu %8zu %10.2f\n", size,
+                function.numValues(), rr, rrVisits, solve, solver.numVisits(),
+                solver.numSweeps(), full);
+  }
+
+  std::printf("\ngen/kill sets, ms: list walk, snapshot scan and build\n");
+  std::printf("%-8s %8s %8s %8s %9s\n", "blocks", "values", "walk", "scan",
+              "snapshot");
+  for (auto size : sizes) {
+    auto function = Function{};
+    makeCFG(function, size, 1);
+    auto graph = function.getBasicBlocks();
+    auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+    std::mt19937 gen(2);
+    fillBody(function, domTree, gen);
+    if (!compareProblems(function, kRounds)) {
+      return 1;
+    }
+  }
+  for (std::size_t perBlock : {200, 1000}) {
+    auto function = Function{};
+    makeCFG(function, 200, 1);
+    auto graph = function.getBasicBlocks();
+    auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+    std::mt19937 gen(3);
+    fillLongBlocks(function, domTree, perBlock, gen);
+    if (!compareProblems(function, kRounds)) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,113 @@
+// DenseMap against std::unordered_map on pointer keys, the way the analyses
+// use them: build once, look up a lot, erase a part.
+#include "denseMap.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace jade;
+
+namespace {
+
+struct Node {
+  std::size_t payload[4];
+};
+
+using Clock = std::chrono::steady_clock;
+
+template <typename Fn> double nsPerOp(std::size_t ops, Fn &&fn) {
+  auto start = Clock::now();
+  fn();
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+  return elapsed.count() / ops;
+}
+
+struct Result {
+  double insert;
+  double hit;
+  double miss;
+  double erase;
+  std::size_t checksum;
+};
+
+template <typename MapTy>
+Result run(const std::vector<Node *> &keys, const std::vector<Node *> &probes,
+           const std::vector<Node *> &absent) {
+  Result res{};
+  MapTy map;
+  res.insert = nsPerOp(keys.size(), [&] {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      map[keys[i]] = i;
+    }
+  });
+  res.hit = nsPerOp(probes.size(), [&] {
+    for (auto *key : probes) {
+      res.checksum += map.find(key)->second;
+    }
+  });
+  res.miss = nsPerOp(absent.size(), [&] {
+    for (auto *key : absent) {
+      res.checksum += map.count(key);
+    }
+  });
+  res.erase = nsPerOp(keys.size() / 2, [&] {
+    for (std::size_t i = 0; i < keys.size(); i += 2) {
+      map.erase(keys[i]);
+    }
+  });
+  res.checksum += map.size();
+  return res;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+  constexpr int kRounds = 5;
+
+  // nodes allocated one by one, as blocks and instructions are
+  std::vector<std::unique_ptr<Node>> storage;
+  for (std::size_t i = 0; i < 2 * size; ++i) {
+    storage.push_back(std::make_unique<Node>());
+  }
+  std::vector<Node *> keys, absent;
+  for (std::size_t i = 0; i < size; ++i) {
+    keys.push_back(storage[2 * i].get());
+    absent.push_back(storage[2 * i + 1].get());
+  }
+  std::mt19937 gen(1);
+  std::vector<Node *> probes;
+  std::uniform_int_distribution<std::size_t> dist(0, size - 1);
+  for (std::size_t i = 0; i < 4 * size; ++i) {
+    probes.push_back(keys[dist(gen)]);
+  }
+
+  std::printf("%zu pointer keys, best of %d rounds, ns/op\n", size, kRounds);
+  std::printf("%-14s %8s %8s %8s %8s\n", "map", "insert", "hit", "miss",
+              "erase");
+  auto report = [&](const char *name, auto runOnce) {
+    Result best = runOnce();
+    for (int round = 1; round < kRounds; ++round) {
+      auto res = runOnce();
+      best.insert = std::min(best.insert, res.insert);
+      best.hit = std::min(best.hit, res.hit);
+      best.miss = std::min(best.miss, res.miss);
+      best.erase = std::min(best.erase, res.erase);
+    }
+    std::printf("%-14s %8.1f %8.1f %8.1f %8.1f  (checksum %zu)\n", name,
+                best.insert, best.hit, best.miss, best.erase, best.checksum);
+  };
+  report("DenseMap", [&] {
+    return run<DenseMap<Node *, std::size_t>>(keys, probes, absent);
+  });
+  report("unordered_map", [&] {
+    return run<std::unordered_map<Node *, std::size_t>>(keys, probes, absent);
+  });
+  return 0;
+}
@@ -0,0 +1,98 @@
+// Dominator tree construction on large CFG-like graphs: a chain of blocks
+// with forward branches and loop back edges, built with both algorithms,
+// and the cost of keeping a built tree up to date across edge edits.
+#include "domTree.hh"
+#include "IR.hh"
+#include "function.hh"
+#include "randomIR.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <vector>
+
+using namespace jade;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double msPerBuild(DomTreeAlgo algo, BasicBlocksGraph &graph, int rounds,
+                  std::size_t &checksum) {
+  auto builder = DominatorTreeBuilder<BasicBlocksGraph>(algo);
+  double best = 0;
+  for (int round = 0; round < rounds; ++round) {
+    auto start = Clock::now();
+    auto domTree = builder.build(graph);
+    auto elapsed =
+        std::chrono::duration<double, std::milli>(Clock::now() - start);
+    checksum += domTree.getDFSOut(domTree.getRoot());
+    best = round == 0 ? elapsed.count() : std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+// Removes and puts back random edges, updating the tree after each edit.
+double msPerUpdate(BasicBlocksGraph &graph, Function &function,
+                   std::size_t &checksum) {
+  constexpr int kEdits = 200;
+  auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+  std::vector<BasicBlock *> bbs;
+  for (auto &bb : function) {
+    bbs.push_back(&bb);
+  }
+  std::mt19937 gen(2);
+  auto start = Clock::now();
+  for (int edit = 0; edit < kEdits; ++edit) {
+    auto *from = bbs[gen() % bbs.size()];
+    // pick from the range in place: a collected copy per edit trips a
+    // -Wfree-nonheap-object false positive once inlined here
+    auto succs = from->successors();
+    auto numSuccs = std::distance(succs.begin(), succs.end());
+    if (numSuccs == 0) {
+      continue;
+    }
+    auto *to = *std::next(succs.begin(), gen() % numSuccs);
+    from->removeSuccessor(to);
+    domTree.deleteEdge(from, to);
+    from->addSuccessor(to);
+    domTree.insertEdge(from, to);
+  }
+  auto elapsed =
+      std::chrono::duration<double, std::milli>(Clock::now() - start);
+  checksum += domTree.size();
+  return elapsed.count() / (2 * kEdits);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  constexpr int kRounds = 5;
+  std::vector<std::size_t> sizes;
+  for (int i = 1; i < argc; ++i) {
+    sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+  }
+  if (sizes.empty()) {
+    sizes = {100000, 1000000};
+  }
+
+  std::printf("best of %d rounds, ms per build; ms per edge update\n",
+              kRounds);
+  std::printf("%-10s %16s %10s %10s\n", "blocks", "Lengauer-Tarjan",
+              "Semi-NCA", "update");
+  for (auto size : sizes) {
+    auto function = Function{};
+    makeCFG(function, size, 1);
+    auto graph = function.getBasicBlocks();
+    std::size_t checksum = 0;
+    auto lt = msPerBuild(DomTreeAlgo::LengauerTarjan, graph, kRounds, checksum);
+    auto snca = msPerBuild(DomTreeAlgo::SemiNCA, graph, kRounds, checksum);
+    auto update = msPerUpdate(graph, function, checksum);
+    std::printf("%-10zu %16.2f %10.2f %10.2f  (checksum %zu)\n", size, lt,
+                snca, update, checksum);
+  }
+  return 0;
+}
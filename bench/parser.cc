@@ -0,0 +1,80 @@
+// Throughput of the textual IR parser on one large function: a chain of
+// blocks, each with a phi, arithmetic, a comparison and a branch.
+#include "IR.hh"
+#include "function.hh"
+#include "parser.hh"
+#include "printer.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace jade;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// About 8 instructions per block.
+void makeFunction(Function &function, std::size_t numInstrs) {
+  auto numBlocks = std::max<std::size_t>(2, numInstrs / 8);
+  std::vector<BasicBlock *> bbs;
+  for (std::size_t i = 0; i < numBlocks; ++i) {
+    bbs.push_back(function.create<BasicBlock>());
+  }
+
+  auto *entry = bbs.front();
+  auto *param = entry->create<ParamInstr>(Type::create<Type::I64>(), "n");
+  Instruction *acc = entry->create<ConstI64>(1, "acc");
+  entry->create<GotoInstr>(bbs[1]);
+
+  for (std::size_t i = 1; i + 1 < numBlocks; ++i) {
+    auto *bb = bbs[i];
+    auto *phi = bb->create<PhiInstr>(Type::create<Type::I64>());
+    phi->addOption(acc, bbs[i - 1]);
+    auto *c = bb->create<ConstI64>(static_cast<std::int64_t>(i));
+    auto *sum = bb->create<BinaryOp>(phi, c, Opcode::ADD);
+    auto *prod = bb->create<BinaryOp>(sum, param, Opcode::MUL);
+    auto *diff = bb->create<BinaryOp>(prod, phi, Opcode::SUB);
+    auto *cond = bb->create<CmpInstr>(diff, param, Opcode::LE);
+    bb->create<IfInstr>(cond, bbs[i + 1], bbs[i + 1]);
+    acc = diff;
+  }
+  bbs.back()->create<RetInstr>(acc);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  constexpr int kRounds = 5;
+  std::size_t numInstrs = 1000000;
+  if (argc > 1) {
+    numInstrs = std::strtoull(argv[1], nullptr, 10);
+  }
+
+  std::string text;
+  {
+    auto function = Function{};
+    makeFunction(function, numInstrs);
+    text = toString(function);
+  }
+
+  double best = 0;
+  std::size_t checksum = 0;
+  for (int round = 0; round < kRounds; ++round) {
+    auto start = Clock::now();
+    auto fn = parseIR(text);
+    auto elapsed =
+        std::chrono::duration<double, std::milli>(Clock::now() - start);
+    checksum += fn ? fn->numValues() : 0;
+    best = round == 0 ? elapsed.count() : std::min(best, elapsed.count());
+  }
+
+  std::printf("best of %d rounds: %zu bytes in %.2f ms, %.1f MB/s  "
+              "(checksum %zu)\n",
+              kRounds, text.size(), best, text.size() / best / 1e3, checksum);
+  return 0;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+// Random CFGs and SSA bodies, shared by the benchmarks and the randomized
+// tests.
+#include "IR.hh"
+#include "domTree.hh"
+#include "function.hh"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace jade {
+
+// Values available at the end of bb: its defs and the ones of its nearest
+// maxDepth dominators.
+inline std::vector<Instruction *>
+available(const DomTree<BasicBlocksGraph> &domTree, BasicBlock *bb,
+          std::size_t maxDepth = std::numeric_limits<std::size_t>::max()) {
+  std::vector<Instruction *> ret;
+  auto *node = domTree.getNode(bb);
+  for (std::size_t depth = 0; node && depth < maxDepth; ++depth) {
+    for (auto &instr : *node->getBlock()) {
+      ret.push_back(&instr);
+    }
+    node = node->getIdom();
+  }
+  return ret;
+}
+
+inline Instruction *pick(const std::vector<Instruction *> &values,
+                         std::mt19937 &gen) {
+  return values[gen() % values.size()];
+}
+
+// A chain of size blocks with forward branches and loop back edges.
+inline void makeCFG(Function &function, std::size_t size, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::vector<BasicBlock *> bbs;
+  for (std::size_t i = 0; i < size; ++i) {
+    bbs.push_back(function.create<BasicBlock>());
+  }
+  std::uniform_int_distribution<std::size_t> percent(0, 99);
+  std::uniform_int_distribution<std::size_t> dist(1, 32);
+  for (std::size_t i = 0; i + 1 < size; ++i) {
+    bbs[i]->addSuccessor(bbs[i + 1]);
+    auto kind = percent(gen);
+    if (kind < 30) {
+      // if-then: skip a few blocks
+      bbs[i]->addSuccessor(bbs[std::min(size - 1, i + 1 + dist(gen))]);
+    } else if (kind < 40 && i > 0) {
+      // loop latch
+      bbs[i]->addSuccessor(bbs[i - std::min(i, dist(gen))]);
+    }
+  }
+}
+
+// SSA body on the CFG of function: every block computes a few values from
+// the ones that dominate it, blocks with many preds start with a phi. Only
+// the nearest dominators are looked at, so large functions stay cheap.
+inline void fillBody(Function &function,
+                     const DomTree<BasicBlocksGraph> &domTree,
+                     std::mt19937 &gen) {
+  constexpr std::size_t kDepth = 8;
+  auto type = Type::create<Type::I64>();
+  std::vector<PhiInstr *> phis;
+  for (auto *bb : function.rpo()) {
+    if (bb->predecessors().begin() + 1 < bb->predecessors().end()) {
+      phis.push_back(bb->create<PhiInstr>(type));
+    }
+    bb->create<ConstI64>(1);
+    auto values = available(domTree, bb, kDepth);
+    for (int i = 0; i < 3; ++i) {
+      values.push_back(bb->create<BinaryOp>(pick(values, gen),
+                                            pick(values, gen), Opcode::ADD));
+    }
+  }
+  for (auto *phi : phis) {
+    for (auto *pred : phi->getParent()->predecessors()) {
+      if (domTree.isReachable(pred)) {
+        phi->addOption(pick(available(domTree, pred, kDepth), gen), pred);
+      }
+    }
+  }
+}
+
+} // namespace jade
@@ -0,0 +1,72 @@
+#include "PM.hh"
+#include "callGraph.hh"
+#include "threadPool.hh"
+#include <atomic>
+
+namespace jade {
+
+void ModulePassManager::compile(Function *fn) const {
+  auto pm = PassManager(fn);
+  m_builder(pm);
+  pm.run();
+}
+
+void ModulePassManager::run(std::size_t numThreads) {
+  auto graph = CallGraph(m_module);
+  auto &&sccs = graph.sccs();
+
+  if (numThreads == 1) {
+    for (auto &&scc : sccs) {
+      for (auto node : scc) {
+        compile(graph.getFunction(node));
+      }
+    }
+    return;
+  }
+
+  // A component is ready when the components it calls are done.
+  std::vector<std::atomic<std::size_t>> waiting(sccs.size());
+  std::vector<std::vector<std::size_t>> users(sccs.size());
+  std::vector<std::size_t> leaves;
+  for (std::size_t scc = 0; scc < sccs.size(); ++scc) {
+    std::size_t deps = 0;
+    for (auto node : sccs[scc]) {
+      for (auto callee : graph.callees(node)) {
+        auto dep = graph.sccOf(callee);
+        if (dep == scc) {
+          continue;
+        }
+        auto &depUsers = users[dep];
+        if (depUsers.empty() || depUsers.back() != scc) {
+          depUsers.push_back(scc);
+          ++deps;
+        }
+      }
+    }
+    waiting[scc] = deps;
+    if (deps == 0) {
+      leaves.push_back(scc);
+    }
+  }
+
+  ThreadPool pool{numThreads};
+  std::function<void(std::size_t)> schedule = [&](std::size_t scc) {
+    pool.submit([&, scc] {
+      for (auto node : sccs[scc]) {
+        compile(graph.getFunction(node));
+      }
+      for (auto user : users[scc]) {
+        if (--waiting[user] == 0) {
+          schedule(user);
+        }
+      }
+    });
+  };
+
+  for (auto scc : leaves) {
+    schedule(scc);
+  }
+  pool.wait();
+}
+
+} // namespace jade
@@ -1,31 +1,74 @@
 #pragma once
 
+#include "analysisManager.hh"
 #include "function.hh"
+#include "module.hh"
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <string_view>
 #include <vector>
 namespace jade {
 
 struct Pass {
+  virtual ~Pass() = default;
   virtual void run(Function *fn) {}
+  // Passes that use analyses take them from the AnalysisManager instead of
+  // building their own.
+  virtual void run(Function *fn, AnalysisManager &) { run(fn); }
+  // What the cached analyses of fn are worth after run.
+  virtual PreservedAnalyses getPreserved() const {
+    return PreservedAnalyses::none();
+  }
 };
 
 class PassManager {
 public:
-  PassManager(Function *fn) : m_fn(fn) {}
+  PassManager(Function *fn) : m_fn(fn), m_analyses(*fn) {}
 
   void registerPass(std::unique_ptr<Pass> pass) {
     m_passes.emplace_back(std::move(pass));
   }
   void run() {
+    if (!m_fn->materialize()) {
+      return;
+    }
     for (auto &&pass : m_passes) {
-      pass->run(m_fn);
+      pass->run(m_fn, m_analyses);
+      m_analyses.invalidate(pass->getPreserved());
     }
   }
 
+  AnalysisManager &getAnalyses() { return m_analyses; }
+
 private:
   Function *m_fn;
+  AnalysisManager m_analyses;
   std::vector<std::unique_ptr<Pass>> m_passes;
 };
 
+// Runs the same pipeline on every function of a module. Passes keep state, so
+// each function gets its own PassManager filled by the builder.
+//
+// Functions are compiled on a thread pool in call-graph order: a function
+// starts once all of its callees are done, so Inline copies optimized
+// bodies. Mutually recursive functions are compiled one after another by the
+// same worker, functions that do not call each other run in parallel.
+class ModulePassManager {
+public:
+  using PipelineBuilder = std::function<void(PassManager &)>;
+
+  ModulePassManager(Module &module, PipelineBuilder builder)
+      : m_module(module), m_builder(std::move(builder)) {}
+
+  // 0 threads means one per hardware thread, 1 compiles on the caller thread
+  void run(std::size_t numThreads = 0);
+
+private:
+  void compile(Function *fn) const;
+
+  Module &m_module;
+  PipelineBuilder m_builder;
+};
+
 } // namespace jade
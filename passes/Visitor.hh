@@ -7,19 +7,18 @@ namespace jade {
 template <typename VisitorT>
 void walkInstr(VisitorT *visitor, Instruction *instr) {}
 
+// The visited instruction may be replaced or removed: step past it first.
 template <typename VisitorT> void walkBB(VisitorT *visitor, BasicBlock *bb) {
-  for (auto instrIt = bb->begin(), end = bb->end(); instrIt != end; ++instrIt) {
-    auto instr = &*instrIt;
+  for (auto instrIt = bb->begin(), end = bb->end(); instrIt != end;) {
+    auto instr = &*instrIt++;
     visitor->visitInstr(instr);
   }
 }
 
+// Visitors must not change the CFG: the order is the cached one of fn.
 template <typename VisitorT> void walkFn(VisitorT *visitor, Function *fn) {
-  auto graph = fn->getBasicBlocks();
-  auto rpoIt = RPOIterator<BasicBlocksGraph>::begin(graph);
-  auto rpoEnd = RPOIterator<BasicBlocksGraph>::end(graph);
-  for (; rpoIt != rpoEnd; ++rpoIt) {
-    visitor->visitBB(*rpoIt);
+  for (auto *bb : fn->rpo()) {
+    visitor->visitBB(bb);
   }
 }
 
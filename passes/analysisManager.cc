@@ -0,0 +1,91 @@
+#include "analysisManager.hh"
+#include "linearOrder.hh"
+#include <cassert>
+
+namespace jade {
+
+void AnalysisManager::syncCFG() {
+  if (!m_domTree) {
+    m_cfgEpoch = m_fn.getCFGEpoch();
+  }
+  assert(m_cfgEpoch == m_fn.getCFGEpoch() &&
+         "the CFG changed under preserved analyses");
+}
+
+const AnalysisManager::DomTreeTy &AnalysisManager::getDomTree() {
+  syncCFG();
+  if (!m_domTree) {
+    auto graph = m_fn.getBasicBlocks();
+    m_domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+  }
+  return *m_domTree;
+}
+
+const AnalysisManager::LoopTreeTy &AnalysisManager::getLoopTree() {
+  auto &domTree = getDomTree();
+  if (!m_loopTree) {
+    auto graph = m_fn.getBasicBlocks();
+    m_loopTree = LoopTreeBuilder<BasicBlocksGraph>().build(graph, domTree);
+  }
+  return *m_loopTree;
+}
+
+const std::vector<BasicBlock *> &AnalysisManager::getLinearOrder() {
+  auto &loops = getLoopTree();
+  if (!m_linearOrder) {
+    auto graph = m_fn.getBasicBlocks();
+    m_linearOrder = LinearOrder(graph, loops).linearize(m_fn.rpo());
+  }
+  return *m_linearOrder;
+}
+
+const Liveness &AnalysisManager::getLiveness() {
+  auto &order = getLinearOrder();
+  if (!m_liveness) {
+    m_liveness.emplace(m_fn);
+    m_liveness->compute(order);
+  }
+  return *m_liveness;
+}
+
+const LivenessChecker &AnalysisManager::getLivenessChecker() {
+  auto &domTree = getDomTree();
+  if (!m_livenessChecker) {
+    m_livenessChecker.emplace(m_fn, domTree);
+  }
+  return *m_livenessChecker;
+}
+
+bool AnalysisManager::isCached(Analysis analysis) const {
+  switch (analysis) {
+  case Analysis::DomTree:
+    return m_domTree.has_value();
+  case Analysis::LoopTree:
+    return m_loopTree.has_value();
+  case Analysis::LinearOrder:
+    return m_linearOrder.has_value();
+  case Analysis::Liveness:
+    return m_liveness.has_value();
+  case Analysis::LivenessChecker:
+    return m_livenessChecker.has_value();
+  }
+  return false;
+}
+
+void AnalysisManager::invalidate(const PreservedAnalyses &preserved) {
+  // an analysis is kept when it and what it was computed from are
+  auto keep = [&](auto &analysis, Analysis kind, bool keepInputs) {
+    auto kept = keepInputs && preserved.isPreserved(kind);
+    if (!kept) {
+      analysis.reset();
+    }
+    return kept;
+  };
+  auto domTree = keep(m_domTree, Analysis::DomTree, true);
+  keep(m_livenessChecker, Analysis::LivenessChecker, domTree);
+  auto loopTree = keep(m_loopTree, Analysis::LoopTree, domTree);
+  auto linearOrder = keep(m_linearOrder, Analysis::LinearOrder, loopTree);
+  keep(m_liveness, Analysis::Liveness, linearOrder);
+}
+
+} // namespace jade
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "IR.hh"
+#include "domTree.hh"
+#include "function.hh"
+#include "liveness.hh"
+#include "livenessChecker.hh"
+#include "loopAnalyser.hh"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace jade {
+
+// Analyses an AnalysisManager caches. Dropping one drops the ones computed
+// from it: the next ones up to Liveness are each built from the one before,
+// LivenessChecker only from DomTree.
+enum class Analysis : unsigned {
+  DomTree,
+  LoopTree,
+  LinearOrder,
+  Liveness,
+  LivenessChecker,
+};
+
+// The analyses a pass kept valid.
+class PreservedAnalyses {
+public:
+  static PreservedAnalyses none() { return {}; }
+  static PreservedAnalyses all() { return PreservedAnalyses{~0u}; }
+  // what a pass that leaves the CFG alone keeps
+  static PreservedAnalyses cfg() {
+    return none()
+        .preserve(Analysis::DomTree)
+        .preserve(Analysis::LoopTree)
+        .preserve(Analysis::LinearOrder)
+        .preserve(Analysis::LivenessChecker);
+  }
+
+  PreservedAnalyses &preserve(Analysis analysis) {
+    m_mask |= bit(analysis);
+    return *this;
+  }
+  bool isPreserved(Analysis analysis) const { return m_mask & bit(analysis); }
+
+private:
+  PreservedAnalyses() = default;
+  explicit PreservedAnalyses(unsigned mask) : m_mask{mask} {}
+
+  static unsigned bit(Analysis analysis) {
+    return 1u << static_cast<unsigned>(analysis);
+  }
+
+  unsigned m_mask{0};
+};
+
+// Computes analyses of one function on demand and keeps them until a pass
+// that does not preserve them ran. An analysis is built from the cached
+// ones it needs, so a pipeline builds the dominator tree once for all of
+// them.
+//
+// References returned stay valid until the analysis is invalidated.
+class AnalysisManager {
+public:
+  using DomTreeTy = DomTree<BasicBlocksGraph>;
+  using LoopTreeTy = LoopTree<BasicBlocksGraph>;
+
+  explicit AnalysisManager(Function &fn) : m_fn{fn} {}
+  AnalysisManager(const AnalysisManager &) = delete;
+  AnalysisManager &operator=(const AnalysisManager &) = delete;
+
+  Function &getFunction() const { return m_fn; }
+
+  const DomTreeTy &getDomTree();
+  const LoopTreeTy &getLoopTree();
+  const std::vector<BasicBlock *> &getLinearOrder();
+  const Liveness &getLiveness();
+  // stays valid across edits of instructions, see LivenessChecker
+  const LivenessChecker &getLivenessChecker();
+
+  bool isCached(Analysis analysis) const;
+  // Drops what is not preserved, and everything computed from it.
+  void invalidate(const PreservedAnalyses &preserved);
+
+private:
+  // Cached analyses must have seen the CFG as it is: a pass that changed
+  // it can not claim to preserve them.
+  void syncCFG();
+
+  Function &m_fn;
+  // CFG epoch of the cached analyses
+  std::uint64_t m_cfgEpoch{0};
+  std::optional<DomTreeTy> m_domTree;
+  std::optional<LoopTreeTy> m_loopTree;
+  std::optional<std::vector<BasicBlock *>> m_linearOrder;
+  std::optional<Liveness> m_liveness;
+  std::optional<LivenessChecker> m_livenessChecker;
+};
+
+} // namespace jade
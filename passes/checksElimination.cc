@@ -5,10 +5,14 @@
 namespace jade {
 
 void ChecksElimination::run(Function *fn) {
-  auto graph = fn->getBasicBlocks();
-  auto builder = DominatorTreeBuilder<BasicBlocksGraph>();
-  m_domTree = builder.build(graph);
+  auto am = AnalysisManager{*fn};
+  run(fn, am);
+}
+
+void ChecksElimination::run(Function *fn, AnalysisManager &am) {
+  m_domTree = &am.getDomTree();
   visitFn(fn);
+  m_domTree = nullptr;
 }
 
 void ChecksElimination::visitInstr(Instruction *instr) {
@@ -29,25 +33,26 @@ void ChecksElimination::visitInstr(Instruction *instr) {
 void ChecksElimination::zeroChecksElimination(Instruction *instr) {
   auto *input = instr->input(0);
   auto *bb = instr->getParent();
-  for (auto user = input->usersBegin(); user != input->usersEnd(); ++user) {
-    if ((*user)->getOpcode() == Opcode::ZeroCheck && *user != instr &&
-        dominate(m_domTree, *user, instr)) {
-      input->removeUser(instr);
-      bb->removeInstr(instr);
+  for (auto *user : input->users()) {
+    if (user->getOpcode() == Opcode::ZeroCheck && user != instr &&
+        dominate(*m_domTree, user, instr)) {
+      bb->remove(instr);
+      return;
     }
   }
 }
+
 void ChecksElimination::boundsChecksElimination(Instruction *instr) {
   auto *input = instr->input(0);
   auto *bound = instr->input(1);
   auto *bb = instr->getParent();
 
-  for (auto user = input->usersBegin(); user != input->usersEnd(); ++user) {
-    if ((*user)->getOpcode() == Opcode::BoundsCheck && *user != instr) {
-      auto *secondBound = (*user)->input(1);
-      if (secondBound == bound && dominate(m_domTree, *user, instr)) {
-        input->removeUser(instr);
-        bb->removeInstr(instr);
+  for (auto *user : input->users()) {
+    if (user->getOpcode() == Opcode::BoundsCheck && user != instr) {
+      auto *secondBound = user->input(1);
+      if (secondBound == bound && dominate(*m_domTree, user, instr)) {
+        bb->remove(instr);
+        return;
       }
     }
   }
@@ -9,9 +9,13 @@ namespace jade {
 struct ChecksElimination final : Pass, Visitor {
   void visitInstr(Instruction *instr) override;
   void run(Function *fn) override;
+  void run(Function *fn, AnalysisManager &am) override;
+  PreservedAnalyses getPreserved() const override {
+    return PreservedAnalyses::cfg();
+  }
 
 private:
-  DomTree<BasicBlocksGraph> m_domTree;
+  const DomTree<BasicBlocksGraph> *m_domTree{nullptr};
   void zeroChecksElimination(Instruction *instr);
   void boundsChecksElimination(Instruction *instr);
 };
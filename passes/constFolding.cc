@@ -10,7 +10,7 @@
     auto lhsVal = static_cast<Constant<type> *>(lhsInstr)->getValue();         \
     auto rhsVal = static_cast<Constant<type> *>(rhsInstr)->getValue();         \
     auto res = op()(lhsVal, rhsVal);                                           \
-    auto *constInstr = new Constant<type>(res);                                \
+    auto *constInstr = bb->getArena().create<Constant<type>>(res);             \
     bb->replace(instr, constInstr);                                            \
   }
 
@@ -55,7 +55,7 @@
     auto *bb = instr->getParent();                                             \
     auto val = static_cast<Constant<type> *>(instr)->getValue();               \
     auto res = op<type>()(val);                                                \
-    auto *constInstr = new Constant<type>(res);                                \
+    auto *constInstr = bb->getArena().create<Constant<type>>(res);             \
     bb->replace(instr, constInstr);                                            \
   }
 
@@ -124,6 +124,10 @@ void ConstantFolder::visitInstr(Instruction *instr) {
 }
 
 bool ConstantFolder::canFold(Instruction *instr) {
+  if (!isFoldable(instr->getOpcode())) {
+    return false;
+  }
+
   for (auto *input : *instr) {
     if (input->getOpcode() != Opcode::CONST) {
       return false;
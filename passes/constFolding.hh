@@ -10,6 +10,9 @@ struct ConstantFolder : Pass, Visitor {
   void visitInstr(Instruction *instr) override;
   bool canFold(Instruction *instr);
   void run(Function *fn) override { visitFn(fn); }
+  PreservedAnalyses getPreserved() const override {
+    return PreservedAnalyses::cfg();
+  }
 };
 
 } // namespace jade
@@ -7,9 +7,9 @@
 namespace jade {
 
 void DCE::visitBB(BasicBlock *bb) {
-  auto instr = &*bb->begin();
+  auto *instr = bb->begin().getPtr();
   while (instr) {
-    if (instr->numUsers() == 0 && !instr->isTerm()) {
+    if (!instr->hasUsers() && !instr->hasSideEffects()) {
       auto *next = static_cast<Instruction *>(instr->getNext());
       bb->remove(instr);
       instr = next;
@@ -9,6 +9,9 @@ namespace jade {
 struct DCE : Pass, Visitor {
   void visitBB(BasicBlock *bb) override;
   void run(Function *fn) override { visitFn(fn); }
+  PreservedAnalyses getPreserved() const override {
+    return PreservedAnalyses::cfg();
+  }
 };
 
 } // namespace jade
@@ -20,30 +20,21 @@ struct RetInstrCollector : Visitor {
   }
 };
 
-void moveInstrs(Instruction *start, BasicBlock *src, BasicBlock *dst) {
-  auto *i = start;
-  while (i) {
-    auto *next = i->next();
-    src->removeInstr(i);
-    dst->insert(i);
-    i = next;
-  }
-}
-
 void Inline::run(Function *fn) {
   m_caller = fn;
 
-  auto graph = fn->getBasicBlocks();
-  auto rpoIt = RPOIterator<BasicBlocksGraph>::begin(graph);
-  auto rpoEnd = RPOIterator<BasicBlocksGraph>::end(graph);
-  for (; rpoIt != rpoEnd; ++rpoIt) {
-    auto *bb = *rpoIt;
-    for (auto instrIt = bb->begin(), end = bb->end(); instrIt != end;
-         ++instrIt) {
-      auto instr = &*instrIt;
+  // inlining adds blocks: walk a copy of the order
+  auto rpo = fn->rpo();
+  for (auto *bb : rpo) {
+    // inlining moves the rest of the block past the callee body, next keeps
+    // walking there so every call of the block is inlined
+    auto *instr = bb->begin().getPtr();
+    while (instr) {
+      auto *next = instr->next();
       if (instr->getOpcode() == Opcode::CALL) {
         inlineCall(instr);
       }
+      instr = next;
     }
   }
 }
@@ -53,6 +44,10 @@ void Inline::inlineCall(Instruction *instr) {
 
   auto *callInstr = static_cast<CallInstr *>(instr);
   auto *callBB = instr->getParent();
+  // a lazily loaded callee is decoded on first use
+  if (!callInstr->getCallee()->materialize()) {
+    return;
+  }
   auto callee = callInstr->getCallee()->copy();
 
   auto splitBB = splitCallerBlock(instr);
@@ -60,8 +55,10 @@ void Inline::inlineCall(Instruction *instr) {
   updateOutputsDataFlow(splitBB, callInstr, callee.get());
   moveEntryBB(callBB, callInstr, callee.get());
   auto *nextBB = mergeGraphs(callInstr, callee.get());
+  // callee blocks and instructions now belong to the caller
+  m_caller->getArena().merge(callee->getArena());
 
-  callBB->removeInstr(instr);
+  callBB->remove(instr);
 }
 
 BasicBlock *Inline::splitCallerBlock(Instruction *instr) {
@@ -70,8 +67,7 @@ BasicBlock *Inline::splitCallerBlock(Instruction *instr) {
   auto *currBB = instr->getParent();
   auto *newBB = m_caller->create<BasicBlock>();
 
-  auto *i = instr->next();
-  moveInstrs(i, currBB, newBB);
+  newBB->splice(newBB->end(), currBB, instr->next());
 
   return newBB;
 }
@@ -90,7 +86,6 @@ void Inline::updateOutputsDataFlow(BasicBlock *splitted, CallInstr *callInstr,
     auto *phi = splitted->create<PhiInstr>(callInstr->getType());
     for (auto *retInstr : rets) {
       auto *val = static_cast<RetInstr *>(retInstr)->getVal();
-      val->addUser(phi);
       phi->addOption(val, retInstr->getParent());
     }
 
@@ -121,14 +116,14 @@ void Inline::updateInputsDataFlow(CallInstr *callInstr, Function *callee) {
 void Inline::moveEntryBB(BasicBlock *callBB, CallInstr *callInstr,
                          Function *callee) {
   auto calleeStartBB = &*callee->getBasicBlocks().nodes().begin();
-  auto *i = &*calleeStartBB->begin();
-  moveInstrs(i, calleeStartBB, callBB);
+  callBB->splice(callBB->end(), calleeStartBB, &*calleeStartBB->begin());
   callee->remove(calleeStartBB);
 }
 
 BasicBlock *Inline::mergeGraphs(CallInstr *callInstr, Function *callee) {
   auto bbs = callee->getBasicBlocks().nodes();
-  auto *startBB = &*bbs.begin();
+  // a single-block callee has nothing left after moveEntryBB
+  auto *startBB = bbs.begin().getPtr();
   auto *bb = startBB;
   while (bb) {
     auto *next = bb->next();
@@ -48,9 +48,9 @@ void PeepHoles::processAnd(Instruction *instr) {
   // And x, 0 -> const 0
   auto constant = loadIntegerConst(constInstr);
   if (constant.has_value() && constant.value() == 0) {
-    auto newConstInstr = createIntegerConstant(0, constInstr->getType());
-    bb->insert(newConstInstr.get());
-    replaceUsers(instr, newConstInstr.release());
+    auto *newConstInstr =
+        createIntegerConstant(bb, 0, constInstr->getType());
+    replaceUsers(instr, newConstInstr);
     bb->remove(instr);
   }
 }
@@ -66,9 +66,8 @@ void PeepHoles::processAdd(Instruction *instr) {
 
   // add V1, V1 -> shl V1, 1
   if (lhs->getId() == rhs->getId()) {
-    auto constInstr = createIntegerConstant(1, lhs->getType());
-    bb->insert(constInstr.get());
-    auto *shl = bb->create<BinaryOp>(lhs, constInstr.release(), Opcode::SHL);
+    auto *constInstr = createIntegerConstant(bb, 1, lhs->getType());
+    auto *shl = bb->create<BinaryOp>(lhs, constInstr, Opcode::SHL);
     replaceUsers(instr, shl);
     bb->remove(instr);
     return;
@@ -9,6 +9,9 @@ namespace jade {
 struct PeepHoles : Pass, Visitor {
   void visitInstr(Instruction *instr) override;
   void run(Function *fn) override { visitFn(fn); }
+  PreservedAnalyses getPreserved() const override {
+    return PreservedAnalyses::cfg();
+  }
 
   void processAnd(Instruction *instr);
   void processAdd(Instruction *instr);
@@ -0,0 +1,78 @@
+#include "PM.hh"
+#include "analysisManager.hh"
+#include "graphs.hh"
+#include "linearOrder.hh"
+#include "gtest/gtest.h"
+#include <memory>
+#include <vector>
+
+using namespace jade;
+
+namespace {
+
+// records whether the dominator tree was there already
+struct DomTreeUser final : Pass {
+  DomTreeUser(std::vector<bool> &cached, PreservedAnalyses preserved)
+      : m_cached{cached}, m_preserved{preserved} {}
+
+  void run(Function *, AnalysisManager &am) override {
+    m_cached.push_back(am.isCached(Analysis::DomTree));
+    am.getDomTree();
+  }
+  PreservedAnalyses getPreserved() const override { return m_preserved; }
+
+  std::vector<bool> &m_cached;
+  PreservedAnalyses m_preserved;
+};
+
+} // namespace
+
+TEST(AnalysisManager, Cache) {
+  auto function = example3();
+  auto am = AnalysisManager{function};
+  auto *domTree = &am.getDomTree();
+  EXPECT_EQ(&am.getDomTree(), domTree);
+  EXPECT_FALSE(am.isCached(Analysis::LoopTree));
+
+  // liveness brings everything it is computed from
+  am.getLiveness();
+  EXPECT_TRUE(am.isCached(Analysis::LoopTree));
+  EXPECT_TRUE(am.isCached(Analysis::LinearOrder));
+  EXPECT_EQ(&am.getDomTree(), domTree);
+
+  auto graph = function.getBasicBlocks();
+  EXPECT_EQ(am.getLinearOrder(), LinearOrder(graph).linearize(function.rpo()));
+
+  am.getLivenessChecker();
+  am.invalidate(PreservedAnalyses::cfg());
+  EXPECT_TRUE(am.isCached(Analysis::LinearOrder));
+  EXPECT_TRUE(am.isCached(Analysis::LivenessChecker));
+  EXPECT_FALSE(am.isCached(Analysis::Liveness));
+
+  // the loops are dropped with the tree they come from
+  am.invalidate(PreservedAnalyses::none().preserve(Analysis::LoopTree));
+  EXPECT_FALSE(am.isCached(Analysis::DomTree));
+  EXPECT_FALSE(am.isCached(Analysis::LoopTree));
+  EXPECT_FALSE(am.isCached(Analysis::LivenessChecker));
+
+  am.getLinearOrder();
+  am.invalidate(PreservedAnalyses::all());
+  EXPECT_TRUE(am.isCached(Analysis::LinearOrder));
+}
+
+// Passes share the tree until one does not keep it.
+TEST(AnalysisManager, Pipeline) {
+  auto function = example2();
+  std::vector<bool> cached;
+  auto pm = PassManager(&function);
+  pm.registerPass(
+      std::make_unique<DomTreeUser>(cached, PreservedAnalyses::cfg()));
+  pm.registerPass(
+      std::make_unique<DomTreeUser>(cached, PreservedAnalyses::none()));
+  pm.registerPass(
+      std::make_unique<DomTreeUser>(cached, PreservedAnalyses::all()));
+  pm.run();
+
+  EXPECT_EQ(cached, (std::vector<bool>{false, true, false}));
+  EXPECT_TRUE(pm.getAnalyses().isCached(Analysis::DomTree));
+}
@@ -0,0 +1,75 @@
+#include "arena.hh"
+#include "IR.hh"
+#include "function.hh"
+#include "gtest/gtest.h"
+#include <cstdint>
+
+using namespace jade;
+
+namespace {
+
+struct Tracked {
+  Tracked(int &counter) : m_counter{counter} {}
+  ~Tracked() { ++m_counter; }
+
+  int &m_counter;
+};
+
+} // namespace
+
+TEST(Arena, Alignment) {
+  Arena arena;
+  for (std::size_t i = 0; i < 100; ++i) {
+    auto *c = arena.create<char>('a');
+    auto *d = arena.create<double>(1.0);
+    ASSERT_EQ(*c, 'a');
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(d) % alignof(double), 0);
+  }
+
+  auto *big = arena.allocate(1 << 16, 64);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(big) % 64, 0);
+}
+
+TEST(Arena, Destructors) {
+  int counter = 0;
+  {
+    Arena arena;
+    for (std::size_t i = 0; i < 10; ++i) {
+      arena.create<Tracked>(counter);
+    }
+    ASSERT_EQ(counter, 0);
+  }
+  ASSERT_EQ(counter, 10);
+}
+
+TEST(Arena, Merge) {
+  int counter = 0;
+  {
+    Arena dst;
+    {
+      Arena src;
+      src.create<Tracked>(counter);
+      src.create<Tracked>(counter);
+      dst.merge(src);
+      ASSERT_EQ(src.bytesAllocated(), 0);
+    }
+    ASSERT_EQ(counter, 0);
+  }
+  ASSERT_EQ(counter, 2);
+}
+
+TEST(Arena, FunctionStorage) {
+  auto function = Function{};
+  auto *bb0 = function.create<BasicBlock>();
+  auto *v0 = bb0->create<ConstI64>(1, "v0");
+  auto *v1 = bb0->create<ConstI64>(2, "v1");
+  bb0->create<BinaryOp>(v0, v1, Opcode::ADD, "v2");
+
+  ASSERT_EQ(bb0->getFunction(), &function);
+  ASSERT_EQ(&bb0->getArena(), &function.getArena());
+  ASSERT_GE(function.getArena().bytesAllocated(),
+            sizeof(BasicBlock) + 2 * sizeof(ConstI64) + sizeof(BinaryOp));
+
+  auto moved = std::move(function);
+  ASSERT_EQ(bb0->getFunction(), &moved);
+}
@@ -0,0 +1,221 @@
+#include "bitVector.hh"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <type_traits>
+#include <vector>
+
+using namespace jade;
+
+namespace {
+
+std::set<std::size_t> randomSet(std::mt19937 &gen, std::size_t universe,
+                                std::size_t count) {
+  std::uniform_int_distribution<std::size_t> dist(0, universe - 1);
+  std::set<std::size_t> ret;
+  for (std::size_t i = 0; i < count; ++i) {
+    ret.insert(dist(gen));
+  }
+  return ret;
+}
+
+template <typename BitsTy>
+BitsTy fromSet(const std::set<std::size_t> &set, std::size_t size) {
+  BitsTy bits;
+  for (auto idx : set) {
+    bits.insert(idx);
+  }
+  if constexpr (std::is_same_v<BitsTy, BitVector>) {
+    bits.resize(size);
+  }
+  return bits;
+}
+
+template <typename BitsTy> std::set<std::size_t> toSet(const BitsTy &bits) {
+  return std::set<std::size_t>(bits.begin(), bits.end());
+}
+
+} // namespace
+
+TEST(BitVector, Basic) {
+  auto bits = BitVector(130);
+  EXPECT_EQ(bits.size(), 130);
+  EXPECT_TRUE(bits.none());
+
+  bits.set(0);
+  bits.set(64);
+  bits.set(129);
+  EXPECT_TRUE(bits.test(64));
+  EXPECT_FALSE(bits.test(63));
+  EXPECT_EQ(bits.count(), 3);
+  EXPECT_EQ(toSet(bits), (std::set<std::size_t>{0, 64, 129}));
+
+  EXPECT_FALSE(bits.insert(64));
+  EXPECT_TRUE(bits.insert(300));
+  EXPECT_GE(bits.size(), 301);
+  EXPECT_EQ(bits.erase(0), 1);
+  EXPECT_EQ(bits.erase(0), 0);
+  EXPECT_EQ(bits.count(1000), 0);
+  EXPECT_EQ(toSet(bits), (std::set<std::size_t>{64, 129, 300}));
+
+  bits.reset();
+  EXPECT_TRUE(bits.empty());
+  bits.set();
+  EXPECT_EQ(bits.count(), bits.size());
+
+  auto ones = BitVector(70, true);
+  EXPECT_EQ(ones.count(), 70);
+  ones.resize(3);
+  ones.resize(100);
+  EXPECT_EQ(ones.count(), 3);
+}
+
+TEST(BitVector, SetOperations) {
+  std::mt19937 gen(42);
+  for (std::size_t size : {5, 64, 100, 511, 4096, 10007}) {
+    auto lhsSet = randomSet(gen, size, size / 3 + 1);
+    auto rhsSet = randomSet(gen, size, size / 3 + 1);
+    auto lhs = fromSet<BitVector>(lhsSet, size);
+    auto rhs = fromSet<BitVector>(rhsSet, size);
+
+    std::set<std::size_t> expected;
+    std::set_union(lhsSet.begin(), lhsSet.end(), rhsSet.begin(), rhsSet.end(),
+                   std::inserter(expected, expected.end()));
+    auto result = lhs;
+    EXPECT_EQ(result.unionWith(rhs), expected != lhsSet);
+    EXPECT_EQ(toSet(result), expected);
+    EXPECT_EQ(result.count(), expected.size());
+    EXPECT_FALSE(result.unionWith(rhs));
+
+    expected.clear();
+    std::set_intersection(lhsSet.begin(), lhsSet.end(), rhsSet.begin(),
+                          rhsSet.end(),
+                          std::inserter(expected, expected.end()));
+    result = lhs;
+    result &= rhs;
+    EXPECT_EQ(toSet(result), expected);
+
+    expected.clear();
+    std::set_difference(lhsSet.begin(), lhsSet.end(), rhsSet.begin(),
+                        rhsSet.end(), std::inserter(expected, expected.end()));
+    result = lhs;
+    result -= rhs;
+    EXPECT_EQ(toSet(result), expected);
+    EXPECT_EQ(result.count(), expected.size());
+  }
+}
+
+TEST(BitVector, DifferentSizes) {
+  auto small = BitVector(10);
+  small.set(3);
+  auto big = BitVector(1000);
+  big.set(3);
+  big.set(999);
+
+  EXPECT_NE(small, big);
+  big.reset(999);
+  EXPECT_EQ(small, big);
+
+  big.set(500);
+  small |= big;
+  EXPECT_EQ(small.size(), 1000);
+  EXPECT_EQ(toSet(small), (std::set<std::size_t>{3, 500}));
+
+  auto other = BitVector(10);
+  other.set(3);
+  EXPECT_TRUE(small.intersectWith(other));
+  EXPECT_EQ(toSet(small), (std::set<std::size_t>{3}));
+}
+
+// The AVX2 kernels must agree with the scalar ones, tails included.
+TEST(BitVector, Kernels) {
+  auto *avx2 = bitops::avx2Kernels();
+  if (!avx2) {
+    GTEST_SKIP() << "no AVX2";
+  }
+
+  std::mt19937_64 gen(7);
+  for (std::size_t n : {0, 1, 3, 4, 5, 17, 64, 67}) {
+    std::vector<bitops::Word> src(n), dst(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      src[i] = gen();
+      dst[i] = gen();
+    }
+    EXPECT_EQ(avx2->countWords(src.data(), n),
+              bitops::countScalar(src.data(), n));
+
+    using KernelFn = bool (*)(bitops::Word *, const bitops::Word *,
+                              std::size_t);
+    std::pair<KernelFn, KernelFn> kernels[] = {
+        {avx2->orWords, bitops::orScalar},
+        {avx2->andWords, bitops::andScalar},
+        {avx2->andNotWords, bitops::andNotScalar}};
+    for (auto [fast, scalar] : kernels) {
+      auto fastDst = dst;
+      auto scalarDst = dst;
+      EXPECT_EQ(fast(fastDst.data(), src.data(), n),
+                scalar(scalarDst.data(), src.data(), n));
+      EXPECT_EQ(fastDst, scalarDst);
+      // a second application changes nothing
+      EXPECT_FALSE(fast(fastDst.data(), src.data(), n));
+    }
+  }
+}
+
+TEST(SparseBitVector, Basic) {
+  SparseBitVector bits;
+  EXPECT_TRUE(bits.empty());
+  EXPECT_TRUE(bits.insert(1000000));
+  EXPECT_TRUE(bits.insert(5));
+  EXPECT_TRUE(bits.insert(127));
+  EXPECT_TRUE(bits.insert(128));
+  EXPECT_FALSE(bits.insert(5));
+
+  EXPECT_TRUE(bits.test(127));
+  EXPECT_FALSE(bits.test(126));
+  EXPECT_EQ(bits.count(), 4);
+  EXPECT_EQ(toSet(bits), (std::set<std::size_t>{5, 127, 128, 1000000}));
+
+  EXPECT_EQ(bits.erase(1000000), 1);
+  EXPECT_EQ(bits.erase(1000000), 0);
+  EXPECT_EQ(toSet(bits), (std::set<std::size_t>{5, 127, 128}));
+  bits.clear();
+  EXPECT_EQ(bits.begin(), bits.end());
+}
+
+TEST(SparseBitVector, SetOperations) {
+  std::mt19937 gen(3);
+  for (std::size_t universe : {100, 10000, 1000000}) {
+    auto lhsSet = randomSet(gen, universe, 200);
+    auto rhsSet = randomSet(gen, universe, 200);
+    auto lhs = fromSet<SparseBitVector>(lhsSet, universe);
+    auto rhs = fromSet<SparseBitVector>(rhsSet, universe);
+
+    std::set<std::size_t> expected;
+    std::set_union(lhsSet.begin(), lhsSet.end(), rhsSet.begin(), rhsSet.end(),
+                   std::inserter(expected, expected.end()));
+    auto result = lhs;
+    EXPECT_TRUE(result.unionWith(rhs));
+    EXPECT_FALSE(result.unionWith(rhs));
+    EXPECT_EQ(toSet(result), expected);
+
+    expected.clear();
+    std::set_intersection(lhsSet.begin(), lhsSet.end(), rhsSet.begin(),
+                          rhsSet.end(),
+                          std::inserter(expected, expected.end()));
+    result = lhs;
+    result &= rhs;
+    EXPECT_EQ(toSet(result), expected);
+
+    expected.clear();
+    std::set_difference(lhsSet.begin(), lhsSet.end(), rhsSet.begin(),
+                        rhsSet.end(), std::inserter(expected, expected.end()));
+    result = lhs;
+    result -= rhs;
+    EXPECT_EQ(toSet(result), expected);
+    EXPECT_EQ(result.count(), expected.size());
+    EXPECT_EQ(result, fromSet<SparseBitVector>(expected, universe));
+  }
+}
@@ -65,7 +65,7 @@ TEST(checksElimination, zeroCheck) {
   // bb 2
   auto *zc2 = bb2->create<UnaryOp>(v0, Opcode::ZeroCheck);
   auto v6 = bb2->create<BinaryOp>(v0, v2, Opcode::ADD);
-  auto *zc3 = bb2->create<UnaryOp>(v0, Opcode::ZeroCheck);
+  auto *zc3 = bb2->create<UnaryOp>(v6, Opcode::ZeroCheck);
   bb2->create<RetInstr>(v6);
 
   // bb3
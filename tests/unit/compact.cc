@@ -0,0 +1,138 @@
+#include "compact.hh"
+#include "IR.hh"
+#include "domTree.hh"
+#include "function.hh"
+#include "graphs.hh"
+#include "liveness.hh"
+#include "randomIR.hh"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <random>
+
+using namespace jade;
+
+// bb0: {
+//     v0: i64 = param;
+//     v1: i64 = const 7;
+//     goto -> bb1;
+// }
+// bb1: {
+//     v2: i64 = phi [v1, bb0], [v3, bb1];
+//     v3: i64 = add v2, v0;
+//     v4: i1 = eq v3, v1;
+//     if (v4, bb2, bb1);
+// }
+// bb2: {
+//     ret v3;
+// }
+TEST(CompactFunction, Tables) {
+  auto function = Function{};
+  auto *bb0 = function.create<BasicBlock>();
+  auto *bb1 = function.create<BasicBlock>();
+  auto *bb2 = function.create<BasicBlock>();
+
+  auto *v0 = bb0->create<ParamInstr>(Type::create<Type::I64>(), "v0");
+  auto *v1 = bb0->create<ConstI64>(7, "v1");
+  bb0->create<GotoInstr>(bb1);
+
+  auto *v2 = bb1->create<PhiInstr>(Type::create<Type::I64>(), "v2");
+  auto *v3 = bb1->create<BinaryOp>(v2, v0, Opcode::ADD, "v3");
+  auto *v4 = bb1->create<CmpInstr>(v3, v1, Opcode::EQ, "v4");
+  bb1->create<IfInstr>(v4, bb1, bb2);
+  v2->addOption(v1, bb0);
+  v2->addOption(v3, bb1);
+
+  auto *ret = bb2->create<RetInstr>(v3);
+
+  auto compact = CompactFunction{function};
+  ASSERT_EQ(compact.numBlocks(), 3);
+  ASSERT_EQ(compact.numInstrs(), 8);
+
+  auto h3 = compact.getHandle(v3);
+  ASSERT_EQ(compact.getOpcode(h3), Opcode::ADD);
+  ASSERT_EQ(compact.getType(h3), Type::I64);
+  ASSERT_EQ(compact.getParent(h3), compact.getHandle(bb1));
+  ASSERT_EQ(compact.operands(h3).size(), 2);
+  ASSERT_EQ(compact.operands(h3)[0], compact.getHandle(v2));
+  ASSERT_EQ(compact.operands(h3)[1], compact.getHandle(v0));
+  ASSERT_EQ(compact.getImmediate(compact.getHandle(v1)), 7);
+
+  auto phi = compact.instr(compact.getHandle(v2));
+  ASSERT_EQ(phi.numInputs(), 2);
+  ASSERT_EQ(phi.input(1).get(), v3);
+  ASSERT_EQ(compact.blockOperands(phi.handle())[0], compact.getHandle(bb0));
+
+  // thin view keeps the pointer API available
+  auto retRef = compact.instr(compact.getHandle(ret));
+  ASSERT_EQ(retRef.get(), ret);
+  ASSERT_EQ(static_cast<RetInstr *>(retRef.get())->getVal(), v3);
+
+  auto hbb1 = compact.getHandle(bb1);
+  ASSERT_EQ(compact.blockEnd(hbb1) - compact.blockBegin(hbb1), 4);
+  ASSERT_EQ(compact.successors(hbb1).size(), 2);
+  ASSERT_EQ(compact.predecessors(hbb1).size(), 2);
+}
+
+TEST(CompactFunction, Footprint) {
+  auto function = Function{};
+  auto *bb0 = function.create<BasicBlock>();
+  Instruction *acc = bb0->create<ConstI64>(0);
+  for (std::int64_t i = 0; i < 1000; ++i) {
+    auto *c = bb0->create<ConstI64>(i);
+    acc = bb0->create<BinaryOp>(acc, c, Opcode::ADD);
+  }
+  bb0->create<RetInstr>(acc);
+
+  auto compact = CompactFunction{function};
+  ASSERT_EQ(compact.numInstrs(), 2002);
+
+  // the snapshot is kept next to the function, its views and handle tables
+  // are part of the cost
+  auto views = compact.numInstrs() * sizeof(Instruction *) +
+               compact.numBlocks() * sizeof(BasicBlock *);
+  auto handles = (compact.numValues() + compact.numBlockIds()) * sizeof(Handle);
+  ASSERT_EQ(compact.bytes(), compact.tableBytes() + views + handles);
+
+  // a scan reads a few bytes per instruction, the walk a whole node
+  auto tablePerInstr = compact.tableBytes() / compact.numInstrs();
+  auto arenaPerInstr =
+      function.getArena().bytesAllocated() / compact.numInstrs();
+  ASSERT_LT(4 * tablePerInstr, arenaPerInstr);
+}
+
+// The gen/kill sets from the tables are the ones from the instruction lists,
+// also when removed values leave holes in the ids.
+TEST(CompactFunction, LiveProblem) {
+  std::mt19937 gen(5);
+  for (int round = 0; round < 10; ++round) {
+    auto function = Function{};
+    makeCFG(function, 40, round);
+    auto graph = function.getBasicBlocks();
+    auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+    fillBody(function, domTree, gen);
+    for (auto *bb : function.rpo()) {
+      auto unused = std::find_if(bb->begin(), bb->end(), [](auto &instr) {
+        return instr.getOpcode() == Opcode::ADD && !instr.hasUsers();
+      });
+      if (unused != bb->end()) {
+        bb->remove(unused.getPtr());
+      }
+    }
+
+    auto compact = CompactFunction{function};
+    auto fromLists = Liveness::buildProblem(function);
+    auto fromTables = Liveness::buildProblem(compact);
+    ASSERT_EQ(fromTables.gen, fromLists.gen);
+    ASSERT_EQ(fromTables.kill, fromLists.kill);
+    ASSERT_EQ(fromTables.seed, fromLists.seed);
+
+    auto liveness = Liveness{function};
+    liveness.compute();
+    auto fromSnapshot = Liveness{function, compact};
+    fromSnapshot.compute();
+    for (auto &bb : function) {
+      ASSERT_EQ(fromSnapshot.getLiveIn(&bb), liveness.getLiveIn(&bb));
+      ASSERT_EQ(fromSnapshot.getLiveOut(&bb), liveness.getLiveOut(&bb));
+    }
+  }
+}
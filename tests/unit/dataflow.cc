@@ -0,0 +1,130 @@
+#include "dataflow.hh"
+#include "IR.hh"
+#include "domTree.hh"
+#include "function.hh"
+#include "graphs.hh"
+#include "gtest/gtest.h"
+#include <random>
+#include <vector>
+
+using namespace jade;
+
+namespace {
+
+using Dominators =
+    BitVectorProblem<BasicBlocksGraph, DataflowDirection::Forward,
+                     /*IsUnion=*/false>;
+using Reachable =
+    BitVectorProblem<BasicBlocksGraph, DataflowDirection::Backward>;
+
+// Dominators as a must problem: out = {b} + the meet of the preds, nothing
+// flows into the entry.
+Dominators makeDominators(Function &function) {
+  auto numBlocks = function.numBlocks();
+  auto problem = Dominators{numBlocks, numBlocks};
+  for (auto &bb : function) {
+    problem.gen[bb.getId()].set(bb.getId());
+  }
+  auto *entry = &*function.begin();
+  problem.seed.resize(entry->getId() + 1);
+  problem.seed.back() = BitVector(numBlocks);
+  return problem;
+}
+
+// Blocks reachable from a block, itself included: in = {b} + the succs' in.
+Reachable makeReachable(Function &function) {
+  auto numBlocks = function.numBlocks();
+  auto problem = Reachable{numBlocks, numBlocks};
+  for (auto &bb : function) {
+    problem.gen[bb.getId()].set(bb.getId());
+  }
+  return problem;
+}
+
+void reach(BasicBlock *bb, BitVector &visited) {
+  if (visited.test(bb->getId())) {
+    return;
+  }
+  visited.set(bb->getId());
+  for (auto *succ : bb->successors()) {
+    reach(succ, visited);
+  }
+}
+
+void expectDominators(Function &function) {
+  auto graph = function.getBasicBlocks();
+  auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+  auto problem = makeDominators(function);
+  auto solver = DataflowSolver<BasicBlocksGraph, Dominators>{problem};
+  solver.solve(graph);
+  for (auto &bb : function) {
+    auto &doms = solver.getOut(&bb);
+    if (!domTree.isReachable(&bb)) {
+      // never visited, keeps top
+      EXPECT_EQ(doms.count(), function.numBlocks());
+      continue;
+    }
+    for (auto &other : function) {
+      EXPECT_EQ(doms.test(other.getId()), domTree.dominate(&other, &bb))
+          << other.getId() << " dominates " << bb.getId();
+    }
+  }
+}
+
+void expectReachable(Function &function) {
+  auto graph = function.getBasicBlocks();
+  auto problem = makeReachable(function);
+  auto solver = DataflowSolver<BasicBlocksGraph, Reachable>{problem};
+  solver.solve(graph);
+  auto fromEntry = BitVector(function.numBlocks());
+  reach(&*function.begin(), fromEntry);
+  for (auto &bb : function) {
+    if (!fromEntry.test(bb.getId())) {
+      continue;
+    }
+    auto visited = BitVector(function.numBlocks());
+    reach(&bb, visited);
+    EXPECT_EQ(solver.getIn(&bb), visited) << "from " << bb.getId();
+  }
+}
+
+} // namespace
+
+TEST(Dataflow, Examples) {
+  for (auto *example : {example1, example2, example3}) {
+    auto function = example();
+    expectDominators(function);
+    expectReachable(function);
+  }
+}
+
+// Without back edges every block is visited once, in a single sweep.
+TEST(Dataflow, Acyclic) {
+  auto function = example2();
+  auto graph = function.getBasicBlocks();
+  auto problem = makeDominators(function);
+  auto solver = DataflowSolver<BasicBlocksGraph, Dominators>{problem};
+  solver.solve(graph);
+  EXPECT_EQ(solver.numSweeps(), 1);
+  EXPECT_EQ(solver.numVisits(), function.numBlocks());
+}
+
+TEST(Dataflow, Random) {
+  std::mt19937 gen(25);
+  for (int round = 0; round < 40; ++round) {
+    auto function = Function{};
+    std::vector<BasicBlock *> bbs;
+    for (int i = 0; i < 30; ++i) {
+      bbs.push_back(function.create<BasicBlock>());
+    }
+    std::uniform_int_distribution<std::size_t> dist(0, bbs.size() - 1);
+    for (std::size_t i = 0; i + 1 < bbs.size(); ++i) {
+      if (round % 2 == 0) {
+        bbs[i]->addSuccessor(bbs[i + 1]);
+      }
+      bbs[i]->addSuccessor(bbs[dist(gen)]);
+    }
+    expectDominators(function);
+    expectReachable(function);
+  }
+}
@@ -0,0 +1,106 @@
+#include "denseMap.hh"
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace jade;
+
+TEST(DenseMap, Basic) {
+  std::vector<int> objs(3);
+  DenseMap<int *, std::string> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.find(&objs[0]), map.end());
+  EXPECT_EQ(map.lookupOr(&objs[0], "none"), "none");
+
+  map[&objs[0]] = "a";
+  EXPECT_TRUE(map.insert({&objs[1], "b"}).second);
+  EXPECT_FALSE(map.insert({&objs[1], "c"}).second);
+  EXPECT_FALSE(map.try_emplace(&objs[0], "d").second);
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(map.at(&objs[1]), "b");
+  EXPECT_EQ(map.find(&objs[0])->second, "a");
+  EXPECT_TRUE(map.contains(&objs[0]));
+  EXPECT_EQ(map.count(&objs[2]), 0);
+
+  // nullptr is an ordinary key
+  map[nullptr] = "null";
+  EXPECT_EQ(map.at(nullptr), "null");
+
+  EXPECT_EQ(map.erase(&objs[0]), 1);
+  EXPECT_EQ(map.erase(&objs[0]), 0);
+  map.erase(map.find(nullptr));
+  EXPECT_EQ(map.size(), 1);
+
+  const auto &cmap = map;
+  std::size_t seen = 0;
+  for (DenseMap<int *, std::string>::const_iterator it = cmap.begin();
+       it != cmap.end(); ++it, ++seen) {
+    EXPECT_EQ(it->first, &objs[1]);
+  }
+  EXPECT_EQ(seen, 1);
+
+  auto capacity = map.capacity();
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_EQ(map.capacity(), capacity);
+}
+
+TEST(DenseMap, Reserve) {
+  DenseMap<std::size_t, std::size_t> map;
+  map.reserve(1000);
+  auto capacity = map.capacity();
+  for (std::size_t i = 0; i < 1000; ++i) {
+    map[i] = i * i;
+  }
+  EXPECT_EQ(map.capacity(), capacity);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    EXPECT_EQ(map.at(i), i * i);
+  }
+}
+
+// Erase shifts entries back: every remaining key must stay reachable.
+TEST(DenseMap, Random) {
+  std::mt19937 gen(11);
+  for (std::size_t universe : {10, 100, 5000}) {
+    std::uniform_int_distribution<std::size_t> dist(0, universe - 1);
+    DenseMap<std::size_t, std::size_t> map;
+    std::unordered_map<std::size_t, std::size_t> expected;
+
+    for (int i = 0; i < 50000; ++i) {
+      auto key = dist(gen);
+      switch (gen() % 3) {
+      case 0:
+        map[key] = i;
+        expected[key] = i;
+        break;
+      case 1:
+        EXPECT_EQ(map.insert({key, i}).second,
+                  expected.insert({key, i}).second);
+        break;
+      default:
+        ASSERT_EQ(map.erase(key), expected.erase(key));
+        break;
+      }
+      ASSERT_EQ(map.size(), expected.size());
+    }
+
+    for (std::size_t key = 0; key < universe; ++key) {
+      auto it = expected.find(key);
+      if (it == expected.end()) {
+        EXPECT_FALSE(map.contains(key));
+      } else {
+        EXPECT_EQ(map.at(key), it->second);
+      }
+    }
+    std::size_t count = 0;
+    for (auto &&[key, val] : map) {
+      EXPECT_EQ(expected.at(key), val);
+      ++count;
+    }
+    EXPECT_EQ(count, expected.size());
+  }
+}
@@ -3,8 +3,11 @@
 #include "function.hh"
 #include "graphs.hh"
 #include "gtest/gtest.h"
+#include <algorithm>
 #include <array>
 #include <iostream>
+#include <random>
+#include <vector>
 
 using namespace jade;
 
@@ -276,3 +279,326 @@ TEST(DomTree, example4) {
     check(bb8N.begin(), bb8N.end(), bbs[8], false);
   }
 }
+
+TEST(DomTree, idoms) {
+  auto function = example2();
+  auto graph = function.getBasicBlocks();
+  auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+
+  std::vector<BasicBlock *> bbs;
+  for (auto &&bb : graph.nodes()) {
+    bbs.push_back(&bb);
+  }
+
+  EXPECT_EQ(domTree.getRoot(), bbs[0]);
+  EXPECT_EQ(domTree.getIdom(bbs[0]), nullptr);
+  std::array<std::size_t, 7> idoms = {0, 0, 1, 4, 1, 1, 4};
+  for (std::size_t i = 1; i < bbs.size(); ++i) {
+    EXPECT_EQ(domTree.getIdom(bbs[i]), bbs[idoms[i]]);
+  }
+  EXPECT_EQ(domTree.getNode(bbs[4])->numChildren(), 2);
+
+  // children intervals nest in the parent one
+  for (auto *bb : bbs) {
+    auto *node = domTree.getNode(bb);
+    EXPECT_EQ(node->getBlock(), bb);
+    for (auto *child : node->children()) {
+      EXPECT_EQ(child->getIdom(), node);
+      EXPECT_LT(node->getDFSIn(), child->getDFSIn());
+      EXPECT_LE(child->getDFSOut(), node->getDFSOut());
+    }
+  }
+  EXPECT_TRUE(domTree.strictlyDominate(bbs[1], bbs[6]));
+  EXPECT_FALSE(domTree.strictlyDominate(bbs[1], bbs[1]));
+}
+
+TEST(DomTree, unreachable) {
+  auto function = Function{};
+  std::array<BasicBlock *, 4> bbs;
+  for (auto &bb : bbs) {
+    bb = function.create<BasicBlock>();
+  }
+  bbs[0]->addSuccessor(bbs[1]);
+  bbs[0]->addSuccessor(bbs[2]);
+  bbs[1]->addSuccessor(bbs[2]);
+  // bb3 -> bb2, nothing reaches bb3
+  bbs[3]->addSuccessor(bbs[2]);
+
+  auto graph = function.getBasicBlocks();
+  auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+  EXPECT_FALSE(domTree.isReachable(bbs[3]));
+  EXPECT_EQ(domTree.getNode(bbs[3]), nullptr);
+  EXPECT_EQ(domTree.size(), 3);
+  EXPECT_EQ(domTree.getIdom(bbs[2]), bbs[0]);
+  EXPECT_TRUE(domTree.dominate(bbs[3], bbs[3]));
+  EXPECT_FALSE(domTree.dominate(bbs[3], bbs[2]));
+  EXPECT_FALSE(domTree.dominate(bbs[0], bbs[3]));
+}
+
+namespace {
+
+// nodes reachable from the entry when skip is removed
+std::vector<bool> reachableWithout(const std::vector<BasicBlock *> &bbs,
+                                   BasicBlock *skip) {
+  std::vector<bool> seen(bbs.size());
+  std::vector<BasicBlock *> worklist;
+  if (bbs[0] != skip) {
+    worklist.push_back(bbs[0]);
+    seen[0] = true;
+  }
+  while (!worklist.empty()) {
+    auto *bb = worklist.back();
+    worklist.pop_back();
+    for (auto *succ : bb->successors()) {
+      if (succ != skip && !seen[succ->getId()]) {
+        seen[succ->getId()] = true;
+        worklist.push_back(succ);
+      }
+    }
+  }
+  return seen;
+}
+
+} // namespace
+
+// a dominates b iff b can not be reached once a is removed
+TEST(DomTree, bruteForce) {
+  std::mt19937 gen(17);
+  for (int round = 0; round < 20; ++round) {
+    auto function = Function{};
+    std::vector<BasicBlock *> bbs;
+    for (int i = 0; i < 30; ++i) {
+      bbs.push_back(function.create<BasicBlock>());
+    }
+    std::uniform_int_distribution<std::size_t> dist(0, bbs.size() - 1);
+    for (std::size_t i = 0; i < bbs.size(); ++i) {
+      for (int edge = 0; edge < 2; ++edge) {
+        bbs[i]->addSuccessor(bbs[dist(gen)]);
+      }
+    }
+
+    auto graph = function.getBasicBlocks();
+    auto reachable = reachableWithout(bbs, nullptr);
+    for (auto algo : {DomTreeAlgo::LengauerTarjan, DomTreeAlgo::SemiNCA}) {
+      auto domTree = DominatorTreeBuilder<BasicBlocksGraph>(algo).build(graph);
+      for (auto *lhs : bbs) {
+        auto without = reachableWithout(bbs, lhs);
+        for (auto *rhs : bbs) {
+          auto expected = lhs == rhs || (reachable[lhs->getId()] &&
+                                         reachable[rhs->getId()] &&
+                                         !without[rhs->getId()]);
+          ASSERT_EQ(domTree.dominate(lhs, rhs), expected)
+              << lhs->getId() << " dom " << rhs->getId();
+        }
+      }
+    }
+  }
+}
+
+// Both algorithms agree on bigger graphs with loops, and a builder can be
+// reused.
+TEST(DomTree, algorithms) {
+  std::mt19937 gen(3);
+  auto lt = DominatorTreeBuilder<BasicBlocksGraph>(DomTreeAlgo::LengauerTarjan);
+  auto snca = DominatorTreeBuilder<BasicBlocksGraph>(DomTreeAlgo::SemiNCA);
+  for (std::size_t size : {1, 10, 1000}) {
+    auto function = Function{};
+    std::vector<BasicBlock *> bbs;
+    for (std::size_t i = 0; i < size; ++i) {
+      bbs.push_back(function.create<BasicBlock>());
+    }
+    std::uniform_int_distribution<std::size_t> dist(0, size - 1);
+    for (std::size_t i = 0; i + 1 < size; ++i) {
+      bbs[i]->addSuccessor(bbs[i + 1]);
+      bbs[i]->addSuccessor(bbs[dist(gen)]);
+    }
+
+    auto graph = function.getBasicBlocks();
+    auto ltTree = lt.build(graph);
+    auto sncaTree = snca.build(graph);
+    EXPECT_EQ(ltTree.size(), size);
+    for (auto *bb : bbs) {
+      EXPECT_EQ(ltTree.getIdom(bb), sncaTree.getIdom(bb));
+    }
+  }
+}
+
+// A long chain would overflow the stack of a recursive builder.
+TEST(DomTree, deepChain) {
+  constexpr std::size_t kSize = 200000;
+  auto function = Function{};
+  std::vector<BasicBlock *> bbs;
+  for (std::size_t i = 0; i < kSize; ++i) {
+    bbs.push_back(function.create<BasicBlock>());
+  }
+  for (std::size_t i = 0; i + 1 < kSize; ++i) {
+    bbs[i]->addSuccessor(bbs[i + 1]);
+  }
+  // a back edge from the end, the chain is still the tree
+  bbs.back()->addSuccessor(bbs[1]);
+
+  auto graph = function.getBasicBlocks();
+  for (auto algo : {DomTreeAlgo::LengauerTarjan, DomTreeAlgo::SemiNCA}) {
+    auto domTree = DominatorTreeBuilder<BasicBlocksGraph>(algo).build(graph);
+    EXPECT_EQ(domTree.getIdom(bbs.back()), bbs[kSize - 2]);
+    EXPECT_EQ(domTree.getIdom(bbs[1]), bbs[0]);
+    EXPECT_TRUE(domTree.dominate(bbs[1], bbs.back()));
+    EXPECT_FALSE(domTree.dominate(bbs.back(), bbs[1]));
+  }
+}
+
+// Subtree slices match the generic walks over the tree as a graph.
+TEST(DomTree, walks) {
+  using TreeTy = DomTree<BasicBlocksGraph>;
+  using NodeTy = TreeTy::DomTreeNodeTy *;
+
+  auto function = example3();
+  auto graph = function.getBasicBlocks();
+  auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+
+  auto preorder = std::vector<NodeTy>(domTree.preorder().begin(),
+                                       domTree.preorder().end());
+  auto dfs = std::vector<NodeTy>(DFSIterator<TreeTy>::begin(domTree),
+                                 DFSIterator<TreeTy>::end(domTree));
+  EXPECT_EQ(preorder, dfs);
+  EXPECT_EQ(preorder.size(), graph.size());
+  auto postorder = std::vector<NodeTy>(domTree.postorder().begin(),
+                                       domTree.postorder().end());
+  EXPECT_EQ(postorder, PostOrderIterator<TreeTy>::collect(domTree));
+
+  for (auto *node : domTree.preorder()) {
+    auto sub = domTree.preorder(node);
+    auto subDfs = std::vector<NodeTy>(DFSIterator<TreeTy>(node), {});
+    EXPECT_EQ(std::vector<NodeTy>(sub.begin(), sub.end()), subDfs);
+    auto subPost = domTree.postorder(node);
+    EXPECT_EQ(std::vector<NodeTy>(subPost.begin(), subPost.end()),
+              PostOrderIterator<TreeTy>::collect(node));
+    // the walks cover exactly the dominated blocks
+    for (auto *other : domTree.preorder()) {
+      auto inSub = std::find(sub.begin(), sub.end(), other) != sub.end();
+      EXPECT_EQ(inSub, domTree.dominate(node->getBlock(), other->getBlock()));
+    }
+
+    using Traits = GraphTraits<TreeTy>;
+    auto idoms = std::vector<NodeTy>(Traits::inEdgeBegin(node),
+                                     Traits::inEdgeEnd(node));
+    if (node == domTree.getRootNode()) {
+      EXPECT_TRUE(idoms.empty());
+    } else {
+      EXPECT_EQ(idoms, std::vector<NodeTy>{node->getIdom()});
+    }
+  }
+}
+
+namespace {
+
+// the tree matches one built from scratch
+void expectFresh(const DomTree<BasicBlocksGraph> &domTree, Function &function) {
+  auto graph = function.getBasicBlocks();
+  auto fresh = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+  ASSERT_EQ(domTree.size(), fresh.size());
+  for (auto &bb : function) {
+    ASSERT_EQ(domTree.isReachable(&bb), fresh.isReachable(&bb))
+        << bb.getId();
+    ASSERT_EQ(domTree.getIdom(&bb), fresh.getIdom(&bb)) << bb.getId();
+  }
+  for (auto *node : domTree.preorder()) {
+    for (auto *child : node->children()) {
+      ASSERT_EQ(child->getLevel(), node->getLevel() + 1);
+    }
+  }
+}
+
+// a random edge of the CFG
+std::pair<BasicBlock *, BasicBlock *>
+pickEdge(const std::vector<BasicBlock *> &bbs, std::mt19937 &gen) {
+  while (true) {
+    auto *bb = bbs[gen() % bbs.size()];
+    auto succs = bb->collectSuccessors();
+    if (!succs.empty()) {
+      return {bb, succs[gen() % succs.size()]};
+    }
+  }
+}
+
+} // namespace
+
+// Every edit of the CFG reaches the tree through the listener, new blocks
+// included.
+TEST(DomTree, listener) {
+  std::mt19937 gen(23);
+  for (int round = 0; round < 10; ++round) {
+    auto function = Function{};
+    std::vector<BasicBlock *> bbs;
+    for (int i = 0; i < 40; ++i) {
+      bbs.push_back(function.create<BasicBlock>());
+    }
+    for (std::size_t i = 0; i < bbs.size(); ++i) {
+      bbs[i]->addSuccessor(bbs[gen() % bbs.size()]);
+    }
+
+    auto graph = function.getBasicBlocks();
+    auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+    DomTreeListener listener{function, domTree};
+    EXPECT_EQ(function.getCFGListener(), &listener);
+    for (int step = 0; step < 100; ++step) {
+      switch (gen() % 5) {
+      case 0:
+      case 1: {
+        auto [from, to] = pickEdge(bbs, gen);
+        from->removeSuccessor(to);
+        break;
+      }
+      case 2:
+        bbs.push_back(function.create<BasicBlock>());
+        bbs.back()->addSuccessor(bbs[gen() % bbs.size()]);
+        [[fallthrough]];
+      default:
+        bbs[gen() % bbs.size()]->addSuccessor(bbs[gen() % bbs.size()]);
+        break;
+      }
+      ASSERT_NO_FATAL_FAILURE(expectFresh(domTree, function)) << step;
+    }
+  }
+}
+
+// A batch is replayed against the CFG that already holds all of it.
+TEST(DomTree, batchUpdates) {
+  using UpdateTy = DomTree<BasicBlocksGraph>::UpdateTy;
+  std::mt19937 gen(29);
+  auto function = Function{};
+  std::vector<BasicBlock *> bbs;
+  for (int i = 0; i < 300; ++i) {
+    bbs.push_back(function.create<BasicBlock>());
+  }
+  for (std::size_t i = 0; i + 1 < bbs.size(); ++i) {
+    bbs[i]->addSuccessor(bbs[i + 1]);
+    bbs[i]->addSuccessor(bbs[gen() % bbs.size()]);
+  }
+  auto graph = function.getBasicBlocks();
+  auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+
+  for (int round = 0; round < 50; ++round) {
+    std::vector<UpdateTy> updates;
+    for (int i = 0; i < 6; ++i) {
+      if (gen() % 2) {
+        auto [from, to] = pickEdge(bbs, gen);
+        from->removeSuccessor(to);
+        updates.push_back({UpdateTy::Delete, from, to});
+      } else {
+        auto *from = bbs[gen() % bbs.size()];
+        auto *to = bbs[gen() % bbs.size()];
+        from->addSuccessor(to);
+        updates.push_back({UpdateTy::Insert, from, to});
+      }
+    }
+    domTree.applyUpdates(updates);
+    ASSERT_NO_FATAL_FAILURE(expectFresh(domTree, function)) << round;
+  }
+
+  // the listener is gone with its scope
+  {
+    DomTreeListener listener{function, domTree};
+  }
+  EXPECT_EQ(function.getCFGListener(), nullptr);
+}
@@ -163,3 +163,17 @@ Function example7() {
 
   return function;
 }
+
+Function deepChain(std::size_t n) {
+  auto function = Function{};
+
+  auto *prev = function.create<BasicBlock>();
+  for (std::size_t i = 1; i < n; ++i) {
+    auto *bb = function.create<BasicBlock>();
+    prev->create<GotoInstr>(bb);
+    prev = bb;
+  }
+  prev->create<RetInstr>();
+
+  return function;
+}
@@ -159,3 +159,8 @@ jade::Function example6();
 //                |  7  |-------------------|
 //                +-----+
 jade::Function example7();
+
+//    +-----+     +-----+           +-------+
+//    |  0  |---->|  1  |--> ... -->| n - 1 |
+//    +-----+     +-----+           +-------+
+jade::Function deepChain(std::size_t n);
@@ -0,0 +1,168 @@
+#include "ilist.hh"
+#include "IR.hh"
+#include "function.hh"
+#include "gtest/gtest.h"
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+using namespace jade;
+
+namespace {
+
+struct Node : IListNode {
+  Node(int v) : val(v) {}
+  int val;
+};
+
+using List = IList<Node, IListBorrower<Node>>;
+
+std::vector<int> values(const List &list) {
+  std::vector<int> ret;
+  for (auto &&node : list) {
+    ret.push_back(node.val);
+  }
+  return ret;
+}
+
+std::vector<int> reversed(const List &list) {
+  std::vector<int> ret;
+  for (auto it = list.rbegin(); it != list.rend(); ++it) {
+    ret.push_back(it->val);
+  }
+  return ret;
+}
+
+// copies would share or leak the nodes, views come from borrow()
+static_assert(!std::is_copy_constructible_v<List>);
+static_assert(!std::is_copy_assignable_v<IList<Node, IListOwner<Node>>>);
+static_assert(!std::is_copy_constructible_v<BasicBlock>);
+static_assert(std::is_move_constructible_v<List>);
+static_assert(std::is_copy_constructible_v<IListView<Node>>);
+
+} // namespace
+
+TEST(IList, InsertRemove) {
+  std::vector<Node> nodes{0, 1, 2, 3, 4};
+  auto list = List{};
+  EXPECT_TRUE(list.empty());
+  EXPECT_EQ(list.size(), 0);
+  EXPECT_EQ(list.getFirst(), nullptr);
+  EXPECT_EQ(list.getLast(), nullptr);
+
+  list.push_back(&nodes[1]);
+  list.push_back(&nodes[3]);
+  list.push_front(&nodes[0]);
+  list.insertBefore(List::iterator{&nodes[3]}, &nodes[2]);
+  list.insertAfter(List::iterator{&nodes[3]}, &nodes[4]);
+  EXPECT_EQ(values(list), (std::vector<int>{0, 1, 2, 3, 4}));
+  EXPECT_EQ(reversed(list), (std::vector<int>{4, 3, 2, 1, 0}));
+  EXPECT_EQ(list.size(), 5);
+  EXPECT_EQ(list.getFirst(), &nodes[0]);
+  EXPECT_EQ(list.getLast(), &nodes[4]);
+  EXPECT_EQ(nodes[0].getPrev(), nullptr);
+  EXPECT_EQ(nodes[4].getNext(), nullptr);
+
+  list.remove(&nodes[0]);
+  list.remove(&nodes[4]);
+  list.remove(&nodes[2]);
+  EXPECT_EQ(values(list), (std::vector<int>{1, 3}));
+  EXPECT_EQ(list.size(), 2);
+  EXPECT_EQ(nodes[1].getPrev(), nullptr);
+  EXPECT_EQ(nodes[3].getNext(), nullptr);
+
+  // views share the head: they see later changes
+  auto view = list.borrow();
+  list.push_back(&nodes[4]);
+  EXPECT_EQ(view.size(), 3);
+  EXPECT_EQ(view.getLast(), &nodes[4]);
+}
+
+TEST(IList, Splice) {
+  std::vector<Node> nodes{0, 1, 2, 3, 4, 5, 6};
+  auto lhs = List{};
+  auto rhs = List{};
+  for (int i = 0; i < 3; ++i) {
+    lhs.push_back(&nodes[i]);
+  }
+  for (int i = 3; i < 7; ++i) {
+    rhs.push_back(&nodes[i]);
+  }
+
+  // [4, 6) in the middle of lhs, length given
+  lhs.splice(List::iterator{&nodes[1]}, rhs, List::iterator{&nodes[4]},
+             rhs.end(), 3);
+  EXPECT_EQ(values(lhs), (std::vector<int>{0, 4, 5, 6, 1, 2}));
+  EXPECT_EQ(values(rhs), (std::vector<int>{3}));
+  EXPECT_EQ(lhs.size(), 6);
+  EXPECT_EQ(rhs.size(), 1);
+
+  // unknown length: sizes are recounted
+  rhs.splice(rhs.begin(), lhs, lhs.begin(), List::iterator{&nodes[1]});
+  EXPECT_EQ(values(rhs), (std::vector<int>{0, 4, 5, 6, 3}));
+  EXPECT_EQ(reversed(lhs), (std::vector<int>{2, 1}));
+  EXPECT_EQ(lhs.size(), 2);
+  EXPECT_EQ(rhs.size(), 5);
+
+  // within one list
+  rhs.splice(rhs.end(), rhs, rhs.begin(), List::iterator{&nodes[5]});
+  EXPECT_EQ(values(rhs), (std::vector<int>{5, 6, 3, 0, 4}));
+  EXPECT_EQ(rhs.size(), 5);
+
+  lhs.splice(lhs.end(), rhs);
+  EXPECT_TRUE(rhs.empty());
+  EXPECT_EQ(values(lhs), (std::vector<int>{1, 2, 5, 6, 3, 0, 4}));
+  EXPECT_EQ(lhs.size(), 7);
+}
+
+TEST(IList, Move) {
+  std::vector<Node> nodes{0, 1, 2};
+  auto list = List{};
+  for (auto &node : nodes) {
+    list.push_back(&node);
+  }
+
+  auto moved = std::move(list);
+  EXPECT_TRUE(list.empty());
+  EXPECT_EQ(values(moved), (std::vector<int>{0, 1, 2}));
+  EXPECT_EQ(reversed(moved), (std::vector<int>{2, 1, 0}));
+  EXPECT_EQ(moved.size(), 3);
+
+  list = std::move(moved);
+  EXPECT_TRUE(moved.empty());
+  EXPECT_EQ(values(list), (std::vector<int>{0, 1, 2}));
+  list = List{};
+  EXPECT_TRUE(list.empty());
+}
+
+TEST(IList, SpliceBlocks) {
+  auto fn = Function{};
+  auto *bb0 = fn.create<BasicBlock>();
+  auto *bb1 = fn.create<BasicBlock>();
+  auto *v0 = bb0->create<ConstI64>(1);
+  auto *v1 = bb0->create<ConstI64>(2);
+  auto *phi = bb0->create<PhiInstr>(Type::create<Type::I64>());
+  auto *ret = bb0->create<RetInstr>(v0);
+  auto id = v1->getId();
+
+  bb1->splice(bb1->end(), bb0, v1);
+  EXPECT_EQ(&*bb0->begin(), v0);
+  EXPECT_EQ(v0->next(), nullptr);
+  EXPECT_EQ(&*bb1->begin(), v1);
+  EXPECT_EQ(&*bb1->rbegin(), ret);
+  EXPECT_EQ(phi->getParent(), bb1);
+  EXPECT_EQ(v1->getId(), id);
+  EXPECT_EQ(bb0->phis().begin(), bb0->phis().end());
+  EXPECT_EQ(*bb1->phis().begin(), phi);
+
+  // instructions of another function get ids of this one
+  auto other = Function{};
+  auto *otherBB = other.create<BasicBlock>();
+  auto *c = otherBB->create<ConstI64>(3);
+  auto numValues = fn.numValues();
+  bb0->splice(bb0->end(), otherBB, c);
+  EXPECT_TRUE(otherBB->empty());
+  EXPECT_EQ(c->getParent(), bb0);
+  EXPECT_EQ(c->getId(), numValues);
+  EXPECT_EQ(v0->next(), c);
+}
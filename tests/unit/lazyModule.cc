@@ -0,0 +1,160 @@
+#include "lazyModule.hh"
+#include "IR.hh"
+#include "PM.hh"
+#include "callGraph.hh"
+#include "function.hh"
+#include "inline.hh"
+#include "printer.hh"
+#include "serialize.hh"
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+
+using namespace jade;
+
+namespace {
+
+// inc(x) = x + 1
+void buildCallee(Function &callee) {
+  auto *bb0 = callee.create<BasicBlock>();
+  auto *x = bb0->create<ParamInstr>(Type::create<Type::I64>(), "x");
+  auto *one = bb0->create<ConstI64>(1, "one");
+  auto *sum = bb0->create<BinaryOp>(x, one, Opcode::ADD, "sum");
+  bb0->create<RetInstr>(sum);
+}
+
+// main() = inc(41) * 2
+void buildCaller(Function &caller, Function *callee) {
+  auto *bb0 = caller.create<BasicBlock>();
+  auto *bb1 = caller.create<BasicBlock>();
+  auto *v0 = bb0->create<ConstI64>(41, "v0");
+  auto *v1 = bb0->create<ConstI64>(2, "v1");
+  bb0->create<GotoInstr>(bb1);
+  auto *call = bb1->create<CallInstr>(callee, Type::create<Type::I64>(), "c");
+  call->addArg(v0);
+  auto *mul = bb1->create<BinaryOp>(call, v1, Opcode::MUL, "mul");
+  bb1->create<RetInstr>(mul);
+}
+
+std::string inlinedCaller() {
+  auto callee = Function{"inc"};
+  buildCallee(callee);
+  auto caller = Function{"main"};
+  buildCaller(caller, &callee);
+
+  auto pm = PassManager(&caller);
+  pm.registerPass(std::make_unique<Inline>());
+  pm.run();
+  return toString(caller);
+}
+
+std::string encodeModule() {
+  auto callee = Function{"inc"};
+  buildCallee(callee);
+  auto caller = Function{"main"};
+  buildCaller(caller, &callee);
+
+  std::string data;
+  writeModule({&caller, &callee}, data);
+  return data;
+}
+
+} // namespace
+
+TEST(LazyModule, MaterializeOnDemand) {
+  auto data = encodeModule();
+  auto module = LazyModule::load(data);
+  ASSERT_NE(module, nullptr);
+  ASSERT_EQ(module->size(), 2);
+  ASSERT_EQ(module->numMaterialized(), 0);
+
+  auto *caller = module->getFunction("main");
+  auto *callee = module->getFunction("inc");
+  ASSERT_EQ(caller, module->getFunction(0));
+  ASSERT_FALSE(caller->isMaterialized());
+
+  ASSERT_TRUE(caller->materialize());
+  ASSERT_EQ(module->numMaterialized(), 1);
+  auto *bb1 = caller->begin()->next();
+  auto *call = static_cast<CallInstr *>(&*bb1->begin());
+  ASSERT_EQ(call->getCallee(), callee);
+  ASSERT_FALSE(callee->isMaterialized());
+
+  // Inline pulls the callee in
+  auto pm = PassManager(caller);
+  pm.registerPass(std::make_unique<Inline>());
+  pm.run();
+  ASSERT_TRUE(callee->isMaterialized());
+  ASSERT_EQ(toString(*caller), inlinedCaller());
+}
+
+TEST(LazyModule, CallGraph) {
+  auto data = encodeModule();
+  auto module = LazyModule::load(data);
+  ASSERT_NE(module, nullptr);
+
+  // calls are read from the records, no body is decoded
+  auto graph = CallGraph(*module);
+  ASSERT_EQ(module->numMaterialized(), 0);
+  auto caller = graph.getNode(module->getFunction("main"));
+  auto callee = graph.getNode(module->getFunction("inc"));
+  ASSERT_EQ(graph.callees(caller), std::vector<std::size_t>{callee});
+  ASSERT_EQ(graph.callers(callee), std::vector<std::size_t>{caller});
+  ASSERT_TRUE(graph.callees(callee).empty());
+  ASSERT_EQ(graph.sccOf(callee), 0);
+
+  // a dematerialized body is scanned from its new record
+  auto *fn = module->getFunction("main");
+  ASSERT_TRUE(fn->materialize());
+  fn->dematerialize();
+  std::vector<Function *> targets;
+  ASSERT_TRUE(fn->collectCallees(targets));
+  ASSERT_EQ(targets, std::vector<Function *>{module->getFunction("inc")});
+  ASSERT_EQ(module->numMaterialized(), 0);
+}
+
+TEST(LazyModule, Dematerialize) {
+  auto data = encodeModule();
+  auto module = LazyModule::load(data);
+  ASSERT_NE(module, nullptr);
+
+  auto *caller = module->getFunction("main");
+  auto *callee = module->getFunction("inc");
+  auto pm = PassManager(caller);
+  pm.registerPass(std::make_unique<Inline>());
+  pm.run();
+  // decoding numbers values in layout order
+  caller->renumber();
+  auto text = toString(*caller);
+
+  ASSERT_GT(module->materializedBytes(), 0);
+  module->trim(0);
+  ASSERT_EQ(module->numMaterialized(), 0);
+  ASSERT_EQ(module->materializedBytes(), 0);
+  ASSERT_EQ(caller->begin(), caller->end());
+
+  // the changed body survives the round trip, the oldest body goes first
+  ASSERT_TRUE(caller->materialize());
+  ASSERT_EQ(toString(*caller), text);
+  ASSERT_TRUE(callee->materialize());
+  module->trim(callee->getArena().bytesAllocated());
+  ASSERT_FALSE(caller->isMaterialized());
+  ASSERT_TRUE(callee->isMaterialized());
+}
+
+TEST(LazyModule, Errors) {
+  DecodeError error;
+  ASSERT_EQ(LazyModule::open("/nonexistent/jade.mod", &error), nullptr);
+
+  auto function = Function{"f"};
+  buildCallee(function);
+  std::string data;
+  writeBinary(function, data);
+  ASSERT_EQ(LazyModule::load(data, &error), nullptr);
+  ASSERT_EQ(error.message, "function instead of a module");
+
+  auto module = encodeModule();
+  ASSERT_EQ(LazyModule::load(module.substr(0, module.size() - 1), &error),
+            nullptr);
+  ASSERT_EQ(error.message, "record out of bounds");
+}
@@ -101,4 +101,63 @@ TEST(Liveness, Main) {
   CheckLiveIntervals(liveness.getLiveInterval(v9), LiveIn{26, 28});
   CheckLiveIntervals(liveness.getLiveInterval(v7), LiveIn{18, 24});
   CheckLiveIntervals(liveness.getLiveInterval(v8), LiveIn{20, 24});
+
+  // live sets by value id, phis are not live-in of their block
+  auto expectSet = [](const Liveness::LiveSet &actual,
+                      std::vector<Instruction *> expected) {
+    auto set = Liveness::LiveSet(actual.size());
+    for (auto *instr : expected) {
+      set.insert(instr->getId());
+    }
+    EXPECT_EQ(actual, set);
+  };
+  expectSet(liveness.getLiveOut(bbs[0]), {v0, v1, v2});
+  expectSet(liveness.getLiveIn(bbs[1]), {v0, v2});
+  expectSet(liveness.getLiveOut(bbs[1]), {v0, v2, v3, v4});
+  expectSet(liveness.getLiveIn(bbs[2]), {v0, v2, v3, v4});
+  expectSet(liveness.getLiveOut(bbs[2]), {v0, v2, v7, v8});
+  expectSet(liveness.getLiveIn(bbs[3]), {v2, v3});
+  expectSet(liveness.getLiveOut(bbs[3]), {});
+
+  // v3 is dead in bb2 after its use: a hole v8 fits in
+  using Segments = std::vector<std::pair<std::size_t, std::size_t>>;
+  auto segments = [&](Instruction *instr) {
+    auto ret = Segments{};
+    for (auto seg : liveness.getLiveRange(instr).segments()) {
+      ret.emplace_back(seg.begin, seg.end);
+    }
+    return ret;
+  };
+  EXPECT_EQ(segments(v0), (Segments{{2, 24}}));
+  EXPECT_EQ(segments(v1), (Segments{{4, 10}}));
+  EXPECT_EQ(segments(v3), (Segments{{10, 19}, {24, 27}}));
+  EXPECT_EQ(segments(v5), (Segments{{12, 15}}));
+  EXPECT_EQ(segments(v8), (Segments{{20, 24}}));
+
+  auto &v3Range = liveness.getLiveRange(v3);
+  EXPECT_TRUE(v3Range.covers(10));
+  EXPECT_TRUE(v3Range.covers(18));
+  EXPECT_FALSE(v3Range.covers(20));
+  EXPECT_TRUE(v3Range.covers(26));
+  EXPECT_FALSE(v3Range.covers(27));
+  EXPECT_FALSE(v3Range.intersects(liveness.getLiveRange(v8)));
+  EXPECT_EQ(v3Range.firstIntersection(liveness.getLiveRange(v9)), 26);
+  EXPECT_EQ(liveness.getLiveRange(v4).firstIntersection(
+                liveness.getLiveRange(v7)),
+            18);
+
+  using Uses = std::vector<std::pair<std::size_t, UsePosition::Kind>>;
+  auto uses = [&](Instruction *instr) {
+    auto ret = Uses{};
+    for (auto use : liveness.getLiveRange(instr).uses()) {
+      ret.emplace_back(use.pos, use.kind);
+    }
+    return ret;
+  };
+  EXPECT_EQ(uses(v0), (Uses{{9, UsePosition::Any},
+                            {12, UsePosition::Register},
+                            {20, UsePosition::Register}}));
+  EXPECT_EQ(uses(v3),
+            (Uses{{18, UsePosition::Register}, {26, UsePosition::Register}}));
+  EXPECT_EQ(uses(v8), (Uses{{23, UsePosition::Any}}));
 }
@@ -0,0 +1,88 @@
+#include "livenessChecker.hh"
+#include "IR.hh"
+#include "domTree.hh"
+#include "function.hh"
+#include "liveness.hh"
+#include "randomIR.hh"
+#include "gtest/gtest.h"
+#include <random>
+#include <vector>
+
+using namespace jade;
+
+namespace {
+
+void expectSameAsDataflow(Function &function, const LivenessChecker &checker) {
+  auto liveness = Liveness{function};
+  liveness.compute();
+  for (auto *value : function.rpo()) {
+    for (auto &instr : *value) {
+      for (auto *bb : function.rpo()) {
+        ASSERT_EQ(checker.isLiveIn(&instr, bb),
+                  liveness.getLiveIn(bb).test(instr.getId()))
+            << "live-in of " << instr.getId() << " at " << bb->getId();
+        ASSERT_EQ(checker.isLiveOut(&instr, bb),
+                  liveness.getLiveOut(bb).test(instr.getId()))
+            << "live-out of " << instr.getId() << " at " << bb->getId();
+      }
+    }
+  }
+}
+
+} // namespace
+
+// Against the dataflow sets on random CFGs: chains with forward branches
+// and loop latches are reducible, random edges mostly are not.
+TEST(LivenessChecker, Random) {
+  std::mt19937 gen(23);
+  std::size_t reducible = 0;
+  std::size_t irreducible = 0;
+  for (int round = 0; round < 40; ++round) {
+    auto function = Function{};
+    std::vector<BasicBlock *> bbs;
+    for (int i = 0; i < 25; ++i) {
+      bbs.push_back(function.create<BasicBlock>());
+    }
+    auto structured = round % 2 == 0;
+    std::uniform_int_distribution<std::size_t> dist(0, bbs.size() - 1);
+    for (std::size_t i = 0; i + 1 < bbs.size(); ++i) {
+      if (!structured) {
+        bbs[i]->addSuccessor(bbs[dist(gen)]);
+        bbs[i]->addSuccessor(bbs[dist(gen)]);
+        continue;
+      }
+      bbs[i]->addSuccessor(bbs[i + 1]);
+      auto kind = gen() % 4;
+      if (kind == 0) {
+        bbs[i]->addSuccessor(bbs[std::min(bbs.size() - 1, i + 2 + gen() % 4)]);
+      } else if (kind == 1) {
+        // latch of a loop from the header that dominates it
+        auto *header = bbs[i - std::min<std::size_t>(i, gen() % 5)];
+        auto graph = function.getBasicBlocks();
+        auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+        if (domTree.dominate(header, bbs[i])) {
+          bbs[i]->addSuccessor(header);
+        }
+      }
+    }
+
+    auto graph = function.getBasicBlocks();
+    auto domTree = DominatorTreeBuilder<BasicBlocksGraph>().build(graph);
+    fillBody(function, domTree, gen);
+    auto checker = LivenessChecker{function, domTree};
+    ++(checker.isReducible() ? reducible : irreducible);
+    EXPECT_TRUE(!structured || checker.isReducible());
+    expectSameAsDataflow(function, checker);
+
+    // new uses far from their defs: the checker reads uses when asked
+    std::vector<BasicBlock *> reachable(function.rpo());
+    for (int edit = 0; edit < 10; ++edit) {
+      auto *bb = reachable[gen() % reachable.size()];
+      auto *value = pick(available(domTree, bb), gen);
+      bb->create<BinaryOp>(value, value, Opcode::ADD);
+    }
+    expectSameAsDataflow(function, checker);
+  }
+  EXPECT_GT(reducible, 0);
+  EXPECT_GT(irreducible, 0);
+}
@@ -5,6 +5,7 @@
 #include "gtest/gtest.h"
 #include <array>
 #include <iostream>
+#include <set>
 #include <vector>
 
 using namespace jade;
@@ -12,17 +13,20 @@ using namespace jade;
 using Loop = LoopTreeNode<BasicBlocksGraph>;
 
 bool checkBackEdges(Loop *loop, std::set<BasicBlock *> expected) {
-  auto actual = loop->getBackEdges();
+  auto &&backEdges = loop->getBackEdges();
+  auto actual = std::set<BasicBlock *>(backEdges.begin(), backEdges.end());
   return actual == expected;
 }
 
 bool checkBody(Loop *loop, std::set<BasicBlock *> expected) {
-  auto actual = loop->getNodes();
+  auto &&nodes = loop->getNodes();
+  auto actual = std::set<BasicBlock *>(nodes.begin(), nodes.end());
   return actual == expected;
 }
 
 bool checkInnerLoops(Loop *loop, std::set<Loop *> expected) {
-  auto actual = loop->getInners();
+  auto &&inners = loop->getInners();
+  auto actual = std::set<Loop *>(inners.begin(), inners.end());
   return actual == expected;
 }
 
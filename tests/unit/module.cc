@@ -0,0 +1,194 @@
+#include "module.hh"
+#include "IR.hh"
+#include "PM.hh"
+#include "callGraph.hh"
+#include "constFolding.hh"
+#include "dce.hh"
+#include "function.hh"
+#include "inline.hh"
+#include "printer.hh"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace jade;
+
+namespace {
+
+// name(x) = callees...(x) + 1, the result of every call is summed up
+Function *addFunction(Module &module, std::string name,
+                      const std::vector<Function *> &callees) {
+  auto *fn = module.create(std::move(name));
+  auto *bb0 = fn->create<BasicBlock>();
+  Instruction *acc = bb0->create<ParamInstr>(Type::create<Type::I64>(), "x");
+  auto *one = bb0->create<ConstI64>(1, "one");
+  for (auto *callee : callees) {
+    auto *call = bb0->create<CallInstr>(callee, Type::create<Type::I64>());
+    call->addArg(acc);
+    acc = bb0->create<BinaryOp>(acc, call, Opcode::ADD);
+  }
+  auto *sum = bb0->create<BinaryOp>(acc, one, Opcode::ADD, "sum");
+  bb0->create<RetInstr>(sum);
+  return fn;
+}
+
+// main() = callee(41) * 2
+Function *addMain(Module &module, std::string name, Function *callee) {
+  auto *fn = module.create(std::move(name));
+  auto *bb0 = fn->create<BasicBlock>();
+  auto *bb1 = fn->create<BasicBlock>();
+  auto *v0 = bb0->create<ConstI64>(41, "v0");
+  auto *v1 = bb0->create<ConstI64>(2, "v1");
+  bb0->create<GotoInstr>(bb1);
+  auto *call = bb1->create<CallInstr>(callee, Type::create<Type::I64>(), "c");
+  call->addArg(v0);
+  auto *mul = bb1->create<BinaryOp>(call, v1, Opcode::MUL, "mul");
+  bb1->create<RetInstr>(mul);
+  return fn;
+}
+
+void buildPipeline(PassManager &pm) {
+  pm.registerPass(std::make_unique<Inline>());
+  pm.registerPass(std::make_unique<ConstantFolder>());
+  pm.registerPass(std::make_unique<DCE>());
+}
+
+// A leaf shared by many callers and a few levels of calls on top of it.
+void buildWideModule(Module &module) {
+  auto *inc = addFunction(module, "inc", {});
+  std::vector<Function *> level;
+  for (int i = 0; i < 32; ++i) {
+    level.push_back(addFunction(module, "f" + std::to_string(i), {inc, inc}));
+  }
+  for (int i = 0; i < 32; ++i) {
+    auto *g = addFunction(module, "g" + std::to_string(i),
+                          {level[i], level[(i + 1) % 32]});
+    addMain(module, "main" + std::to_string(i), g);
+  }
+}
+
+std::vector<std::string> dumpModule(const Module &module) {
+  std::vector<std::string> text;
+  for (auto &&fn : module) {
+    fn->renumber();
+    text.push_back(toString(*fn));
+  }
+  return text;
+}
+
+struct Recorder : Pass {
+  Recorder(std::mutex &lock, std::vector<std::string> &order)
+      : m_lock(lock), m_order(order) {}
+
+  void run(Function *fn) override {
+    std::lock_guard guard{m_lock};
+    m_order.push_back(fn->getName());
+  }
+
+  std::mutex &m_lock;
+  std::vector<std::string> &m_order;
+};
+
+} // namespace
+
+TEST(Module, Names) {
+  auto module = Module{};
+  auto *foo = module.create("foo");
+  ASSERT_NE(foo, nullptr);
+  EXPECT_EQ(module.create("foo"), nullptr);
+  EXPECT_NE(module.add(std::make_unique<Function>("bar")), nullptr);
+
+  EXPECT_EQ(module.size(), 2);
+  EXPECT_EQ(module.getFunction("foo"), foo);
+  EXPECT_EQ(module.getFunction(1)->getName(), "bar");
+  EXPECT_EQ(module.getFunction("baz"), nullptr);
+}
+
+TEST(CallGraph, SCCs) {
+  auto module = Module{};
+  auto *leaf = addFunction(module, "leaf", {});
+  auto *a = addFunction(module, "a", {leaf, leaf});
+  auto *b = addFunction(module, "b", {leaf});
+  // even <-> odd, self calls itself
+  auto *even = module.create("even");
+  auto *odd = addFunction(module, "odd", {even, leaf});
+  auto *bb = even->create<BasicBlock>();
+  auto *x = bb->create<ParamInstr>(Type::create<Type::I64>(), "x");
+  auto *call = bb->create<CallInstr>(odd, Type::create<Type::I64>());
+  call->addArg(x);
+  bb->create<RetInstr>(call);
+  auto *self = module.create("self");
+  bb = self->create<BasicBlock>();
+  x = bb->create<ParamInstr>(Type::create<Type::I64>(), "x");
+  call = bb->create<CallInstr>(self, Type::create<Type::I64>());
+  call->addArg(x);
+  bb->create<RetInstr>(call);
+  auto *main = addFunction(module, "main", {a, b, even, self});
+
+  auto graph = CallGraph(module);
+  ASSERT_EQ(graph.size(), 7);
+  auto node = [&](Function *fn) { return graph.getNode(fn); };
+  auto scc = [&](Function *fn) { return graph.sccOf(node(fn)); };
+
+  EXPECT_EQ(graph.callees(node(a)), std::vector<std::size_t>{node(leaf)});
+  EXPECT_EQ(graph.callers(node(leaf)).size(), 3);
+  EXPECT_EQ(graph.callees(node(self)), std::vector<std::size_t>{node(self)});
+
+  EXPECT_EQ(graph.sccs().size(), 6);
+  EXPECT_EQ(scc(even), scc(odd));
+  EXPECT_EQ(graph.sccs()[scc(even)].size(), 2);
+  for (auto *fn : {a, b, odd}) {
+    EXPECT_LT(scc(leaf), scc(fn));
+  }
+  for (auto *fn : {a, b, even, self}) {
+    EXPECT_LT(scc(fn), scc(main));
+  }
+  EXPECT_EQ(graph.getNode(nullptr), CallGraph::kNone);
+}
+
+TEST(ModulePassManager, BottomUp) {
+  auto module = Module{};
+  buildWideModule(module);
+  auto graph = CallGraph(module);
+
+  std::mutex lock;
+  std::vector<std::string> order;
+  auto mpm = ModulePassManager(module, [&](PassManager &pm) {
+    pm.registerPass(std::make_unique<Recorder>(lock, order));
+  });
+  mpm.run(4);
+
+  ASSERT_EQ(order.size(), module.size());
+  auto position = [&](const Function *fn) {
+    return std::find(order.begin(), order.end(), fn->getName()) -
+           order.begin();
+  };
+  for (std::size_t node = 0; node < graph.size(); ++node) {
+    for (auto callee : graph.callees(node)) {
+      EXPECT_LT(position(graph.getFunction(callee)),
+                position(graph.getFunction(node)));
+    }
+  }
+}
+
+TEST(ModulePassManager, ParallelMatchesSerial) {
+  auto serial = Module{};
+  buildWideModule(serial);
+  ModulePassManager(serial, buildPipeline).run(1);
+
+  auto parallel = Module{};
+  buildWideModule(parallel);
+  ModulePassManager(parallel, buildPipeline).run(8);
+
+  EXPECT_EQ(dumpModule(serial), dumpModule(parallel));
+
+  // callees had their own calls inlined before main0 copied them
+  auto *main = parallel.getFunction("main0");
+  for (auto &&bb : *main) {
+    for (auto &&instr : bb) {
+      EXPECT_NE(instr.getOpcode(), Opcode::CALL);
+    }
+  }
+}
@@ -0,0 +1,62 @@
+#include "IR.hh"
+#include "PM.hh"
+#include "dce.hh"
+#include "function.hh"
+#include "opcodes.hh"
+#include "gtest/gtest.h"
+#include <memory>
+
+using namespace jade;
+
+TEST(Opcodes, Properties) {
+  ASSERT_EQ(OpcodeToStr(Opcode::ZeroCheck), "ZeroCheck");
+  ASSERT_EQ(getOpcodeInfo(Opcode::ADD).arity, 2);
+  ASSERT_EQ(getOpcodeInfo(Opcode::PHI).arity, kVariadic);
+  ASSERT_EQ(getOpcodeInfo(Opcode::LE).result, ResultRule::Bool);
+
+  ASSERT_TRUE(isCommutative(Opcode::MUL));
+  ASSERT_FALSE(isCommutative(Opcode::SUB));
+  ASSERT_TRUE(isTerminator(Opcode::RET));
+  ASSERT_FALSE(isTerminator(Opcode::CALL));
+  ASSERT_TRUE(hasSideEffects(Opcode::CALL));
+  ASSERT_TRUE(isFoldable(Opcode::NEG));
+  ASSERT_FALSE(isFoldable(Opcode::CONST));
+
+  ASSERT_EQ(Type(Type::I1).getName(), "i1");
+  ASSERT_EQ(Type(Type::None).getName(), "none");
+}
+
+TEST(Opcodes, DCEKeepsSideEffects) {
+  auto function = Function{};
+  auto pm = PassManager(&function);
+  pm.registerPass(std::make_unique<DCE>());
+
+  auto *bb0 = function.create<BasicBlock>();
+  auto *v0 = bb0->create<ParamInstr>(Type::create<Type::I32>(), "v0");
+  auto *v1 = bb0->create<ConstI32>(1, "v1");
+  auto *zc = bb0->create<UnaryOp>(v0, Opcode::ZeroCheck);
+  bb0->create<BinaryOp>(v0, v1, Opcode::ADD, "v2");
+  bb0->create<RetInstr>(v0);
+  pm.run();
+
+  // the unused add goes away, the unused check stays
+  ASSERT_EQ(v1->next(), zc);
+  ASSERT_EQ(zc->next()->getOpcode(), Opcode::RET);
+}
+
+TEST(Opcodes, DCEEmptyBlock) {
+  auto function = Function{};
+  auto pm = PassManager(&function);
+  pm.registerPass(std::make_unique<DCE>());
+
+  auto *bb0 = function.create<BasicBlock>();
+  auto *bb1 = function.create<BasicBlock>();
+  auto *v0 = bb0->create<ConstI32>(1, "v0");
+  bb0->create<ConstI32>(2, "v1");
+  bb0->create<RetInstr>(v0);
+  pm.run();
+
+  // the empty block is skipped, the unused constant goes away
+  ASSERT_TRUE(bb1->empty());
+  ASSERT_EQ(v0->next()->getOpcode(), Opcode::RET);
+}
@@ -0,0 +1,193 @@
+#include "parser.hh"
+#include "IR.hh"
+#include "function.hh"
+#include "module.hh"
+#include "printer.hh"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace jade;
+
+namespace {
+
+const char *kLoop = "bb0:\n"
+                    "  n: PARAM i32\n"
+                    "  zero: CONST i32 0\n"
+                    "  one: CONST i32 1\n"
+                    "  %3: GOTO none bb1\n"
+                    "\n"
+                    "bb1:\n"
+                    "  i: PHI i32 bb0 zero, bb2 next\n"
+                    "  cond: LE i1 i n\n"
+                    "  %6: IF none cond T:bb2 F:bb3\n"
+                    "\n"
+                    "bb2:\n"
+                    "  next: ADD i32 i one\n"
+                    "  %8: GOTO none bb1\n"
+                    "\n"
+                    "bb3:\n"
+                    "  %9: RET i32 i\n"
+                    "\n";
+
+Instruction *nth(BasicBlock *bb, std::size_t idx) {
+  auto it = bb->begin();
+  std::advance(it, idx);
+  return &*it;
+}
+
+} // namespace
+
+TEST(Parser, ForwardReferences) {
+  auto fn = parseIR(kLoop);
+  ASSERT_NE(fn, nullptr);
+  ASSERT_EQ(fn->numBlocks(), 4);
+
+  std::vector<BasicBlock *> bbs;
+  for (auto &&bb : *fn) {
+    bbs.push_back(&bb);
+  }
+  ASSERT_EQ(bbs[1]->getName(), "bb1");
+  ASSERT_EQ(bbs[1]->collectPredecessors(),
+            (std::vector<BasicBlock *>{bbs[0], bbs[2]}));
+  ASSERT_EQ(bbs[1]->collectSuccessors(),
+            (std::vector<BasicBlock *>{bbs[3], bbs[2]}));
+
+  auto *phi = static_cast<PhiInstr *>(nth(bbs[1], 0));
+  auto *next = nth(bbs[2], 0);
+  ASSERT_EQ(*bbs[1]->phis().begin(), phi);
+  ASSERT_EQ(phi->getOption(1).first, bbs[2]);
+  ASSERT_EQ(phi->getOption(1).second, next);
+  ASSERT_EQ(next->input(0), phi);
+  ASSERT_EQ(phi->numUsers(), 3);
+
+  ASSERT_EQ(toString(*fn), kLoop);
+}
+
+TEST(Parser, RoundTrip) {
+  auto function = Function{};
+  auto *bb0 = function.create<BasicBlock>();
+  auto *bb1 = function.create<BasicBlock>();
+
+  auto *v0 = bb0->create<ParamInstr>(Type::create<Type::I64>(), "v0");
+  auto *v1 = bb0->create<ConstI64>(-42, "v1");
+  auto *v2 = bb0->create<BinaryOp>(v0, v1, Opcode::MUL);
+  auto *v3 = bb0->create<CastInstr>(v2, Type::create<Type::I8>());
+  auto *v4 = bb0->create<UnaryOp>(v3, Opcode::ZeroCheck, "zc");
+  bb0->create<GotoInstr>(bb1);
+  auto *call = bb1->create<CallInstr>(nullptr, Type::create<Type::I8>());
+  call->addArg(v3);
+  call->addArg(v4);
+  bb1->create<RetInstr>(call);
+
+  auto text = toString(function);
+  auto parsed = parseIR(text);
+  ASSERT_NE(parsed, nullptr);
+  ASSERT_EQ(toString(*parsed), text);
+}
+
+TEST(Parser, Callee) {
+  Module module;
+  auto *callee = module.create("callee");
+  auto *entry = callee->create<BasicBlock>();
+  entry->create<RetInstr>(entry->create<ParamInstr>(Type::create<Type::I32>()));
+
+  auto function = Function{};
+  auto *bb0 = function.create<BasicBlock>();
+  auto *arg = bb0->create<ConstI32>(3, "arg");
+  auto *call = bb0->create<CallInstr>(callee, Type::create<Type::I32>(), "r");
+  call->addArg(arg);
+  bb0->create<RetInstr>(call);
+
+  auto text = toString(function);
+  ASSERT_NE(text.find("CALL i32 @callee arg"), std::string::npos);
+  auto parsed = parseIR(text, nullptr, &module);
+  ASSERT_NE(parsed, nullptr);
+  ASSERT_EQ(toString(*parsed), text);
+  auto *parsedCall = static_cast<CallInstr *>(nth(&*parsed->begin(), 1));
+  ASSERT_EQ(parsedCall->getCallee(), callee);
+
+  ParseError error;
+  ASSERT_EQ(parseIR(text, &error), nullptr);
+  ASSERT_EQ(error.message, "unknown function callee");
+}
+
+TEST(Parser, Errors) {
+  ParseError error;
+  ASSERT_EQ(parseIR("bb0:\n  v0: FOO i32\n", &error), nullptr);
+  ASSERT_EQ(error.line, 2);
+  // near misses of opcode and type names
+  for (auto *line : {"  v0: CAS i64 c\n", "  v0: CALX i32 null\n",
+                     "  v0: A i32\n", "  v0: PARAM i3\n",
+                     "  v0: PARAM i128\n", "  v0: PARAM nonE\n"}) {
+    ASSERT_EQ(parseIR(std::string{"bb0:\n  c: CONST i64 1\n"} + line, &error),
+              nullptr);
+    ASSERT_EQ(error.line, 3);
+  }
+
+  ASSERT_EQ(parseIR("bb0:\n  v0: CONST i32 1\n  v0: CONST i32 2\n", &error),
+            nullptr);
+  ASSERT_EQ(error.line, 3);
+
+  ASSERT_EQ(parseIR("bb0:\n  v1: NEG i32 v0\n  v2: RET i32 v1\n", &error),
+            nullptr);
+  ASSERT_EQ(error.line, 2);
+  ASSERT_EQ(error.message, "undefined value v0");
+
+  ASSERT_EQ(parseIR("bb0:\n  g: GOTO none bb7\n", &error), nullptr);
+  ASSERT_EQ(error.message, "undefined block bb7");
+}
+
+TEST(Parser, TypeErrors) {
+  ParseError error;
+  // forward reference used with one type, defined with another
+  ASSERT_EQ(parseIR("bb0:\n  v1: CAST i64 v0\n  v2: NEG i32 v0\n"
+                    "  v0: CONST i8 1\n",
+                    &error),
+            nullptr);
+  ASSERT_EQ(error.line, 4);
+
+  // comparison of two forward references of different types
+  ASSERT_EQ(parseIR("bb0:\n  c: EQ i1 a b\n  a: CONST i32 1\n"
+                    "  b: CONST i64 1\n",
+                    &error),
+            nullptr);
+  ASSERT_EQ(error.line, 2);
+  ASSERT_EQ(error.message, "operand type mismatch");
+
+  ASSERT_EQ(parseIR("bb0:\n  c: CONST i32 1\n  %1: IF none c T:bb0 F:bb0\n",
+                    &error),
+            nullptr);
+  ASSERT_EQ(error.line, 3);
+
+  ASSERT_EQ(parseIR("bb0:\n  c: CONST i32 1\n  %1: RET i64 c\n", &error),
+            nullptr);
+  ASSERT_EQ(error.line, 3);
+
+  ASSERT_EQ(parseIR("bb0:\n  c: CONST i32 1\n  n: NEG i8 c\n", &error),
+            nullptr);
+  ASSERT_EQ(error.line, 3);
+
+  ASSERT_EQ(parseIR("bb0:\n  c: CONST i32 1\n  d: ADD i64 c c\n", &error),
+            nullptr);
+  ASSERT_EQ(error.line, 3);
+}
+
+TEST(Parser, File) {
+  char path[] = "/tmp/jadeParserXXXXXX";
+  int fd = ::mkstemp(path);
+  ASSERT_GE(fd, 0);
+  std::string text = kLoop;
+  ASSERT_EQ(::write(fd, text.data(), text.size()), text.size());
+  ::close(fd);
+
+  auto fn = parseIRFile(path);
+  ::unlink(path);
+  ASSERT_NE(fn, nullptr);
+  ASSERT_EQ(toString(*fn), text);
+
+  ParseError error;
+  ASSERT_EQ(parseIRFile("/nonexistent/jade.ir", &error), nullptr);
+}
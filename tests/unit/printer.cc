@@ -0,0 +1,90 @@
+#include "printer.hh"
+#include "IR.hh"
+#include "function.hh"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using namespace jade;
+
+TEST(Printer, Function) {
+  auto function = Function{"f"};
+  auto *bb0 = function.create<BasicBlock>();
+  auto *bb1 = function.create<BasicBlock>();
+  auto *bb2 = function.create<BasicBlock>();
+
+  auto *v0 = bb0->create<ParamInstr>(Type::create<Type::I32>(), "v0");
+  auto *v1 = bb0->create<ConstI32>(-7, "v1");
+  auto *v2 = bb0->create<CmpInstr>(v0, v1, Opcode::LE, "v2");
+  bb0->create<IfInstr>(v2, bb2, bb1);
+
+  auto *v3 = bb1->create<CastInstr>(v0, Type::create<Type::I64>(), "v3");
+  auto *v4 = bb1->create<UnaryOp>(v1, Opcode::NEG);
+  bb1->create<GotoInstr>(bb2, "g");
+
+  auto *v5 = bb2->create<PhiInstr>(Type::create<Type::I32>(), "v5");
+  v5->addOption(v1, bb0);
+  v5->addOption(v4, bb1);
+  bb2->create<ConstI1>(true, "v6");
+  auto *v7 = bb2->create<CallInstr>(&function, Type::create<Type::I32>());
+  v7->addArg(v5);
+  v7->addArg(v3);
+  bb2->create<RetInstr>(v7, "r");
+
+  auto expected = std::string{"bb0:\n"
+                              "  v0: PARAM i32\n"
+                              "  v1: CONST i32 -7\n"
+                              "  v2: LE i1 v0 v1\n"
+                              "  %3: IF none v2 T:bb1 F:bb2\n"
+                              "\n"
+                              "bb1:\n"
+                              "  v3: CAST i64 v0\n"
+                              "  %5: NEG i32 v1\n"
+                              "  g: GOTO none bb2\n"
+                              "\n"
+                              "bb2:\n"
+                              "  v5: PHI i32 bb0 v1, bb1 %5\n"
+                              "  v6: CONST i1 1\n"
+                              "  %9: CALL i32 @f v5 v3\n"
+                              "  r: RET i32 %9\n"
+                              "\n"};
+  ASSERT_EQ(toString(function), expected);
+
+  std::stringstream stream;
+  function.dump(stream);
+  ASSERT_EQ(stream.str(), expected);
+}
+
+TEST(Printer, Integers) {
+  std::string out;
+  {
+    PrintBuffer buf{out};
+    buf << std::numeric_limits<std::int64_t>::min() << ' '
+        << std::numeric_limits<std::uint64_t>::max() << ' '
+        << std::int8_t{-128} << ' ' << 0;
+  }
+  ASSERT_EQ(out, "-9223372036854775808 18446744073709551615 -128 0");
+}
+
+TEST(Printer, FileDescriptor) {
+  auto *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  auto fd = fileno(file);
+
+  std::string expected;
+  {
+    PrintBuffer buf{fd, PrintBuffer::kBulkReserve};
+    for (int i = 0; i < 100000; ++i) {
+      buf << "line " << i << '\n';
+      expected += "line " + std::to_string(i) + '\n';
+    }
+  }
+
+  std::string actual(expected.size(), '\0');
+  ASSERT_EQ(::pread(fd, actual.data(), actual.size(), 0), actual.size());
+  ASSERT_EQ(actual, expected);
+  std::fclose(file);
+}
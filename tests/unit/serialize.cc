@@ -0,0 +1,112 @@
+#include "serialize.hh"
+#include "IR.hh"
+#include "function.hh"
+#include "printer.hh"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+using namespace jade;
+
+namespace {
+
+void buildFunction(Function &function) {
+  auto *bb0 = function.create<BasicBlock>();
+  auto *bb1 = function.create<BasicBlock>();
+  auto *bb2 = function.create<BasicBlock>();
+  auto *bb3 = function.create<BasicBlock>();
+
+  auto *n = bb0->create<ParamInstr>(Type::create<Type::I32>(), "n");
+  auto *zero = bb0->create<ConstI32>(0, "zero");
+  auto *one = bb0->create<ConstI32>(1);
+  bb0->create<ConstI64>(-1234567890123, "big");
+  bb0->create<ConstI16>(-300, "c16");
+  bb0->create<ConstI8>(-5, "c8");
+  bb0->create<ConstI1>(true, "flag");
+  bb0->create<GotoInstr>(bb1);
+
+  auto *i = bb1->create<PhiInstr>(Type::create<Type::I32>(), "i");
+  auto *cond = bb1->create<CmpInstr>(i, n, Opcode::LE, "cond");
+  bb1->create<IfInstr>(cond, bb3, bb2);
+
+  auto *next = bb2->create<BinaryOp>(i, one, Opcode::ADD, "next");
+  auto *zc = bb2->create<UnaryOp>(next, Opcode::ZeroCheck);
+  auto *wide = bb2->create<CastInstr>(zc, Type::create<Type::I64>(), "wide");
+  // a standalone record has no function table to name a callee in
+  auto *call = bb2->create<CallInstr>(nullptr, Type::create<Type::I32>());
+  call->addArg(wide);
+  call->addArg(next);
+  bb2->create<GotoInstr>(bb1);
+
+  i->addOption(zero, bb0);
+  i->addOption(next, bb2);
+  bb3->create<RetInstr>(i);
+}
+
+} // namespace
+
+TEST(Serialize, RoundTrip) {
+  auto function = Function{};
+  buildFunction(function);
+
+  std::string data;
+  writeBinary(function, data);
+  auto loaded = readBinary(data);
+  ASSERT_NE(loaded, nullptr);
+
+  auto copy = function.copy();
+  ASSERT_EQ(toString(*loaded), toString(*copy));
+  ASSERT_EQ(toString(*loaded), toString(function));
+
+  // CFG and phis are rebuilt
+  auto *bb1 = loaded->begin()->next();
+  ASSERT_EQ(bb1->collectPredecessors().size(), 2);
+  ASSERT_EQ(bb1->collectSuccessors().size(), 2);
+  auto *phi = *bb1->phis().begin();
+  ASSERT_EQ(phi->numUsers(), 3);
+
+  // reencoding gives the same bytes
+  std::string again;
+  writeBinary(*loaded, again);
+  ASSERT_EQ(again, data);
+}
+
+TEST(Serialize, Malformed) {
+  auto function = Function{};
+  buildFunction(function);
+  std::string data;
+  writeBinary(function, data);
+
+  DecodeError error;
+  for (std::size_t size = 0; size < data.size(); ++size) {
+    ASSERT_EQ(readBinary(std::string_view{data}.substr(0, size), &error),
+              nullptr);
+  }
+
+  auto bad = data;
+  bad[0] = 'X';
+  ASSERT_EQ(readBinary(bad, &error), nullptr);
+  ASSERT_EQ(error.message, "not a jade binary");
+
+  bad = data;
+  bad[4] = kBinaryVersion + 1;
+  ASSERT_EQ(readBinary(bad, &error), nullptr);
+  ASSERT_EQ(error.message, "unsupported version 2");
+}
+
+TEST(Serialize, File) {
+  auto function = Function{};
+  buildFunction(function);
+
+  char path[] = "/tmp/jadeBinaryXXXXXX";
+  int fd = ::mkstemp(path);
+  ASSERT_GE(fd, 0);
+  ::close(fd);
+
+  ASSERT_TRUE(writeBinaryFile(function, path));
+  auto loaded = readBinaryFile(path);
+  ::unlink(path);
+  ASSERT_NE(loaded, nullptr);
+  ASSERT_EQ(toString(*loaded), toString(*function.copy()));
+}
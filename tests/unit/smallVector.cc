@@ -0,0 +1,175 @@
+#include "smallPtrSet.hh"
+#include "smallVector.hh"
+#include "IR.hh"
+#include "function.hh"
+#include "gtest/gtest.h"
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace jade;
+
+namespace {
+
+// move-only and counts live objects
+struct Tracked {
+  static inline int alive = 0;
+
+  explicit Tracked(int v) : val{std::make_unique<int>(v)} { ++alive; }
+  Tracked(Tracked &&other) noexcept : val{std::move(other.val)} { ++alive; }
+  Tracked &operator=(Tracked &&other) noexcept {
+    val = std::move(other.val);
+    return *this;
+  }
+  ~Tracked() { --alive; }
+
+  std::unique_ptr<int> val;
+};
+
+std::vector<int> values(const SmallVector<Tracked, 2> &vec) {
+  std::vector<int> ret;
+  for (auto &&elem : vec) {
+    ret.push_back(*elem.val);
+  }
+  return ret;
+}
+
+} // namespace
+
+TEST(SmallVector, Basic) {
+  SmallVector<int, 4> vec;
+  EXPECT_TRUE(vec.empty());
+  EXPECT_TRUE(vec.isSmall());
+  for (int i = 0; i < 4; ++i) {
+    vec.push_back(i);
+  }
+  EXPECT_TRUE(vec.isSmall());
+  vec.push_back(vec[0]);
+  EXPECT_FALSE(vec.isSmall());
+  EXPECT_EQ(vec, (SmallVector<int, 4>{0, 1, 2, 3, 0}));
+
+  vec.erase(vec.begin() + 1, vec.begin() + 3);
+  EXPECT_EQ(vec, (SmallVector<int, 4>{0, 3, 0}));
+  vec.insert(vec.begin() + 1, 7);
+  EXPECT_EQ(vec, (SmallVector<int, 4>{0, 7, 3, 0}));
+  EXPECT_EQ(vec.front(), 0);
+  EXPECT_EQ(vec.back(), 0);
+  EXPECT_EQ(*vec.rbegin(), 0);
+
+  vec.resize(6, 9);
+  EXPECT_EQ(vec, (SmallVector<int, 4>{0, 7, 3, 0, 9, 9}));
+  vec.resize(1);
+  EXPECT_EQ(vec.size(), 1);
+  vec.pop_back();
+  EXPECT_TRUE(vec.empty());
+}
+
+TEST(SmallVector, MoveOnly) {
+  {
+    SmallVector<Tracked, 2> small;
+    small.emplace_back(1);
+    small.emplace_back(2);
+    SmallVector<Tracked, 2> big;
+    for (int i = 0; i < 10; ++i) {
+      big.emplace_back(i);
+    }
+    EXPECT_EQ(Tracked::alive, 12);
+
+    // inline elements are moved one by one, a heap buffer is taken over
+    auto movedSmall = std::move(small);
+    auto *data = big.data();
+    auto movedBig = std::move(big);
+    EXPECT_TRUE(small.empty());
+    EXPECT_TRUE(big.empty());
+    EXPECT_EQ(movedBig.data(), data);
+    EXPECT_EQ(values(movedSmall), (std::vector<int>{1, 2}));
+    EXPECT_EQ(movedBig.size(), 10);
+    EXPECT_EQ(Tracked::alive, 12);
+
+    movedBig.erase(movedBig.begin());
+    EXPECT_EQ(*movedBig.front().val, 1);
+    movedSmall = std::move(movedBig);
+    EXPECT_EQ(movedSmall.size(), 9);
+    EXPECT_EQ(Tracked::alive, 9);
+  }
+  EXPECT_EQ(Tracked::alive, 0);
+}
+
+// Operands move when the storage grows: use-lists must follow.
+TEST(SmallVector, Operands) {
+  auto fn = Function{};
+  auto *bb0 = fn.create<BasicBlock>();
+  auto *bb1 = fn.create<BasicBlock>();
+  auto *v0 = bb0->create<ConstI64>(1);
+  auto *v1 = bb0->create<ConstI64>(2);
+  bb0->create<GotoInstr>(bb1);
+  auto *phi = bb1->create<PhiInstr>(Type::create<Type::I64>());
+  for (int i = 0; i < 8; ++i) {
+    phi->addOption(i % 2 ? v1 : v0, bb0);
+  }
+  EXPECT_EQ(v0->numUsers(), 4);
+  EXPECT_EQ(v1->numUsers(), 4);
+  for (auto *user : v0->users()) {
+    EXPECT_EQ(user, phi);
+  }
+
+  v1->replaceUsers(v0);
+  EXPECT_EQ(v0->numUsers(), 8);
+  EXPECT_FALSE(v1->hasUsers());
+  for (std::size_t i = 0; i < phi->numInputs(); ++i) {
+    EXPECT_EQ(phi->input(i), v0);
+  }
+}
+
+TEST(SmallPtrSet, Basic) {
+  std::vector<int> objs(100);
+  SmallPtrSet<int *, 4> set;
+  EXPECT_TRUE(set.insert(&objs[0]));
+  EXPECT_TRUE(set.insert(&objs[1]));
+  EXPECT_FALSE(set.insert(&objs[0]));
+  EXPECT_TRUE(set.isSmall());
+  EXPECT_EQ(set.size(), 2);
+  EXPECT_EQ(set.erase(&objs[0]), 1);
+  EXPECT_EQ(set.erase(&objs[0]), 0);
+  EXPECT_FALSE(set.contains(&objs[0]));
+  EXPECT_TRUE(set.contains(&objs[1]));
+  EXPECT_EQ((SmallPtrSet<int *, 4>{&objs[1], &objs[2]}),
+            (SmallPtrSet<int *, 4>{&objs[2], &objs[1]}));
+
+  for (auto &obj : objs) {
+    set.insert(&obj);
+  }
+  EXPECT_FALSE(set.isSmall());
+  EXPECT_EQ(set.size(), objs.size());
+  EXPECT_NE(set, (SmallPtrSet<int *, 4>{&objs[1], &objs[0]}));
+  auto all = std::set<int *>(set.begin(), set.end());
+  EXPECT_EQ(all.size(), objs.size());
+
+  set.clear();
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(set.begin(), set.end());
+}
+
+TEST(SmallPtrSet, Random) {
+  std::vector<int> objs(1000);
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<std::size_t> dist(0, objs.size() - 1);
+
+  SmallPtrSet<int *, 8> set;
+  std::set<int *> expected;
+  // erasing as often as inserting leaves many tombstones behind
+  for (int i = 0; i < 20000; ++i) {
+    auto *ptr = &objs[dist(gen)];
+    if (gen() % 2) {
+      EXPECT_EQ(set.insert(ptr), expected.insert(ptr).second);
+    } else {
+      EXPECT_EQ(set.erase(ptr), expected.erase(ptr));
+    }
+    ASSERT_EQ(set.size(), expected.size());
+  }
+  EXPECT_EQ(std::set<int *>(set.begin(), set.end()), expected);
+  for (auto &obj : objs) {
+    EXPECT_EQ(set.count(&obj), expected.count(&obj));
+  }
+}
@@ -207,3 +207,86 @@ TEST(RPO, example1) {
   ASSERT_EQ(*(++po), bbs[2]);
   ASSERT_EQ((++po), RPOIterator<BasicBlocksGraph>::end(graph));
 }
+
+// Deep enough to overflow the stack of a recursive walk.
+TEST(Traversal, deepChain) {
+  constexpr std::size_t kDepth = 300000;
+  auto function = deepChain(kDepth);
+  auto graph = function.getBasicBlocks();
+
+  std::size_t idx = 0;
+  auto dfs = DFSIterator<BasicBlocksGraph>::begin(graph);
+  for (auto end = DFSIterator<BasicBlocksGraph>::end(graph); dfs != end;
+       ++dfs, ++idx) {
+    ASSERT_EQ((*dfs)->getId(), idx);
+  }
+  EXPECT_EQ(idx, kDepth);
+
+  auto po = PostOrderIterator<BasicBlocksGraph>::collect(graph);
+  ASSERT_EQ(po.size(), kDepth);
+  EXPECT_EQ(po.front()->getId(), kDepth - 1);
+  EXPECT_EQ(po.back()->getId(), 0);
+
+  idx = 0;
+  auto rpo = RPOIterator<BasicBlocksGraph>::begin(graph);
+  for (auto end = RPOIterator<BasicBlocksGraph>::end(graph); rpo != end;
+       ++rpo, ++idx) {
+    ASSERT_EQ((*rpo)->getId(), idx);
+  }
+  EXPECT_EQ(idx, kDepth);
+}
+
+TEST(Dfs, compare) {
+  auto function = example2();
+  auto graph = function.getBasicBlocks();
+
+  auto dfs = DFSIterator<BasicBlocksGraph>::begin(graph);
+  auto copy = dfs;
+  ASSERT_EQ(dfs, copy);
+  ++dfs;
+  ASSERT_NE(dfs, copy);
+  ++copy;
+  ASSERT_EQ(dfs, copy);
+  ASSERT_NE(dfs, DFSIterator<BasicBlocksGraph>::end(graph));
+}
+
+TEST(CachedOrder, example1) {
+  auto function = example1();
+  auto graph = function.getBasicBlocks();
+  auto range = graph.nodes();
+
+  std::vector<BasicBlock *> bbs;
+  for (auto it = range.begin(); it != range.end(); ++it) {
+    bbs.push_back(&*it);
+  }
+
+  auto epoch = function.getCFGEpoch();
+  auto &rpo = function.rpo();
+  EXPECT_EQ(rpo, (std::vector{bbs[0], bbs[1], bbs[3], bbs[2]}));
+  EXPECT_EQ(function.postOrder(),
+            (std::vector{bbs[2], bbs[3], bbs[1], bbs[0]}));
+  // nothing changed: the same order, not recomputed
+  EXPECT_EQ(&function.rpo(), &rpo);
+  EXPECT_EQ(rpo.data(), function.rpo().data());
+  EXPECT_EQ(function.getCFGEpoch(), epoch);
+
+  auto *bb4 = function.create<BasicBlock>();
+  EXPECT_NE(function.getCFGEpoch(), epoch);
+  EXPECT_EQ(function.rpo().size(), 4);
+
+  epoch = function.getCFGEpoch();
+  bbs[2]->addSuccessor(bb4);
+  EXPECT_NE(function.getCFGEpoch(), epoch);
+  EXPECT_EQ(function.rpo(), (std::vector{bbs[0], bbs[1], bbs[3], bbs[2], bb4}));
+
+  epoch = function.getCFGEpoch();
+  bbs[1]->inverseCondition();
+  EXPECT_NE(function.getCFGEpoch(), epoch);
+  EXPECT_EQ(function.rpo(), (std::vector{bbs[0], bbs[1], bbs[2], bb4, bbs[3]}));
+
+  epoch = function.getCFGEpoch();
+  bbs[2]->removeSuccessor(bb4);
+  function.remove(bb4);
+  EXPECT_NE(function.getCFGEpoch(), epoch);
+  EXPECT_EQ(function.rpo().size(), 4);
+}
@@ -0,0 +1,129 @@
+#include "IR.hh"
+#include "function.hh"
+#include "gtest/gtest.h"
+#include <set>
+#include <vector>
+
+using namespace jade;
+
+TEST(UseList, Users) {
+  auto function = Function{};
+  auto *bb0 = function.create<BasicBlock>();
+
+  auto *v0 = bb0->create<ConstI64>(1, "v0");
+  auto *v1 = bb0->create<ConstI64>(2, "v1");
+  auto *v2 = bb0->create<BinaryOp>(v0, v1, Opcode::ADD, "v2");
+  auto *v3 = bb0->create<BinaryOp>(v0, v0, Opcode::MUL, "v3");
+
+  ASSERT_EQ(v0->numUsers(), 3);
+  ASSERT_EQ(v1->numUsers(), 1);
+  ASSERT_FALSE(v2->hasUsers());
+
+  auto users = std::multiset<Instruction *>{};
+  for (auto *user : v0->users()) {
+    users.insert(user);
+  }
+  ASSERT_EQ(users, (std::multiset<Instruction *>{v2, v3, v3}));
+
+  bb0->remove(v3);
+  ASSERT_EQ(v0->numUsers(), 1);
+  ASSERT_EQ(*v0->usersBegin(), v2);
+}
+
+TEST(UseList, ReplaceUsers) {
+  auto function = Function{};
+  auto *bb0 = function.create<BasicBlock>();
+
+  auto *v0 = bb0->create<ConstI64>(1, "v0");
+  auto *v1 = bb0->create<ConstI64>(2, "v1");
+  auto *v2 = bb0->create<BinaryOp>(v0, v0, Opcode::ADD, "v2");
+  auto *ret = bb0->create<RetInstr>(v0);
+
+  replaceUsers(v0, v1);
+
+  ASSERT_FALSE(v0->hasUsers());
+  ASSERT_EQ(v1->numUsers(), 3);
+  ASSERT_EQ(v2->input(0), v1);
+  ASSERT_EQ(v2->input(1), v1);
+  ASSERT_EQ(ret->getVal(), v1);
+}
+
+TEST(UseList, PhiOptions) {
+  auto function = Function{};
+  auto *bb0 = function.create<BasicBlock>();
+  auto *bb1 = function.create<BasicBlock>();
+  auto *bb2 = function.create<BasicBlock>();
+
+  auto *v0 = bb0->create<ConstI32>(1, "v0");
+  bb0->create<GotoInstr>(bb2);
+  auto *v1 = bb1->create<ConstI32>(2, "v1");
+  bb1->create<GotoInstr>(bb2);
+  auto *phi = bb2->create<PhiInstr>(Type::create<Type::I32>(), "v2");
+  phi->addOption(v0, bb0);
+  phi->addOption(v1, bb1);
+
+  ASSERT_EQ(*v0->usersBegin(), phi);
+  ASSERT_EQ(*v1->usersBegin(), phi);
+
+  replaceUsers(v1, v0);
+  ASSERT_EQ(phi->getOption(1).first, bb1);
+  ASSERT_EQ(phi->getOption(1).second, v0);
+  ASSERT_EQ(v0->numUsers(), 2);
+}
+
+TEST(UseList, OperandsRealloc) {
+  auto function = Function{};
+  auto *bb0 = function.create<BasicBlock>();
+
+  std::vector<Instruction *> args;
+  for (std::int64_t i = 0; i < 64; ++i) {
+    args.push_back(bb0->create<ConstI64>(i));
+  }
+
+  auto *call =
+      bb0->create<CallInstr>(&function, Type::create<Type::I64>(), "call");
+  for (auto *arg : args) {
+    call->addArg(arg);
+  }
+
+  for (auto *arg : args) {
+    ASSERT_EQ(arg->numUsers(), 1);
+    ASSERT_EQ(*arg->usersBegin(), call);
+  }
+
+  replaceUsers(args[0], args[1]);
+  ASSERT_EQ(call->input(0), args[1]);
+  ASSERT_EQ(args[1]->numUsers(), 2);
+}
+
+TEST(UseList, OperandIterator) {
+  auto function = Function{};
+  auto *bb0 = function.create<BasicBlock>();
+
+  auto *v0 = bb0->create<ConstI64>(1, "v0");
+  auto *v1 = bb0->create<ConstI64>(2, "v1");
+  auto *v2 = bb0->create<BinaryOp>(v0, v1, Opcode::ADD, "v2");
+
+  auto first = v2->begin();
+  auto last = v2->end();
+  ASSERT_EQ(last - first, 2);
+  ASSERT_EQ(first[0], v0);
+  ASSERT_EQ(first[1], v1);
+  ASSERT_EQ(*std::next(first), v1);
+  ASSERT_EQ(*std::prev(last), v1);
+  ASSERT_EQ(*(last - 2), v0);
+  ASSERT_EQ(1 + first, std::prev(last));
+  ASSERT_TRUE(first < last);
+  ASSERT_TRUE(last >= first);
+
+  auto it = first;
+  std::advance(it, 2);
+  ASSERT_EQ(it, last);
+  it -= 1;
+  ASSERT_EQ(*it--, v1);
+  ASSERT_EQ(it, first);
+
+  auto reversed = std::vector<Instruction *>(std::make_reverse_iterator(last),
+                                             std::make_reverse_iterator(first));
+  ASSERT_EQ(reversed, (std::vector<Instruction *>{v1, v0}));
+}
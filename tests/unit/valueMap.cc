@@ -0,0 +1,60 @@
+#include "valueMap.hh"
+#include "IR.hh"
+#include "function.hh"
+#include "gtest/gtest.h"
+#include <set>
+
+using namespace jade;
+
+TEST(ValueMap, FunctionWideIds) {
+  auto function = Function{};
+  auto *bb0 = function.create<BasicBlock>();
+  auto *bb1 = function.create<BasicBlock>();
+
+  auto *v0 = bb0->create<ConstI64>(1, "v0");
+  auto *v1 = bb0->create<ConstI64>(2, "v1");
+  bb0->create<GotoInstr>(bb1);
+  auto *v2 = bb1->create<BinaryOp>(v0, v1, Opcode::ADD, "v2");
+  bb1->create<RetInstr>(v2);
+
+  auto ids = std::set<std::size_t>{};
+  for (auto &&bb : function.getBasicBlocks().nodes()) {
+    for (auto &&instr : bb) {
+      ASSERT_LT(instr.getId(), function.numValues());
+      ids.insert(instr.getId());
+    }
+  }
+  ASSERT_EQ(ids.size(), 5);
+  ASSERT_EQ(function.numBlocks(), 2);
+
+  auto map = ValueMap<std::size_t>(function.numValues());
+  map[v0] = 10;
+  map[v2] = 30;
+  ASSERT_EQ(map.at(v0), 10);
+  ASSERT_EQ(map.at(v1), 0);
+  ASSERT_EQ(map.at(v2), 30);
+
+  auto blocks = BlockMap<int>(function.numBlocks(), -1);
+  blocks[bb1] = 1;
+  ASSERT_EQ(blocks.at(bb0), -1);
+  ASSERT_EQ(blocks.at(bb1), 1);
+}
+
+TEST(ValueMap, Renumber) {
+  auto function = Function{};
+  auto *bb0 = function.create<BasicBlock>();
+
+  auto *v0 = bb0->create<ConstI64>(1, "v0");
+  auto *v1 = bb0->create<ConstI64>(2, "v1");
+  auto *v2 = bb0->create<BinaryOp>(v0, v1, Opcode::ADD, "v2");
+  auto *ret = bb0->create<RetInstr>(v2);
+
+  bb0->remove(v1);
+  ASSERT_EQ(function.numValues(), 4);
+
+  function.renumber();
+  ASSERT_EQ(function.numValues(), 3);
+  ASSERT_EQ(v0->getId(), 0);
+  ASSERT_EQ(v2->getId(), 1);
+  ASSERT_EQ(ret->getId(), 2);
+}